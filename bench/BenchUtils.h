@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Small helpers shared by the benchmark executables in this directory.
+// Run with VK_ICD_FILENAMES pointing at lvp_icd.*.json to benchmark on lavapipe.
+namespace bench
+{
+	using Clock = std::chrono::steady_clock;
+
+	inline double elapsedMicroseconds(Clock::time_point Start, Clock::time_point End)
+	{
+		return std::chrono::duration<double, std::micro>(End - Start).count();
+	}
+
+	// Returns the value following "--Name" on the command line, or Default
+	inline uint64_t argValue(int Argc, char** Argv, const char* Name, uint64_t Default)
+	{
+		for (int I = 1; I + 1 < Argc; ++I)
+		{
+			if (std::strncmp(Argv[I], "--", 2) == 0 && std::strcmp(Argv[I] + 2, Name) == 0)
+			{
+				return std::strtoull(Argv[I + 1], nullptr, 10);
+			}
+		}
+		return Default;
+	}
+
+	// Same for a string option
+	inline std::string argString(int Argc, char** Argv, const char* Name, const std::string& Default)
+	{
+		for (int I = 1; I + 1 < Argc; ++I)
+		{
+			if (std::strncmp(Argv[I], "--", 2) == 0 && std::strcmp(Argv[I] + 2, Name) == 0)
+			{
+				return Argv[I + 1];
+			}
+		}
+		return Default;
+	}
+
+	struct LatencyStats
+	{
+		double Mean = 0.0;
+		double P50 = 0.0;
+		double P99 = 0.0;
+		double Min = 0.0;
+	};
+
+	inline LatencyStats summarize(std::vector<double> Samples)
+	{
+		LatencyStats Stats;
+		if (Samples.empty())
+		{
+			return Stats;
+		}
+		std::sort(Samples.begin(), Samples.end());
+		for (double Sample : Samples)
+		{
+			Stats.Mean += Sample;
+		}
+		Stats.Mean /= Samples.size();
+		Stats.P50 = Samples[Samples.size() / 2];
+		Stats.P99 = Samples[std::min(Samples.size() - 1, Samples.size() * 99 / 100)];
+		Stats.Min = Samples.front();
+		return Stats;
+	}
+}
@@ -0,0 +1,91 @@
+// Add kernel throughput with host-visible buffers (CPU_TO_GPU inputs, GPU_TO_CPU output, the
+// old default) against device-local buffers, for 1M to 1B elements. Sizes that do not fit in
+// memory are skipped.
+// Usage: BufferPlacementBench [--max-elements N] [--iterations N] [--device N]
+#include <iostream>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "Kernels.h"
+
+namespace
+{
+	struct Placement
+	{
+		const char* Name;
+		VmaMemoryUsage InputUsage;
+		VmaMemoryUsage OutputUsage;
+	};
+
+	// GB/s of one add dispatch, or a negative value when the buffers could not be allocated
+	double measureAdd(ComputeContext& Context, const ComputeKernel& Add, const Placement& Where, uint64_t NumElements, uint32_t Iterations)
+	{
+		const vk::DeviceSize BufferSize = NumElements * sizeof(uint32_t);
+		ComputeBuffer Buffers[3];
+		double Throughput = -1.0;
+		try
+		{
+			Buffers[0] = Context.createBuffer(BufferSize, Where.InputUsage);
+			Buffers[1] = Context.createBuffer(BufferSize, Where.InputUsage);
+			Buffers[2] = Context.createBuffer(BufferSize, Where.OutputUsage);
+
+			ComputeJob Job;
+			Job.Kernel = &Add;
+			Job.Buffers = { &Buffers[0], &Buffers[1], &Buffers[2] };
+			Job.ElementCount = NumElements;
+			Job.ElementSize = sizeof(uint32_t);
+			Context.timeJob(Job, 1);
+			const double Nanoseconds = Context.timeJob(Job, Iterations);
+			// Two loads and one store per element
+			Throughput = 3.0 * BufferSize / Nanoseconds;
+		}
+		catch (const std::exception& Exception)
+		{
+			std::cout << "  " << Where.Name << " " << NumElements << " skipped: " << Exception.what() << std::endl;
+		}
+		for (ComputeBuffer& Buffer : Buffers)
+		{
+			Context.destroyBuffer(Buffer);
+		}
+		return Throughput;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint64_t MaxElements = bench::argValue(Argc, Argv, "max-elements", 1'000'000'000);
+		const uint32_t Iterations = static_cast<uint32_t>(bench::argValue(Argc, Argv, "iterations", 10));
+		ContextOptions Options;
+		Options.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(Options);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		const ComputeKernel& Add = Context.createKernel(kernels::add());
+
+		const Placement Placements[] = {
+			{ "host-visible", VMA_MEMORY_USAGE_CPU_TO_GPU, VMA_MEMORY_USAGE_GPU_TO_CPU },
+			{ "device-local", VMA_MEMORY_USAGE_GPU_ONLY, VMA_MEMORY_USAGE_GPU_ONLY }
+		};
+		for (uint64_t NumElements = 1'000'000; NumElements <= MaxElements; NumElements *= 10)
+		{
+			std::cout << NumElements << " elements:";
+			for (const Placement& Where : Placements)
+			{
+				const double Throughput = measureAdd(Context, Add, Where, NumElements, Iterations);
+				if (Throughput >= 0.0)
+				{
+					std::cout << " " << Where.Name << " " << Throughput << " GB/s";
+				}
+			}
+			std::cout << std::endl;
+		}
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,175 @@
+// Stream compaction with Compactor, stable and unordered, against reading the buffer back and
+// filtering on the host, for a few predicates and selectivities. Also chains two filters through
+// the indirect args so that the second one never waits for the host. Results are checked.
+// Usage: CompactBench [--elements N] [--iterations N] [--device N]
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "Compactor.h"
+#include "ComputeContext.h"
+
+namespace
+{
+	using kernels::CompareOp;
+
+	struct Case
+	{
+		const char* Name;
+		CompactFilter Filter;
+		std::function<bool(uint32_t)> Keep;
+	};
+
+	float asFloat(uint32_t Bits)
+	{
+		float Value;
+		std::memcpy(&Value, &Bits, sizeof(Value));
+		return Value;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint64_t NumElements = bench::argValue(Argc, Argv, "elements", 32 * 1024 * 1024 + 9);
+		const uint32_t Iterations = static_cast<uint32_t>(bench::argValue(Argc, Argv, "iterations", 10));
+		ContextOptions Options;
+		Options.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(Options);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		std::cout << "Elements       : " << NumElements << std::endl;
+		Compactor Compact(Context);
+
+		// Hashes for the integer cases, floats in [-1, 1) for the float one
+		std::vector<uint32_t> Data(NumElements);
+		std::vector<float> Floats(NumElements);
+		for (uint64_t I = 0; I < NumElements; ++I)
+		{
+			Data[I] = static_cast<uint32_t>(I * 2654435761u);
+			Floats[I] = float(Data[I] >> 8) / float(1 << 24) * 2.0f - 1.0f;
+		}
+		const vk::DeviceSize BufferSize = NumElements * sizeof(uint32_t);
+		ComputeBuffer Input = Context.createBuffer(BufferSize);
+		ComputeBuffer FloatInput = Context.createBuffer(BufferSize);
+		ComputeBuffer Output = Context.createBuffer(BufferSize);
+		ComputeBuffer Middle = Context.createBuffer(BufferSize);
+		ComputeBuffer MiddleArgs = Context.createBuffer(CompactArgsSize);
+		ComputeBuffer Args = Context.createBuffer(CompactArgsSize);
+		Context.writeBuffer(Input, Data.data(), BufferSize);
+		Context.writeBuffer(FloatInput, Floats.data(), BufferSize);
+
+		const std::vector<Case> Cases = {
+			{ "greater 1%", CompactFilter::compare(CompareOp::Greater, UINT32_MAX / 100 * 99), [](uint32_t X) { return X > UINT32_MAX / 100 * 99; } },
+			{ "greater 50%", CompactFilter::compare(CompareOp::Greater, UINT32_MAX / 2), [](uint32_t X) { return X > UINT32_MAX / 2; } },
+			{ "bitmask 1%", CompactFilter::bitmask(0x7F, 0x7F), [](uint32_t X) { return (X & 0x7F) == 0x7F; } },
+			{ "non-zero", CompactFilter::nonZero<uint32_t>(), [](uint32_t X) { return X != 0; } },
+			{ "f32 range", CompactFilter::range(-0.25f, 0.25f), [](uint32_t X) { return asFloat(X) >= -0.25f && asFloat(X) <= 0.25f; } }
+		};
+		std::vector<uint32_t> Result(NumElements);
+		std::vector<uint32_t> ReadBack(NumElements);
+		for (const Case& Test : Cases)
+		{
+			const bool bFloat = Test.Filter.Type == kernels::ElementType::Float;
+			const ComputeBuffer& Source = bFloat ? FloatInput : Input;
+			std::vector<uint32_t> Bits(NumElements);
+			std::memcpy(Bits.data(), bFloat ? static_cast<const void*>(Floats.data()) : Data.data(), BufferSize);
+			std::vector<uint32_t> Expected;
+			std::copy_if(Bits.begin(), Bits.end(), std::back_inserter(Expected), Test.Keep);
+
+			for (CompactOrder Order : { CompactOrder::Stable, CompactOrder::Unordered })
+			{
+				CompactOptions CompactOpts;
+				CompactOpts.Order = Order;
+				const char* OrderName = Order == CompactOrder::Stable ? "stable" : "unordered";
+				const uint32_t Count = Compact.compact(Source, NumElements, Output, Test.Filter, CompactOpts);
+				Result.resize(Count);
+				if (Count != 0)
+				{
+					Context.readBuffer(Output, Result.data(), Count * sizeof(uint32_t));
+				}
+				if (Order == CompactOrder::Unordered)
+				{
+					// Only the order inside a tile is kept, compare as sets
+					std::sort(Result.begin(), Result.end());
+				}
+				std::vector<uint32_t> Reference = Expected;
+				if (Order == CompactOrder::Unordered)
+				{
+					std::sort(Reference.begin(), Reference.end());
+				}
+				if (Result != Reference)
+				{
+					throw std::runtime_error(std::string(Test.Name) + " " + OrderName + " compaction differs from the host");
+				}
+
+				std::vector<double> Samples;
+				for (uint32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+				{
+					const auto Start = bench::Clock::now();
+					Compact.compact(Source, NumElements, Output, Test.Filter, CompactOpts);
+					Samples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+				}
+				const double Microseconds = bench::summarize(Samples).P50;
+				std::cout << Test.Name << " " << OrderName << " : " << Microseconds << " us, " << BufferSize / Microseconds * 1e-3
+						  << " GB/s, kept " << Count << std::endl;
+			}
+
+			std::vector<double> HostSamples;
+			for (uint32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				const auto Start = bench::Clock::now();
+				Context.readBuffer(Source, ReadBack.data(), BufferSize);
+				std::vector<uint32_t> Kept;
+				std::copy_if(ReadBack.begin(), ReadBack.end(), std::back_inserter(Kept), Test.Keep);
+				HostSamples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+			}
+			std::cout << Test.Name << " readback + host : " << bench::summarize(HostSamples).P50 << " us" << std::endl;
+		}
+
+		// Two filters in a row, the second dispatched from the args of the first
+		CompactOptions Unordered;
+		Unordered.Order = CompactOrder::Unordered;
+		const CompactFilter First = CompactFilter::compare(CompareOp::Less, UINT32_MAX / 4);
+		const CompactFilter Second = CompactFilter::bitmask(1, 1);
+		const uint64_t Expected = std::count_if(Data.begin(), Data.end(), [](uint32_t X) { return X < UINT32_MAX / 4 && (X & 1) != 0; });
+		std::vector<double> Samples;
+		uint32_t Count = 0;
+		for (uint32_t Iteration = 0; Iteration <= Iterations; ++Iteration)
+		{
+			const auto Start = bench::Clock::now();
+			const JobTicket Filtered = Compact.compactAsync(Input, NumElements, Middle, MiddleArgs, First, Unordered);
+			Compact.compactIndirectAsync(Middle, MiddleArgs, NumElements, Output, Args, Second, Unordered, { Filtered });
+			Context.readBuffer(Args, &Count, sizeof(Count), CompactCountOffset);
+			if (Iteration > 0)
+			{
+				Samples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+			}
+		}
+		if (Count != Expected)
+		{
+			throw std::runtime_error("chained indirect compaction kept " + std::to_string(Count) + " instead of " + std::to_string(Expected));
+		}
+		std::cout << "chained indirect : " << bench::summarize(Samples).P50 << " us, kept " << Count << std::endl;
+
+		Context.destroyBuffer(Input);
+		Context.destroyBuffer(FloatInput);
+		Context.destroyBuffer(Output);
+		Context.destroyBuffer(Middle);
+		Context.destroyBuffer(MiddleArgs);
+		Context.destroyBuffer(Args);
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
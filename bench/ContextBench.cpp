@@ -0,0 +1,164 @@
+// Per-job latency of the add kernel (shaders/compute.comp):
+//   cold : every job brings up and tears down its own ComputeContext
+//   warm : all jobs share one long-lived ComputeContext
+//   async: jobs are queued with submitAsync, up to --in-flight of them at once
+// Usage: ContextBench [--jobs N] [--elements N] [--in-flight N] [--device N]
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "Kernels.h"
+
+namespace
+{
+	struct AddJob
+	{
+		ComputeBuffer Buffers[3];
+		ComputeJob Job;
+	};
+
+	// Fills Add in place, Job.Buffers points into Add.Buffers
+	void createAddJob(ComputeContext& Context, uint64_t NumElements, AddJob& Add)
+	{
+		const vk::DeviceSize BufferSize = NumElements * sizeof(uint32_t);
+		for (ComputeBuffer& Buffer : Add.Buffers)
+		{
+			Buffer = Context.createBuffer(BufferSize);
+		}
+		Add.Job.Kernel = &Context.createKernel(kernels::add());
+		Add.Job.Buffers = { &Add.Buffers[0], &Add.Buffers[1], &Add.Buffers[2] };
+		Add.Job.ElementCount = NumElements;
+	}
+
+	void setAddTransfers(AddJob& Add, const std::vector<uint32_t>& DataA, const std::vector<uint32_t>& DataB, std::vector<uint32_t>& DataC)
+	{
+		const vk::DeviceSize BufferSize = DataA.size() * sizeof(uint32_t);
+		Add.Job.Uploads = { { &Add.Buffers[0], DataA.data(), BufferSize }, { &Add.Buffers[1], DataB.data(), BufferSize } };
+		Add.Job.Downloads = { { &Add.Buffers[2], DataC.data(), BufferSize } };
+	}
+
+	void runAddJob(ComputeContext& Context, AddJob& Add, const std::vector<uint32_t>& DataA, const std::vector<uint32_t>& DataB, std::vector<uint32_t>& DataC)
+	{
+		setAddTransfers(Add, DataA, DataB, DataC);
+		Context.submit(Add.Job);
+	}
+
+	void destroyAddJob(ComputeContext& Context, AddJob& Add)
+	{
+		for (ComputeBuffer& Buffer : Add.Buffers)
+		{
+			Context.destroyBuffer(Buffer);
+		}
+	}
+
+	void report(const char* Mode, const std::vector<double>& Samples)
+	{
+		const bench::LatencyStats Stats = bench::summarize(Samples);
+		std::cout << Mode << " : mean " << Stats.Mean << " us, p50 " << Stats.P50
+				  << " us, p99 " << Stats.P99 << " us, min " << Stats.Min << " us" << std::endl;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint64_t NumJobs = bench::argValue(Argc, Argv, "jobs", 200);
+		const uint64_t NumElements = bench::argValue(Argc, Argv, "elements", 1024);
+		const uint64_t NumInFlight = std::max<uint64_t>(bench::argValue(Argc, Argv, "in-flight", 8), 1);
+		ContextOptions Options;
+		Options.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		std::vector<uint32_t> DataA(NumElements, 3);
+		std::vector<uint32_t> DataB(NumElements, 5);
+		std::vector<uint32_t> DataC(NumElements, 0);
+
+		std::vector<double> ColdSamples;
+		// Cold jobs are orders of magnitude slower, cap them so the benchmark finishes
+		const uint64_t NumColdJobs = std::min<uint64_t>(NumJobs, 20);
+		for (uint64_t JobIndex = 0; JobIndex < NumColdJobs; ++JobIndex)
+		{
+			const auto Start = bench::Clock::now();
+			{
+				ComputeContext Context(Options);
+				AddJob Add;
+				createAddJob(Context, NumElements, Add);
+				runAddJob(Context, Add, DataA, DataB, DataC);
+				destroyAddJob(Context, Add);
+			}
+			ColdSamples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+		}
+
+		std::vector<double> WarmSamples;
+		{
+			ComputeContext Context(Options);
+			std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+			AddJob Add;
+			createAddJob(Context, NumElements, Add);
+			// One untimed job so lazily initialized driver state is not attributed to the first sample
+			runAddJob(Context, Add, DataA, DataB, DataC);
+			for (uint64_t JobIndex = 0; JobIndex < NumJobs; ++JobIndex)
+			{
+				const auto Start = bench::Clock::now();
+				runAddJob(Context, Add, DataA, DataB, DataC);
+				WarmSamples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+			}
+			destroyAddJob(Context, Add);
+		}
+
+		// Each slot owns its buffers and result, a slot is reused once its previous job finished
+		double AsyncMicroseconds = 0.0;
+		{
+			Options.MaxJobsInFlight = static_cast<uint32_t>(NumInFlight);
+			ComputeContext Context(Options);
+			std::vector<AddJob> Slots(NumInFlight);
+			std::vector<std::vector<uint32_t>> SlotResults(NumInFlight, std::vector<uint32_t>(NumElements, 0));
+			std::vector<JobTicket> Tickets(NumInFlight);
+			for (uint64_t Slot = 0; Slot < NumInFlight; ++Slot)
+			{
+				createAddJob(Context, NumElements, Slots[Slot]);
+				setAddTransfers(Slots[Slot], DataA, DataB, SlotResults[Slot]);
+			}
+			Context.submit(Slots[0].Job);
+
+			const auto Start = bench::Clock::now();
+			for (uint64_t JobIndex = 0; JobIndex < NumJobs; ++JobIndex)
+			{
+				const uint64_t Slot = JobIndex % NumInFlight;
+				if (Tickets[Slot].isValid())
+				{
+					Tickets[Slot].wait();
+				}
+				Tickets[Slot] = Context.submitAsync(Slots[Slot].Job);
+			}
+			Context.waitIdle();
+			AsyncMicroseconds = bench::elapsedMicroseconds(Start, bench::Clock::now());
+
+			for (uint64_t Slot = 0; Slot < NumInFlight; ++Slot)
+			{
+				if (Slot < NumJobs && SlotResults[Slot].front() != DataA.front() + DataB.front())
+				{
+					throw std::runtime_error("async add job produced a wrong result");
+				}
+				destroyAddJob(Context, Slots[Slot]);
+			}
+		}
+
+		if (DataC.front() != DataA.front() + DataB.front())
+		{
+			throw std::runtime_error("add kernel produced a wrong result");
+		}
+		std::cout << "Elements per job: " << NumElements << std::endl;
+		report("cold", ColdSamples);
+		report("warm", WarmSamples);
+		std::cout << "async : " << AsyncMicroseconds / NumJobs << " us per job with " << NumInFlight << " in flight" << std::endl;
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
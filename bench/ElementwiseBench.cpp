@@ -0,0 +1,148 @@
+// GB/s of the scalar elementwise shaders (compute.comp add, Square.hlsl square) against the
+// elementwise_vec4 family, device-local buffers, GPU time only. Every vec4 kernel is first
+// checked against the CPU on a length that is not a multiple of 4.
+// Usage: ElementwiseBench [--elements N] [--iterations N] [--device N]
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "Kernels.h"
+
+namespace
+{
+	using kernels::ElementType;
+	using kernels::ElementwiseOp;
+
+	uint32_t reference(ElementwiseOp Op, uint32_t A, uint32_t B, uint32_t C)
+	{
+		switch (Op)
+		{
+		case ElementwiseOp::Add: return A + B;
+		case ElementwiseOp::Sub: return A - B;
+		case ElementwiseOp::Mul: return A * B;
+		case ElementwiseOp::Square: return A * A;
+		case ElementwiseOp::Fma: return A * B + C;
+		case ElementwiseOp::Min: return std::min(static_cast<int32_t>(A), static_cast<int32_t>(B));
+		case ElementwiseOp::Max: return std::max(static_cast<int32_t>(A), static_cast<int32_t>(B));
+		}
+		return 0;
+	}
+
+	// Buffers touched per element: loads plus the store
+	uint32_t buffersTouched(ElementwiseOp Op)
+	{
+		switch (Op)
+		{
+		case ElementwiseOp::Square: return 2;
+		case ElementwiseOp::Fma: return 4;
+		default: return 3;
+		}
+	}
+
+	void verify(ComputeContext& Context, const ComputeKernel& Kernel, ElementwiseOp Op, uint32_t NumElements)
+	{
+		const vk::DeviceSize BufferSize = NumElements * sizeof(uint32_t);
+		std::vector<uint32_t> DataA(NumElements), DataB(NumElements), DataC(NumElements), Result(NumElements);
+		for (uint32_t I = 0; I < NumElements; ++I)
+		{
+			// Mixed signs so that the int min/max differ from their uint versions
+			DataA[I] = I * 2654435761u;
+			DataB[I] = I * 40503u + 7u;
+			DataC[I] = I;
+		}
+		ComputeBuffer Buffers[3];
+		for (ComputeBuffer& Buffer : Buffers)
+		{
+			Buffer = Context.createBuffer(BufferSize);
+		}
+		ComputeJob Job;
+		Job.Kernel = &Kernel;
+		Job.Buffers = { &Buffers[0], &Buffers[1], &Buffers[2] };
+		kernels::setVec4ElementCount(Job, NumElements);
+		Job.Uploads = { { &Buffers[0], DataA.data(), BufferSize }, { &Buffers[1], DataB.data(), BufferSize },
+						{ &Buffers[2], DataC.data(), BufferSize } };
+		Job.Downloads = { { &Buffers[2], Result.data(), BufferSize } };
+		Context.submit(Job);
+		for (ComputeBuffer& Buffer : Buffers)
+		{
+			Context.destroyBuffer(Buffer);
+		}
+		for (uint32_t I = 0; I < NumElements; ++I)
+		{
+			if (Result[I] != reference(Op, DataA[I], DataB[I], DataC[I]))
+			{
+				throw std::runtime_error(Kernel.Desc.Name + " produced a wrong result at element " + std::to_string(I));
+			}
+		}
+	}
+
+	double measure(ComputeContext& Context, ComputeJob& Job, uint32_t BuffersTouched, uint64_t NumElements, uint32_t Iterations)
+	{
+		Context.timeJob(Job, 1);
+		const double Nanoseconds = Context.timeJob(Job, Iterations);
+		return double(BuffersTouched) * NumElements * sizeof(uint32_t) / Nanoseconds;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint32_t NumElements = static_cast<uint32_t>(bench::argValue(Argc, Argv, "elements", 64 * 1024 * 1024 + 3));
+		const uint32_t Iterations = static_cast<uint32_t>(bench::argValue(Argc, Argv, "iterations", 20));
+		ContextOptions Options;
+		Options.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(Options);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		std::cout << "Elements       : " << NumElements << std::endl;
+
+		const vk::DeviceSize BufferSize = vk::DeviceSize(NumElements) * sizeof(uint32_t);
+		ComputeBuffer Buffers[3];
+		for (ComputeBuffer& Buffer : Buffers)
+		{
+			Buffer = Context.createBuffer(BufferSize);
+		}
+
+		ComputeJob ScalarAdd;
+		ScalarAdd.Kernel = &Context.createKernel(kernels::add());
+		ScalarAdd.Buffers = { &Buffers[0], &Buffers[1], &Buffers[2] };
+		ScalarAdd.ElementCount = NumElements;
+		std::cout << "scalar Add     : " << measure(Context, ScalarAdd, 3, NumElements, Iterations) << " GB/s" << std::endl;
+
+		ComputeJob ScalarSquare;
+		ScalarSquare.Kernel = &Context.createKernel(kernels::square());
+		ScalarSquare.Buffers = { &Buffers[0], &Buffers[2] };
+		ScalarSquare.ElementCount = NumElements;
+		std::cout << "scalar Square  : " << measure(Context, ScalarSquare, 2, NumElements, Iterations) << " GB/s" << std::endl;
+
+		const ElementwiseOp Ops[] = { ElementwiseOp::Add, ElementwiseOp::Sub, ElementwiseOp::Mul, ElementwiseOp::Square,
+									  ElementwiseOp::Fma, ElementwiseOp::Min, ElementwiseOp::Max };
+		for (ElementwiseOp Op : Ops)
+		{
+			const ComputeKernel& Kernel = Context.createKernel(kernels::elementwiseVec4(Op, ElementType::Int));
+			verify(Context, Kernel, Op, 4099);
+
+			ComputeJob Job;
+			Job.Kernel = &Kernel;
+			Job.Buffers = { &Buffers[0], &Buffers[1], &Buffers[2] };
+			kernels::setVec4ElementCount(Job, NumElements);
+			std::cout << Kernel.Desc.Name << " : " << measure(Context, Job, buffersTouched(Op), NumElements, Iterations) << " GB/s" << std::endl;
+		}
+
+		for (ComputeBuffer& Buffer : Buffers)
+		{
+			Context.destroyBuffer(Buffer);
+		}
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,191 @@
+// Batched complex FFTs with FourierTransformer against reading the signals back and transforming
+// them on the host, for shared-memory sizes, mixed radices, multi-pass global sizes and 2D.
+// The first signal (or plane) of every forward transform is checked against a double precision
+// host FFT, and a forward plus inverse round trip must restore the input.
+// GFLOP/s use the usual 5 N log2(N) flops per complex transform.
+// Usage: FftBench [--points N] [--iterations N] [--device N]
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "FourierTransformer.h"
+
+namespace
+{
+	using Complex = std::complex<double>;
+
+	// Recursive mixed radix decimation in time, the reference and the host baseline
+	void fftOnHost(std::vector<Complex>& X, bool bInverse)
+	{
+		const size_t N = X.size();
+		if (N == 1)
+		{
+			return;
+		}
+		const size_t Radix = N % 2 == 0 ? 2 : N % 3 == 0 ? 3 : 5;
+		const size_t M = N / Radix;
+		std::vector<std::vector<Complex>> Parts(Radix, std::vector<Complex>(M));
+		for (size_t I = 0; I < N; ++I)
+		{
+			Parts[I % Radix][I / Radix] = X[I];
+		}
+		for (std::vector<Complex>& Part : Parts)
+		{
+			fftOnHost(Part, bInverse);
+		}
+		const double Sign = bInverse ? 1.0 : -1.0;
+		for (size_t K = 0; K < N; ++K)
+		{
+			Complex Sum = 0.0;
+			for (size_t R = 0; R < Radix; ++R)
+			{
+				Sum += Parts[R][K % M] * std::polar(1.0, Sign * 2.0 * 3.14159265358979323846 * double(R * K % N) / double(N));
+			}
+			X[K] = Sum;
+		}
+	}
+
+	// Forward transform of the first SizeX * SizeY points, rows then columns
+	std::vector<Complex> planeOnHost(const std::vector<float>& Data, uint32_t SizeX, uint32_t SizeY)
+	{
+		std::vector<Complex> Plane(size_t(SizeX) * SizeY);
+		for (size_t I = 0; I < Plane.size(); ++I)
+		{
+			Plane[I] = Complex(Data[2 * I], Data[2 * I + 1]);
+		}
+		std::vector<Complex> Line(SizeX);
+		for (uint32_t Y = 0; Y < SizeY; ++Y)
+		{
+			std::copy(Plane.begin() + size_t(Y) * SizeX, Plane.begin() + size_t(Y + 1) * SizeX, Line.begin());
+			fftOnHost(Line, false);
+			std::copy(Line.begin(), Line.end(), Plane.begin() + size_t(Y) * SizeX);
+		}
+		Line.resize(SizeY);
+		for (uint32_t X = 0; X < SizeX && SizeY > 1; ++X)
+		{
+			for (uint32_t Y = 0; Y < SizeY; ++Y)
+			{
+				Line[Y] = Plane[size_t(Y) * SizeX + X];
+			}
+			fftOnHost(Line, false);
+			for (uint32_t Y = 0; Y < SizeY; ++Y)
+			{
+				Plane[size_t(Y) * SizeX + X] = Line[Y];
+			}
+		}
+		return Plane;
+	}
+
+	void run(ComputeContext& Context, FourierTransformer& Fft, const FftParams& Params, uint32_t Iterations)
+	{
+		const size_t NumPoints = size_t(Params.SizeX) * Params.SizeY * Params.Batch;
+		const vk::DeviceSize Size = NumPoints * 2 * sizeof(float);
+		std::vector<float> Input(NumPoints * 2);
+		for (size_t I = 0; I < Input.size(); ++I)
+		{
+			Input[I] = float(uint32_t(I * 2654435761u) >> 24) / 128.0f - 1.0f;
+		}
+		ComputeBuffer Data = Context.createBuffer(Size);
+		ComputeBuffer Scratch = Context.createBuffer(Size);
+		Context.writeBuffer(Data, Input.data(), Size);
+		const std::string Name = std::to_string(Params.SizeX) + (Params.SizeY > 1 ? "x" + std::to_string(Params.SizeY) : std::string()) +
+								 " x " + std::to_string(Params.Batch) +
+								 (std::max(Params.SizeX, Params.SizeY) > Fft.getMaxSharedSize() ? " (global)" : " (shared)");
+
+		// Forward against the host on the first plane, then the round trip on everything
+		std::vector<float> Result(Input.size());
+		Fft.transform(Data, &Scratch, Params);
+		Context.readBuffer(Data, Result.data(), Size);
+		const std::vector<Complex> Expected = planeOnHost(Input, Params.SizeX, Params.SizeY);
+		double MaxError = 0.0;
+		double MaxValue = 0.0;
+		for (size_t I = 0; I < Expected.size(); ++I)
+		{
+			MaxError = std::max(MaxError, std::abs(Complex(Result[2 * I], Result[2 * I + 1]) - Expected[I]));
+			MaxValue = std::max(MaxValue, std::abs(Expected[I]));
+		}
+		FftParams InverseParams = Params;
+		InverseParams.Direction = FftDirection::Inverse;
+		Fft.transform(Data, &Scratch, InverseParams);
+		Context.readBuffer(Data, Result.data(), Size);
+		double RoundTripError = 0.0;
+		for (size_t I = 0; I < Input.size(); ++I)
+		{
+			RoundTripError = std::max(RoundTripError, double(std::abs(Result[I] - Input[I])));
+		}
+		if (MaxError > 1e-5 * MaxValue + 1e-5 || RoundTripError > 1e-4)
+		{
+			throw std::runtime_error(Name + " differs from the host (" + std::to_string(MaxError) + ", round trip " +
+									 std::to_string(RoundTripError) + ")");
+		}
+
+		std::vector<double> GpuSamples;
+		for (uint32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			const auto Start = bench::Clock::now();
+			Fft.transform(Data, &Scratch, Params);
+			GpuSamples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+		}
+		// What the callers did so far, read back and transform the first plane on the host, scaled
+		// to the batch to keep the baseline short
+		const auto HostStart = bench::Clock::now();
+		Context.readBuffer(Data, Result.data(), Size);
+		planeOnHost(Result, Params.SizeX, Params.SizeY);
+		const double HostMicroseconds = bench::elapsedMicroseconds(HostStart, bench::Clock::now()) * Params.Batch;
+
+		const double Flops = 5.0 * NumPoints * std::log2(double(Params.SizeX) * Params.SizeY);
+		const double GpuMicroseconds = bench::summarize(GpuSamples).P50;
+		std::cout << Name << " : gpu " << GpuMicroseconds << " us (" << Flops / GpuMicroseconds * 1e-3 << " GFLOP/s), readback + host ~"
+				  << HostMicroseconds << " us, max error " << MaxError / std::max(MaxValue, 1.0) << std::endl;
+		Context.destroyBuffer(Data);
+		Context.destroyBuffer(Scratch);
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint64_t Points = bench::argValue(Argc, Argv, "points", 4 * 1024 * 1024);
+		const uint32_t Iterations = static_cast<uint32_t>(bench::argValue(Argc, Argv, "iterations", 10));
+		ContextOptions Options;
+		Options.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(Options);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		FourierTransformer Fft(Context);
+		std::cout << "Max Shared FFT : " << Fft.getMaxSharedSize() << std::endl;
+
+		// 1D sizes, each batched up to about Points points
+		for (uint32_t N : { 64u, 256u, 1000u, 1024u, 1536u, 2048u, 3125u, 65536u, 1048576u })
+		{
+			FftParams Params;
+			Params.SizeX = N;
+			Params.Batch = static_cast<uint32_t>(std::max<uint64_t>(Points / N, 1));
+			run(Context, Fft, Params, Iterations);
+		}
+		// 2D, the long axis of the last two takes the global path on most devices
+		const std::pair<uint32_t, uint32_t> Planes[] = { { 256, 256 }, { 1024, 1024 }, { 8192, 64 }, { 64, 8192 } };
+		for (const auto& Plane : Planes)
+		{
+			FftParams Params;
+			Params.SizeX = Plane.first;
+			Params.SizeY = Plane.second;
+			Params.Batch = static_cast<uint32_t>(std::max<uint64_t>(Points / (uint64_t(Plane.first) * Plane.second), 1));
+			run(Context, Fft, Params, Iterations);
+		}
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
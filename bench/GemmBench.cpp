@@ -0,0 +1,193 @@
+// GEMM with MatrixMultiplier in GFLOP/s: every tile that fits the device, the transpose variants,
+// column-major, alpha/beta and half inputs. Every result is checked against a CPU GEMM; the inputs
+// are multiples of 1/8 so that float sums are exact and any difference is a bug.
+// Usage: GemmBench [--m N] [--n N] [--k N] [--iterations N] [--device N]
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "MatrixMultiplier.h"
+
+namespace
+{
+	// Only exact for normal halves like the values below
+	uint16_t toHalf(float Value)
+	{
+		uint32_t Bits;
+		std::memcpy(&Bits, &Value, sizeof(Bits));
+		const uint32_t Sign = (Bits >> 16) & 0x8000;
+		if ((Bits & 0x7FFFFFFF) == 0)
+		{
+			return static_cast<uint16_t>(Sign);
+		}
+		const uint32_t Exponent = ((Bits >> 23) & 0xFF) - 127 + 15;
+		return static_cast<uint16_t>(Sign | (Exponent << 10) | ((Bits & 0x7FFFFF) >> 13));
+	}
+
+	// Row-major reference on the stored matrices, same conventions as GemmParams
+	std::vector<float> gemmOnHost(const std::vector<float>& A, const std::vector<float>& B, std::vector<float> C, const GemmParams& Params)
+	{
+		const bool bColumnMajor = Params.Layout == MatrixLayout::ColumnMajor;
+		auto at = [bColumnMajor](const std::vector<float>& Matrix, uint32_t Row, uint32_t Col, uint32_t Rows, uint32_t Cols)
+		{
+			return bColumnMajor ? Matrix[size_t(Col) * Rows + Row] : Matrix[size_t(Row) * Cols + Col];
+		};
+		const uint32_t M = Params.M, N = Params.N, K = Params.K;
+		std::vector<float> Row(N);
+		for (uint32_t I = 0; I < M; ++I)
+		{
+			std::fill(Row.begin(), Row.end(), 0.0f);
+			for (uint32_t P = 0; P < K; ++P)
+			{
+				const float ValueA = Params.bTransposeA ? at(A, P, I, K, M) : at(A, I, P, M, K);
+				for (uint32_t J = 0; J < N; ++J)
+				{
+					Row[J] += ValueA * (Params.bTransposeB ? at(B, J, P, N, K) : at(B, P, J, K, N));
+				}
+			}
+			for (uint32_t J = 0; J < N; ++J)
+			{
+				float& Out = bColumnMajor ? C[size_t(J) * M + I] : C[size_t(I) * N + J];
+				Out = Params.Alpha * Row[J] + (Params.Beta != 0.0f ? Params.Beta * Out : 0.0f);
+			}
+		}
+		return C;
+	}
+
+	std::string tileName(const kernels::GemmTile& Tile)
+	{
+		return std::to_string(Tile.M) + "x" + std::to_string(Tile.N) + "x" + std::to_string(Tile.K) + "/" +
+			   std::to_string(Tile.ThreadM) + "x" + std::to_string(Tile.ThreadN);
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint32_t M = static_cast<uint32_t>(bench::argValue(Argc, Argv, "m", 1024));
+		const uint32_t N = static_cast<uint32_t>(bench::argValue(Argc, Argv, "n", 1024));
+		const uint32_t K = static_cast<uint32_t>(bench::argValue(Argc, Argv, "k", 1024));
+		const uint32_t Iterations = static_cast<uint32_t>(bench::argValue(Argc, Argv, "iterations", 10));
+		ContextOptions Options;
+		Options.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(Options);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		std::cout << "M x N x K      : " << M << " x " << N << " x " << K << std::endl;
+		MatrixMultiplier Multiplier(Context);
+
+		// Same element count for A and op(A), so one buffer serves every transpose
+		std::vector<float> A(size_t(M) * K);
+		std::vector<float> B(size_t(K) * N);
+		std::vector<float> C(size_t(M) * N);
+		for (size_t I = 0; I < A.size(); ++I)
+		{
+			A[I] = float(int32_t(static_cast<uint32_t>(I * 2654435761u) % 33) - 16) / 8.0f;
+		}
+		for (size_t I = 0; I < B.size(); ++I)
+		{
+			B[I] = float(int32_t(static_cast<uint32_t>(I * 2246822519u) % 33) - 16) / 8.0f;
+		}
+		for (size_t I = 0; I < C.size(); ++I)
+		{
+			C[I] = float(int32_t(I % 17) - 8) / 8.0f;
+		}
+		std::vector<uint16_t> HalfA(A.size());
+		std::vector<uint16_t> HalfB(B.size());
+		for (size_t I = 0; I < A.size(); ++I)
+		{
+			HalfA[I] = toHalf(A[I]);
+		}
+		for (size_t I = 0; I < B.size(); ++I)
+		{
+			HalfB[I] = toHalf(B[I]);
+		}
+
+		ComputeBuffer BufferA = Context.createBuffer(A.size() * sizeof(float));
+		ComputeBuffer BufferB = Context.createBuffer(B.size() * sizeof(float));
+		ComputeBuffer BufferHalfA = Context.createBuffer((HalfA.size() * sizeof(uint16_t) + 3) / 4 * 4);
+		ComputeBuffer BufferHalfB = Context.createBuffer((HalfB.size() * sizeof(uint16_t) + 3) / 4 * 4);
+		ComputeBuffer BufferC = Context.createBuffer(C.size() * sizeof(float));
+		Context.writeBuffer(BufferA, A.data(), A.size() * sizeof(float));
+		Context.writeBuffer(BufferB, B.data(), B.size() * sizeof(float));
+		Context.writeBuffer(BufferHalfA, HalfA.data(), HalfA.size() * sizeof(uint16_t));
+		Context.writeBuffer(BufferHalfB, HalfB.data(), HalfB.size() * sizeof(uint16_t));
+
+		std::vector<float> Result(C.size());
+		auto run = [&](const std::string& Name, const GemmParams& Params)
+		{
+			const bool bHalf = Params.Precision == GemmPrecision::Float16;
+			const ComputeBuffer& InA = bHalf ? BufferHalfA : BufferA;
+			const ComputeBuffer& InB = bHalf ? BufferHalfB : BufferB;
+			Context.writeBuffer(BufferC, C.data(), C.size() * sizeof(float));
+			Multiplier.multiply(InA, InB, BufferC, Params);
+			Context.readBuffer(BufferC, Result.data(), Result.size() * sizeof(float));
+			const std::vector<float> Expected = gemmOnHost(A, B, C, Params);
+			for (size_t I = 0; I < Result.size(); ++I)
+			{
+				if (std::abs(Result[I] - Expected[I]) > 1e-3f * (1.0f + std::abs(Expected[I])))
+				{
+					throw std::runtime_error(Name + " differs from the CPU gemm at " + std::to_string(I));
+				}
+			}
+
+			std::vector<double> Samples;
+			for (uint32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				const auto Start = bench::Clock::now();
+				Multiplier.multiply(InA, InB, BufferC, Params);
+				Samples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+			}
+			const double Microseconds = bench::summarize(Samples).P50;
+			std::cout << Name << " : " << Microseconds << " us, " << 2.0 * M * N * K / Microseconds * 1e-3 << " GFLOP/s" << std::endl;
+		};
+
+		GemmParams Params;
+		Params.M = M;
+		Params.N = N;
+		Params.K = K;
+		std::cout << "Picked tile    : " << tileName(Multiplier.chooseTile(M, N)) << std::endl;
+		for (const kernels::GemmTile& Tile : Multiplier.getTiles())
+		{
+			GemmParams Tiled = Params;
+			Tiled.Tile = Tile;
+			run("sgemm NN " + tileName(Tile), Tiled);
+		}
+		for (int Variant = 1; Variant < 4; ++Variant)
+		{
+			GemmParams Transposed = Params;
+			Transposed.bTransposeA = (Variant & 1) != 0;
+			Transposed.bTransposeB = (Variant & 2) != 0;
+			run(std::string("sgemm ") + (Transposed.bTransposeA ? "T" : "N") + (Transposed.bTransposeB ? "T" : "N"), Transposed);
+		}
+		GemmParams ColumnMajor = Params;
+		ColumnMajor.Layout = MatrixLayout::ColumnMajor;
+		ColumnMajor.bTransposeB = true;
+		run("sgemm column-major NT", ColumnMajor);
+		GemmParams Scaled = Params;
+		Scaled.Alpha = 1.5f;
+		Scaled.Beta = 0.5f;
+		run("sgemm alpha 1.5 beta 0.5", Scaled);
+		GemmParams Half = Params;
+		Half.Precision = GemmPrecision::Float16;
+		run("hgemm NN", Half);
+
+		Context.destroyBuffer(BufferA);
+		Context.destroyBuffer(BufferB);
+		Context.destroyBuffer(BufferHalfA);
+		Context.destroyBuffer(BufferHalfB);
+		Context.destroyBuffer(BufferC);
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
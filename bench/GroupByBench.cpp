@@ -0,0 +1,189 @@
+// GroupByAggregator against reading the columns back and aggregating with std::unordered_map, in
+// Mrows/s, for few and many groups with the shared and the global strategy. Five columns: sum, min
+// and max of floats, min of ints and the average of uints, plus the count. Counts, minimums and
+// maximums are checked exactly, sums and averages to a relative 1e-3 since the GPU adds in any order.
+// Usage: GroupByBench [--rows N] [--iterations N] [--device N]
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "GroupByAggregator.h"
+
+namespace
+{
+	struct HostGroup
+	{
+		uint32_t Count = 0;
+		double FloatSum = 0;
+		float FloatMin = INFINITY;
+		float FloatMax = -INFINITY;
+		int32_t IntMin = INT32_MAX;
+		double UintSum = 0;
+	};
+
+	struct Table
+	{
+		std::vector<uint32_t> Keys;
+		std::vector<float> Floats;
+		std::vector<int32_t> Ints;
+		std::vector<uint32_t> Uints;
+	};
+
+	Table makeTable(uint32_t NumRows, uint32_t NumKeys, std::mt19937& Random)
+	{
+		Table Rows;
+		std::uniform_int_distribution<uint32_t> Key(0, NumKeys - 1);
+		std::uniform_real_distribution<float> Float(-100.0f, 100.0f);
+		std::uniform_int_distribution<int32_t> Int(-1000000, 1000000);
+		std::uniform_int_distribution<uint32_t> Uint(0, 1000);
+		for (uint32_t Row = 0; Row < NumRows; ++Row)
+		{
+			// Spread the keys over the whole range, not just the low bits
+			Rows.Keys.push_back(Key(Random) * 2654435761u % 0xfffffff0u);
+			Rows.Floats.push_back(Float(Random));
+			Rows.Ints.push_back(Int(Random));
+			Rows.Uints.push_back(Uint(Random));
+		}
+		return Rows;
+	}
+
+	bool near(double Value, double Expected)
+	{
+		return std::abs(Value - Expected) <= 1e-3 * std::max(1.0, std::abs(Expected));
+	}
+
+	void check(const GroupByResult& Result, const std::unordered_map<uint32_t, HostGroup>& Expected, const std::string& Name)
+	{
+		if (Result.Keys.size() != Expected.size())
+		{
+			throw std::runtime_error(Name + ": " + std::to_string(Result.Keys.size()) + " groups, the host has " + std::to_string(Expected.size()));
+		}
+		for (size_t Group = 0; Group < Result.Keys.size(); ++Group)
+		{
+			const auto Found = Expected.find(Result.Keys[Group]);
+			if (Found == Expected.end())
+			{
+				throw std::runtime_error(Name + ": unknown key " + std::to_string(Result.Keys[Group]));
+			}
+			const HostGroup& Host = Found->second;
+			const bool bExact = Result.Counts[Group] == Host.Count && Result.Aggregates[1][Group] == Host.Count &&
+				Result.Aggregates[2][Group] == Host.FloatMin && Result.Aggregates[3][Group] == Host.FloatMax &&
+				Result.Aggregates[4][Group] == Host.IntMin;
+			if (!bExact || !near(Result.Aggregates[0][Group], Host.FloatSum) || !near(Result.Aggregates[5][Group], Host.UintSum / Host.Count))
+			{
+				throw std::runtime_error(Name + ": group " + std::to_string(Result.Keys[Group]) + " differs from the host");
+			}
+		}
+	}
+
+	void run(ComputeContext& Context, GroupByAggregator& Aggregator, uint32_t NumRows, uint32_t NumKeys, GroupByStrategy Strategy,
+			 const std::string& Name, uint32_t Iterations)
+	{
+		std::mt19937 Random(NumKeys);
+		const Table Rows = makeTable(NumRows, NumKeys, Random);
+		const vk::DeviceSize ColumnSize = vk::DeviceSize(NumRows) * sizeof(uint32_t);
+		ComputeBuffer Keys = Context.createBuffer(ColumnSize);
+		ComputeBuffer Floats = Context.createBuffer(ColumnSize);
+		ComputeBuffer Ints = Context.createBuffer(ColumnSize);
+		ComputeBuffer Uints = Context.createBuffer(ColumnSize);
+		Context.writeBuffer(Keys, Rows.Keys.data(), ColumnSize);
+		Context.writeBuffer(Floats, Rows.Floats.data(), ColumnSize);
+		Context.writeBuffer(Ints, Rows.Ints.data(), ColumnSize);
+		Context.writeBuffer(Uints, Rows.Uints.data(), ColumnSize);
+
+		// What the aggregator replaces: read every column back, then a hash map on the host
+		std::unordered_map<uint32_t, HostGroup> Expected;
+		std::vector<double> HostSamples;
+		for (uint32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			const auto Start = bench::Clock::now();
+			Table Host;
+			Host.Keys.resize(NumRows);
+			Host.Floats.resize(NumRows);
+			Host.Ints.resize(NumRows);
+			Host.Uints.resize(NumRows);
+			Context.readBuffer(Keys, Host.Keys.data(), ColumnSize);
+			Context.readBuffer(Floats, Host.Floats.data(), ColumnSize);
+			Context.readBuffer(Ints, Host.Ints.data(), ColumnSize);
+			Context.readBuffer(Uints, Host.Uints.data(), ColumnSize);
+			Expected.clear();
+			for (uint32_t Row = 0; Row < NumRows; ++Row)
+			{
+				HostGroup& Group = Expected[Host.Keys[Row]];
+				++Group.Count;
+				Group.FloatSum += Host.Floats[Row];
+				Group.FloatMin = std::min(Group.FloatMin, Host.Floats[Row]);
+				Group.FloatMax = std::max(Group.FloatMax, Host.Floats[Row]);
+				Group.IntMin = std::min(Group.IntMin, Host.Ints[Row]);
+				Group.UintSum += Host.Uints[Row];
+			}
+			HostSamples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+		}
+
+		std::vector<AggregateColumn> Columns(6);
+		Columns[0] = { &Floats, kernels::ElementType::Float, kernels::AggregateOp::Sum };
+		Columns[1] = { nullptr, kernels::ElementType::Uint, kernels::AggregateOp::Count };
+		Columns[2] = { &Floats, kernels::ElementType::Float, kernels::AggregateOp::Min };
+		Columns[3] = { &Floats, kernels::ElementType::Float, kernels::AggregateOp::Max };
+		Columns[4] = { &Ints, kernels::ElementType::Int, kernels::AggregateOp::Min };
+		Columns[5] = { &Uints, kernels::ElementType::Uint, kernels::AggregateOp::Avg };
+		GroupByOptions Options;
+		Options.Strategy = Strategy;
+		GroupByResult Result;
+		std::vector<double> Samples;
+		for (uint32_t Iteration = 0; Iteration <= Iterations; ++Iteration)
+		{
+			const auto Start = bench::Clock::now();
+			Result = Aggregator.aggregate(Keys, NumRows, Columns, Options);
+			// The first aggregation creates the pipelines
+			if (Iteration > 0)
+			{
+				Samples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+			}
+		}
+		Context.destroyBuffer(Keys);
+		Context.destroyBuffer(Floats);
+		Context.destroyBuffer(Ints);
+		Context.destroyBuffer(Uints);
+		check(Result, Expected, Name);
+		std::cout << Name << " : " << Result.Keys.size() << " groups, gpu " << NumRows / bench::summarize(Samples).P50 << " Mrows/s, host "
+				  << NumRows / bench::summarize(HostSamples).P50 << " Mrows/s (readback included)" << std::endl;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint32_t NumRows = static_cast<uint32_t>(std::max<uint64_t>(bench::argValue(Argc, Argv, "rows", 16 * 1024 * 1024), 1));
+		const uint32_t Iterations = static_cast<uint32_t>(std::max<uint64_t>(bench::argValue(Argc, Argv, "iterations", 5), 1));
+		ContextOptions ContextOpts;
+		ContextOpts.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(ContextOpts);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		const uint32_t ManyKeys = std::max(NumRows / 4, 1u);
+		GroupByAggregator Aggregator(Context, ManyKeys);
+		std::cout << "Shared groups  : " << Aggregator.getSharedSlots(6) << " per workgroup" << std::endl;
+
+		for (uint32_t NumKeys : { 16u, 1000u, ManyKeys })
+		{
+			const std::string Keys = std::to_string(NumKeys) + " keys";
+			run(Context, Aggregator, NumRows, NumKeys, GroupByStrategy::Shared, Keys + ", shared", Iterations);
+			run(Context, Aggregator, NumRows, NumKeys, GroupByStrategy::Global, Keys + ", global", Iterations);
+		}
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
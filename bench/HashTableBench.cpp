@@ -0,0 +1,253 @@
+// HashTable bulk insert, find (half the probe keys missing) and erase in Mops/s at load factors from
+// 0.25 to 0.9, for uint32 and (when supported) uint64 keys, against std::unordered_map. Then an
+// equi-join of a probe column against a build column with duplicate keys, in Mrows/s of probe keys.
+// Every result is checked against the host.
+// Usage: HashTableBench [--keys N] [--iterations N] [--device N]
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "HashTable.h"
+
+namespace
+{
+	template <typename T>
+	double medianMicroseconds(uint32_t Iterations, T&& Run)
+	{
+		std::vector<double> Samples;
+		// The first run creates the pipelines
+		for (uint32_t Iteration = 0; Iteration <= Iterations; ++Iteration)
+		{
+			const auto Start = bench::Clock::now();
+			Run();
+			if (Iteration > 0)
+			{
+				Samples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+			}
+		}
+		return bench::summarize(Samples).P50;
+	}
+
+	// Distinct keys below the marker keys, the first half is inserted and the second half misses
+	template <typename KeyT>
+	std::vector<KeyT> makeKeys(uint32_t Count, std::mt19937_64& Random)
+	{
+		std::unordered_set<KeyT> Seen;
+		std::vector<KeyT> Keys;
+		Keys.reserve(Count);
+		while (Keys.size() < Count)
+		{
+			const KeyT Key = static_cast<KeyT>(Random());
+			if (Key < static_cast<KeyT>(~KeyT(0) - 1) && Seen.insert(Key).second)
+			{
+				Keys.push_back(Key);
+			}
+		}
+		return Keys;
+	}
+
+	template <typename KeyT>
+	void runLoadFactor(ComputeContext& Context, kernels::HashKeyType KeyType, const std::vector<KeyT>& Keys, float LoadFactor,
+					   uint32_t Iterations)
+	{
+		const uint32_t NumInserted = static_cast<uint32_t>(Keys.size() / 2);
+		const uint32_t NumKeys = static_cast<uint32_t>(Keys.size());
+		std::vector<uint32_t> Values(NumKeys);
+		for (uint32_t I = 0; I < NumKeys; ++I)
+		{
+			Values[I] = I * 7;
+		}
+
+		std::unordered_map<KeyT, uint32_t> HostMap;
+		const double HostInsert = medianMicroseconds(Iterations, [&]()
+		{
+			HostMap.clear();
+			HostMap.reserve(NumInserted);
+			for (uint32_t I = 0; I < NumInserted; ++I)
+			{
+				HostMap.emplace(Keys[I], Values[I]);
+			}
+		});
+		std::vector<uint32_t> Expected(NumKeys);
+		const double HostFind = medianMicroseconds(Iterations, [&]()
+		{
+			for (uint32_t I = 0; I < NumKeys; ++I)
+			{
+				const auto Found = HostMap.find(Keys[I]);
+				Expected[I] = Found != HostMap.end() ? Found->second : HashTable::NotFound;
+			}
+		});
+
+		HashTableOptions Options;
+		Options.KeyType = KeyType;
+		Options.MaxLoadFactor = LoadFactor;
+		HashTable Table(Context, NumInserted, Options);
+		ComputeBuffer KeyBuffer = Context.createBuffer(Keys.size() * sizeof(KeyT));
+		ComputeBuffer ValueBuffer = Context.createBuffer(NumKeys * sizeof(uint32_t));
+		ComputeBuffer FoundBuffer = Context.createBuffer(NumKeys * sizeof(uint32_t));
+		Context.writeBuffer(KeyBuffer, Keys.data(), Keys.size() * sizeof(KeyT));
+		Context.writeBuffer(ValueBuffer, Values.data(), NumKeys * sizeof(uint32_t));
+
+		const double Insert = medianMicroseconds(Iterations, [&]()
+		{
+			Table.clear();
+			Table.insert(KeyBuffer, NumInserted, &ValueBuffer);
+		});
+		const double Find = medianMicroseconds(Iterations, [&]() { Table.find(KeyBuffer, NumKeys, FoundBuffer); });
+		std::vector<uint32_t> Found(NumKeys);
+		Context.readBuffer(FoundBuffer, Found.data(), NumKeys * sizeof(uint32_t));
+		if (Found != Expected || Table.getStats().Size != NumInserted)
+		{
+			throw std::runtime_error("hash table lookups differ from std::unordered_map");
+		}
+		// Erasing leaves the slots used, every run erases from a freshly filled table
+		std::vector<double> EraseSamples;
+		for (uint32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			Table.clear();
+			Table.insert(KeyBuffer, NumInserted, &ValueBuffer);
+			const auto Start = bench::Clock::now();
+			Table.erase(KeyBuffer, NumInserted);
+			EraseSamples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+		}
+		const double Erase = bench::summarize(EraseSamples).P50;
+		if (Table.getStats().Size != 0)
+		{
+			throw std::runtime_error("hash table erase left keys behind");
+		}
+		Context.destroyBuffer(KeyBuffer);
+		Context.destroyBuffer(ValueBuffer);
+		Context.destroyBuffer(FoundBuffer);
+
+		std::cout << sizeof(KeyT) * 8 << "-bit keys, load " << double(NumInserted) / Table.getSlotCount() << " : insert "
+				  << NumInserted / Insert << " Mops/s (host " << NumInserted / HostInsert << "), find " << NumKeys / Find << " Mops/s (host "
+				  << NumKeys / HostFind << "), erase " << NumInserted / Erase << " Mops/s" << std::endl;
+	}
+
+	void runJoin(ComputeContext& Context, uint32_t NumBuild, uint32_t NumProbe, uint32_t Iterations)
+	{
+		// Build keys repeat about twice, probe keys hit about half the time
+		std::mt19937 Random(7);
+		std::uniform_int_distribution<uint32_t> BuildKey(0, NumBuild / 2);
+		std::uniform_int_distribution<uint32_t> ProbeKey(0, NumBuild);
+		std::vector<uint32_t> Build(NumBuild);
+		std::vector<uint32_t> Probe(NumProbe);
+		for (uint32_t& Key : Build)
+		{
+			Key = BuildKey(Random);
+		}
+		for (uint32_t& Key : Probe)
+		{
+			Key = ProbeKey(Random);
+		}
+
+		std::vector<std::pair<uint32_t, uint32_t>> Expected;
+		const double HostMicroseconds = medianMicroseconds(Iterations, [&]()
+		{
+			std::unordered_multimap<uint32_t, uint32_t> HostMap;
+			HostMap.reserve(NumBuild);
+			for (uint32_t I = 0; I < NumBuild; ++I)
+			{
+				HostMap.emplace(Build[I], I);
+			}
+			Expected.clear();
+			for (uint32_t I = 0; I < NumProbe; ++I)
+			{
+				const auto Range = HostMap.equal_range(Probe[I]);
+				for (auto It = Range.first; It != Range.second; ++It)
+				{
+					Expected.emplace_back(I, It->second);
+				}
+			}
+		});
+
+		HashTableOptions Options;
+		Options.bUnique = false;
+		HashTable Table(Context, NumBuild, Options);
+		ComputeBuffer BuildBuffer = Context.createBuffer(NumBuild * sizeof(uint32_t));
+		ComputeBuffer ProbeBuffer = Context.createBuffer(NumProbe * sizeof(uint32_t));
+		Context.writeBuffer(BuildBuffer, Build.data(), NumBuild * sizeof(uint32_t));
+		Context.writeBuffer(ProbeBuffer, Probe.data(), NumProbe * sizeof(uint32_t));
+		const uint32_t Capacity = static_cast<uint32_t>(Expected.size());
+		ComputeBuffer ProbeIndices = Context.createBuffer(std::max(Capacity, 1u) * sizeof(uint32_t));
+		ComputeBuffer BuildIndices = Context.createBuffer(std::max(Capacity, 1u) * sizeof(uint32_t));
+		uint32_t Matches = 0;
+		const double Microseconds = medianMicroseconds(Iterations, [&]()
+		{
+			Table.clear();
+			Table.insertAsync(BuildBuffer, NumBuild);
+			Matches = Table.join(ProbeBuffer, NumProbe, ProbeIndices, BuildIndices, Capacity);
+		});
+
+		std::vector<uint32_t> Left(Capacity);
+		std::vector<uint32_t> Right(Capacity);
+		Context.readBuffer(ProbeIndices, Left.data(), Capacity * sizeof(uint32_t));
+		Context.readBuffer(BuildIndices, Right.data(), Capacity * sizeof(uint32_t));
+		Context.destroyBuffer(BuildBuffer);
+		Context.destroyBuffer(ProbeBuffer);
+		Context.destroyBuffer(ProbeIndices);
+		Context.destroyBuffer(BuildIndices);
+		std::vector<std::pair<uint32_t, uint32_t>> Pairs(Capacity);
+		for (uint32_t I = 0; I < Capacity; ++I)
+		{
+			Pairs[I] = { Left[I], Right[I] };
+		}
+		// Pairs come ordered by probe index, the build side of one probe key in no particular order
+		if (!std::is_sorted(Pairs.begin(), Pairs.end(), [](const auto& A, const auto& B) { return A.first < B.first; }))
+		{
+			throw std::runtime_error("join pairs are not ordered by probe index");
+		}
+		std::sort(Pairs.begin(), Pairs.end());
+		std::sort(Expected.begin(), Expected.end());
+		if (Matches != Capacity || Pairs != Expected)
+		{
+			throw std::runtime_error("join pairs differ from std::unordered_multimap");
+		}
+		std::cout << "join " << NumBuild << " x " << NumProbe << " rows, " << Matches << " matches : gpu " << NumProbe / Microseconds
+				  << " Mrows/s, host " << NumProbe / HostMicroseconds << " Mrows/s (build included)" << std::endl;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint32_t NumKeys = static_cast<uint32_t>(bench::argValue(Argc, Argv, "keys", 8 * 1024 * 1024));
+		const uint32_t Iterations = static_cast<uint32_t>(std::max<uint64_t>(bench::argValue(Argc, Argv, "iterations", 5), 1));
+		ContextOptions ContextOpts;
+		ContextOpts.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(ContextOpts);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		std::cout << "64-bit atomics : " << (Context.hasBufferInt64Atomics() ? "yes" : "no") << std::endl;
+
+		std::mt19937_64 Random(42);
+		const std::vector<uint32_t> Keys32 = makeKeys<uint32_t>(std::max(NumKeys, 2u), Random);
+		for (float LoadFactor : { 0.25f, 0.5f, 0.7f, 0.8f, 0.9f })
+		{
+			runLoadFactor(Context, kernels::HashKeyType::Uint32, Keys32, LoadFactor, Iterations);
+		}
+		if (HashTable::isSupported(Context, kernels::HashKeyType::Uint64))
+		{
+			const std::vector<uint64_t> Keys64 = makeKeys<uint64_t>(std::max(NumKeys, 2u), Random);
+			for (float LoadFactor : { 0.5f, 0.8f })
+			{
+				runLoadFactor(Context, kernels::HashKeyType::Uint64, Keys64, LoadFactor, Iterations);
+			}
+		}
+		runJoin(Context, std::max(NumKeys / 4, 2u), std::max(NumKeys, 1u), Iterations);
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
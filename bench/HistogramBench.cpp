@@ -0,0 +1,125 @@
+// Histograms with Histogrammer, shared-memory privatized bins against global atomics, for bin
+// counts from a few to more than fit shared memory and for uniform and skewed keys.
+// Every result is checked against the host.
+// Usage: HistogramBench [--elements N] [--iterations N] [--device N]
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "Histogrammer.h"
+
+namespace
+{
+	template <typename T>
+	std::vector<uint32_t> histogramOnHost(const std::vector<T>& Data, T Min, T Max, uint32_t BinCount)
+	{
+		std::vector<uint32_t> Bins(BinCount);
+		for (T Value : Data)
+		{
+			if (!(Value >= Min && Value <= Max))
+			{
+				continue;
+			}
+			uint32_t Bin;
+			if (std::is_floating_point<T>::value)
+			{
+				// Same float operations as the shader
+				Bin = std::min(static_cast<uint32_t>(float(Value - Min) / float(Max - Min) * float(BinCount)), BinCount - 1);
+			}
+			else
+			{
+				const uint32_t Width = (static_cast<uint32_t>(Max) - static_cast<uint32_t>(Min)) / BinCount + 1;
+				Bin = (static_cast<uint32_t>(Value) - static_cast<uint32_t>(Min)) / Width;
+			}
+			++Bins[Bin];
+		}
+		return Bins;
+	}
+
+	template <typename T>
+	void run(ComputeContext& Context, Histogrammer& Histogram, const std::vector<T>& Data, T Min, T Max, uint32_t BinCount,
+			 const std::string& Name, uint32_t Iterations)
+	{
+		const vk::DeviceSize InputSize = Data.size() * sizeof(T);
+		ComputeBuffer Input = Context.createBuffer(InputSize);
+		ComputeBuffer Bins = Context.createBuffer(BinCount * sizeof(uint32_t));
+		Context.writeBuffer(Input, Data.data(), InputSize);
+		const std::vector<uint32_t> Expected = histogramOnHost(Data, Min, Max, BinCount);
+
+		std::vector<std::pair<HistogramStrategy, const char*>> Strategies = { { HistogramStrategy::GlobalAtomics, "global" } };
+		if (BinCount <= Histogram.getMaxSharedBins())
+		{
+			Strategies.insert(Strategies.begin(), { HistogramStrategy::SharedMemory, "shared" });
+		}
+		std::vector<uint32_t> Result(BinCount);
+		for (const auto& Strategy : Strategies)
+		{
+			Histogram.histogram(Input, Data.size(), Min, Max, BinCount, Bins, Strategy.first);
+			Context.readBuffer(Bins, Result.data(), BinCount * sizeof(uint32_t));
+			if (Result != Expected)
+			{
+				throw std::runtime_error(Name + " " + Strategy.second + " histogram differs from the host");
+			}
+			std::vector<double> Samples;
+			for (uint32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				const auto Start = bench::Clock::now();
+				Histogram.histogram(Input, Data.size(), Min, Max, BinCount, Bins, Strategy.first);
+				Samples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+			}
+			const double Microseconds = bench::summarize(Samples).P50;
+			std::cout << Name << " " << BinCount << " bins " << Strategy.second << " : " << Microseconds << " us, "
+					  << InputSize / Microseconds * 1e-3 << " GB/s" << std::endl;
+		}
+		Context.destroyBuffer(Input);
+		Context.destroyBuffer(Bins);
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint64_t NumElements = bench::argValue(Argc, Argv, "elements", 32 * 1024 * 1024 + 3);
+		const uint32_t Iterations = static_cast<uint32_t>(bench::argValue(Argc, Argv, "iterations", 10));
+		ContextOptions Options;
+		Options.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(Options);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		std::cout << "Elements       : " << NumElements << std::endl;
+		Histogrammer Histogram(Context);
+		std::cout << "Shared bins    : " << Histogram.getMaxSharedBins() << std::endl;
+
+		// Uniform keys spread the atomics, skewed keys pile three quarters of them onto one bin
+		std::vector<uint32_t> Uniform(NumElements);
+		std::vector<uint32_t> Skewed(NumElements);
+		std::vector<float> Floats(NumElements);
+		for (uint64_t I = 0; I < NumElements; ++I)
+		{
+			const uint32_t Hash = static_cast<uint32_t>(I * 2654435761u);
+			Uniform[I] = Hash;
+			Skewed[I] = Hash % 4 != 0 ? 0u : Hash;
+			Floats[I] = float(Hash >> 8) / float(1 << 24) * 2.0f - 1.0f;
+		}
+		for (uint32_t BinCount : { 16u, 256u, 4096u, 65536u })
+		{
+			run(Context, Histogram, Uniform, 0u, UINT32_MAX, BinCount, "u32 uniform", Iterations);
+			run(Context, Histogram, Skewed, 0u, UINT32_MAX, BinCount, "u32 skewed", Iterations);
+		}
+		run(Context, Histogram, Floats, -0.5f, 0.5f, 1000u, "f32", Iterations);
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
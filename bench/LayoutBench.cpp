@@ -0,0 +1,182 @@
+// LayoutConverter transposes of 4, 8 and 16 byte elements and array of structs <-> struct of arrays
+// conversions, in GB/s moved (read plus written), against the host loops they replace. Every result
+// is checked against the host, the conversions also by a round trip.
+// Usage: LayoutBench [--size N] [--records N] [--iterations N] [--device N]
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "LayoutConverter.h"
+
+namespace
+{
+	template <typename T>
+	double medianMicroseconds(uint32_t Iterations, T&& Run)
+	{
+		std::vector<double> Samples;
+		// The first run creates the pipeline
+		for (uint32_t Iteration = 0; Iteration <= Iterations; ++Iteration)
+		{
+			const auto Start = bench::Clock::now();
+			Run();
+			if (Iteration > 0)
+			{
+				Samples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+			}
+		}
+		return bench::summarize(Samples).P50;
+	}
+
+	std::vector<uint32_t> makeWords(size_t Count)
+	{
+		std::vector<uint32_t> Words(Count);
+		for (size_t I = 0; I < Count; ++I)
+		{
+			Words[I] = static_cast<uint32_t>(I * 2654435761u);
+		}
+		return Words;
+	}
+
+	void runTranspose(ComputeContext& Context, LayoutConverter& Converter, uint32_t Rows, uint32_t Cols, uint32_t ElementSize,
+					  uint32_t Iterations)
+	{
+		const uint32_t Words = ElementSize / sizeof(uint32_t);
+		const vk::DeviceSize Size = vk::DeviceSize(Rows) * Cols * ElementSize;
+		const std::vector<uint32_t> Input = makeWords(Size / sizeof(uint32_t));
+		std::vector<uint32_t> Expected(Input.size());
+		const double HostMicroseconds = medianMicroseconds(Iterations, [&]()
+		{
+			for (uint32_t Row = 0; Row < Rows; ++Row)
+			{
+				for (uint32_t Col = 0; Col < Cols; ++Col)
+				{
+					std::memcpy(&Expected[(size_t(Col) * Rows + Row) * Words], &Input[(size_t(Row) * Cols + Col) * Words], ElementSize);
+				}
+			}
+		});
+
+		ComputeBuffer In = Context.createBuffer(Size);
+		ComputeBuffer Out = Context.createBuffer(Size);
+		Context.writeBuffer(In, Input.data(), Size);
+		const double Microseconds = medianMicroseconds(Iterations, [&]() { Converter.transpose(In, Out, Rows, Cols, ElementSize); });
+		std::vector<uint32_t> Result(Input.size());
+		Context.readBuffer(Out, Result.data(), Size);
+		Context.destroyBuffer(In);
+		Context.destroyBuffer(Out);
+		if (Result != Expected)
+		{
+			throw std::runtime_error("transpose of " + std::to_string(ElementSize) + " byte elements differs from the host");
+		}
+		std::cout << "transpose " << Rows << " x " << Cols << " of " << ElementSize << " B : gpu " << 2 * Size / Microseconds * 1e-3
+				  << " GB/s, host " << 2 * Size / HostMicroseconds * 1e-3 << " GB/s" << std::endl;
+	}
+
+	void runLayout(ComputeContext& Context, LayoutConverter& Converter, const RecordLayout& Layout, uint32_t NumRecords, const std::string& Name,
+				   uint32_t Iterations)
+	{
+		const vk::DeviceSize AosSize = vk::DeviceSize(NumRecords) * Layout.Stride;
+		const vk::DeviceSize SoaSize = Layout.getSoaSize(NumRecords);
+		const std::vector<uint32_t> Records = makeWords(AosSize / sizeof(uint32_t));
+		std::vector<uint8_t> Expected(SoaSize);
+		const double HostMicroseconds = medianMicroseconds(Iterations, [&]()
+		{
+			const uint8_t* Bytes = reinterpret_cast<const uint8_t*>(Records.data());
+			for (size_t Field = 0; Field < Layout.Fields.size(); ++Field)
+			{
+				uint8_t* Array = Expected.data() + Layout.getSoaOffset(Field, NumRecords);
+				const RecordField& Desc = Layout.Fields[Field];
+				for (uint32_t Record = 0; Record < NumRecords; ++Record)
+				{
+					std::memcpy(Array + size_t(Record) * Desc.Size, Bytes + size_t(Record) * Layout.Stride + Desc.Offset, Desc.Size);
+				}
+			}
+		});
+
+		ComputeBuffer Aos = Context.createBuffer(AosSize);
+		ComputeBuffer Soa = Context.createBuffer(SoaSize);
+		ComputeBuffer Back = Context.createBuffer(AosSize);
+		Context.writeBuffer(Aos, Records.data(), AosSize);
+		const double ToSoa = medianMicroseconds(Iterations, [&]() { Converter.aosToSoa(Aos, Soa, NumRecords, Layout); });
+		std::vector<uint8_t> Result(SoaSize);
+		Context.readBuffer(Soa, Result.data(), SoaSize);
+		if (Result != Expected)
+		{
+			throw std::runtime_error(Name + " struct of arrays differs from the host");
+		}
+		// Words of no field keep what Back held, zeros
+		const std::vector<uint32_t> Zeros(AosSize / sizeof(uint32_t));
+		Context.writeBuffer(Back, Zeros.data(), AosSize);
+		const double ToAos = medianMicroseconds(Iterations, [&]() { Converter.soaToAos(Soa, Back, NumRecords, Layout); });
+		std::vector<uint8_t> RoundTrip(AosSize);
+		Context.readBuffer(Back, RoundTrip.data(), AosSize);
+		Context.destroyBuffer(Aos);
+		Context.destroyBuffer(Soa);
+		Context.destroyBuffer(Back);
+		const uint8_t* Bytes = reinterpret_cast<const uint8_t*>(Records.data());
+		for (uint32_t Record = 0; Record < NumRecords; ++Record)
+		{
+			for (const RecordField& Field : Layout.Fields)
+			{
+				const size_t Offset = size_t(Record) * Layout.Stride + Field.Offset;
+				if (std::memcmp(&RoundTrip[Offset], Bytes + Offset, Field.Size) != 0)
+				{
+					throw std::runtime_error(Name + " round trip differs at record " + std::to_string(Record));
+				}
+			}
+		}
+		const double Moved = double(AosSize + SoaSize);
+		std::cout << Name << " : aos->soa " << Moved / ToSoa * 1e-3 << " GB/s, soa->aos " << Moved / ToAos * 1e-3 << " GB/s, host loop "
+				  << Moved / HostMicroseconds * 1e-3 << " GB/s" << std::endl;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint32_t Size = static_cast<uint32_t>(bench::argValue(Argc, Argv, "size", 4096));
+		const uint32_t NumRecords = static_cast<uint32_t>(bench::argValue(Argc, Argv, "records", 4 * 1024 * 1024 + 3));
+		const uint32_t Iterations = static_cast<uint32_t>(std::max<uint64_t>(bench::argValue(Argc, Argv, "iterations", 5), 1));
+		ContextOptions Options;
+		Options.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(Options);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		LayoutConverter Converter(Context);
+		std::cout << "Max stride     : " << Converter.getMaxStride() << " B" << std::endl;
+
+		for (uint32_t ElementSize : { 4u, 8u, 16u })
+		{
+			runTranspose(Context, Converter, Size, Size, ElementSize, Iterations);
+		}
+		// Ragged edges on both sides
+		runTranspose(Context, Converter, Size + 7, Size / 2 - 5, 4, Iterations);
+
+		// A particle: position and velocity as 3 floats each, an id and 4 bytes of padding
+		RecordLayout Particle;
+		Particle.Stride = 32;
+		Particle.Fields = { { 0, 12 }, { 12, 12 }, { 24, 4 } };
+		runLayout(Context, Converter, Particle, NumRecords, "particle 32 B", Iterations);
+		// Four equally sized fields filling the record, converted as a transpose
+		RecordLayout Vec4;
+		Vec4.Stride = 16;
+		Vec4.Fields = { { 0, 4 }, { 4, 4 }, { 8, 4 }, { 12, 4 } };
+		runLayout(Context, Converter, Vec4, NumRecords, "vec4 16 B", Iterations);
+		// Fields out of record order and a wide one
+		RecordLayout Mixed;
+		Mixed.Stride = 48;
+		Mixed.Fields = { { 32, 16 }, { 0, 8 }, { 8, 20 } };
+		runLayout(Context, Converter, Mixed, NumRecords, "mixed 48 B", Iterations);
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,83 @@
+// Pipeline creation time at startup with and without the persisted pipeline cache:
+//   cold : the cache file is deleted before the context comes up
+//   warm : the context loads the file the previous run saved
+// Every run creates the add and square kernels plus all tunable workgroup size variants.
+// Drivers keep their own shader caches as well, disable them for a true cold number
+// (e.g. MESA_SHADER_CACHE_DISABLE=true, __GL_SHADER_DISK_CACHE=0).
+// Usage: PipelineCacheBench [--runs N] [--device N]
+#include <filesystem>
+#include <iostream>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "Kernels.h"
+
+namespace
+{
+	// Microseconds spent creating every pipeline variant of the shipped kernels
+	double createPipelines(ComputeContext& Context)
+	{
+		const auto Start = bench::Clock::now();
+		WorkgroupTuner Tuner(Context);
+		for (const KernelDesc& Desc : { kernels::add(), kernels::square() })
+		{
+			const ComputeKernel& Kernel = Context.createKernel(Desc);
+			for (uint32_t GroupSize : Tuner.candidateSizes())
+			{
+				Context.getPipeline(Kernel, GroupSize);
+			}
+		}
+		return bench::elapsedMicroseconds(Start, bench::Clock::now());
+	}
+
+	void report(const char* Mode, const std::vector<double>& Samples)
+	{
+		const bench::LatencyStats Stats = bench::summarize(Samples);
+		std::cout << Mode << " : p50 " << Stats.P50 / 1000.0 << " ms, min " << Stats.Min / 1000.0
+				  << " ms, mean " << Stats.Mean / 1000.0 << " ms" << std::endl;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint64_t NumRuns = bench::argValue(Argc, Argv, "runs", 5);
+		ContextOptions Options;
+		Options.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+		Options.PipelineCacheDirectory = "cache/bench";
+
+		std::string CachePath;
+		{
+			// Nothing is created here, so this context does not write the file
+			ComputeContext Context(Options);
+			std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+			CachePath = Context.getPipelineCachePath();
+			std::cout << "Cache file     : " << CachePath << std::endl;
+		}
+
+		std::vector<double> ColdSamples;
+		std::vector<double> WarmSamples;
+		for (uint64_t Run = 0; Run < NumRuns; ++Run)
+		{
+			std::filesystem::remove(CachePath);
+			{
+				ComputeContext Context(Options);
+				ColdSamples.push_back(createPipelines(Context));
+			}
+			{
+				// Loads what the cold context saved on destruction
+				ComputeContext Context(Options);
+				WarmSamples.push_back(createPipelines(Context));
+			}
+		}
+		report("cold", ColdSamples);
+		report("warm", WarmSamples);
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,163 @@
+// RadixSorter against std::sort and a threaded host sort, in Mkeys/s, for uint32 keys, uint64
+// keys and uint32 key-value pairs. The GPU time covers the sort only, the keys are uploaded before.
+// Usage: RadixSortBench [--keys N] [--iterations N] [--threads N] [--device N]
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "RadixSorter.h"
+
+namespace
+{
+	// Sorts equal slices on their own threads, then merges them pairwise
+	template <typename T>
+	void parallelSort(std::vector<T>& Data, uint32_t NumThreads)
+	{
+		std::vector<size_t> Bounds;
+		for (uint32_t Slice = 0; Slice <= NumThreads; ++Slice)
+		{
+			Bounds.push_back(Data.size() * Slice / NumThreads);
+		}
+		std::vector<std::thread> Threads;
+		for (uint32_t Slice = 0; Slice < NumThreads; ++Slice)
+		{
+			Threads.emplace_back([&, Slice]() { std::sort(Data.begin() + Bounds[Slice], Data.begin() + Bounds[Slice + 1]); });
+		}
+		for (std::thread& Thread : Threads)
+		{
+			Thread.join();
+		}
+		for (size_t Width = 1; Width < NumThreads; Width *= 2)
+		{
+			Threads.clear();
+			for (size_t Slice = 0; Slice + Width < NumThreads; Slice += 2 * Width)
+			{
+				const size_t Last = std::min<size_t>(Slice + 2 * Width, NumThreads);
+				Threads.emplace_back([&, Slice, Width, Last]()
+				{
+					std::inplace_merge(Data.begin() + Bounds[Slice], Data.begin() + Bounds[Slice + Width], Data.begin() + Bounds[Last]);
+				});
+			}
+			for (std::thread& Thread : Threads)
+			{
+				Thread.join();
+			}
+		}
+	}
+
+	template <typename T>
+	double hostMkeysPerSecond(const std::vector<T>& Keys, uint32_t NumThreads)
+	{
+		std::vector<T> Copy = Keys;
+		const auto Start = bench::Clock::now();
+		if (NumThreads <= 1)
+		{
+			std::sort(Copy.begin(), Copy.end());
+		}
+		else
+		{
+			parallelSort(Copy, NumThreads);
+		}
+		return Keys.size() / bench::elapsedMicroseconds(Start, bench::Clock::now());
+	}
+
+	// Keys only, or keys with their original index as the value. Checks sortedness and stability
+	template <typename T>
+	double gpuMkeysPerSecond(ComputeContext& Context, RadixSorter& Sorter, const std::vector<T>& Keys, RadixKeyType KeyType,
+							 bool bPairs, uint32_t Iterations)
+	{
+		const vk::DeviceSize KeysSize = Keys.size() * sizeof(T);
+		const vk::DeviceSize ValuesSize = Keys.size() * sizeof(uint32_t);
+		std::vector<uint32_t> Indices(Keys.size());
+		for (size_t I = 0; I < Indices.size(); ++I)
+		{
+			Indices[I] = static_cast<uint32_t>(I);
+		}
+		ComputeBuffer KeyBuffer = Context.createBuffer(KeysSize);
+		ComputeBuffer ValueBuffer = bPairs ? Context.createBuffer(ValuesSize) : ComputeBuffer();
+		std::vector<double> Samples;
+		for (uint32_t Iteration = 0; Iteration <= Iterations; ++Iteration)
+		{
+			Context.writeBuffer(KeyBuffer, Keys.data(), KeysSize);
+			if (bPairs)
+			{
+				Context.writeBuffer(ValueBuffer, Indices.data(), ValuesSize);
+			}
+			const auto Start = bench::Clock::now();
+			Sorter.sort(KeyBuffer, Keys.size(), KeyType, bPairs ? &ValueBuffer : nullptr);
+			// The first sort creates the pipelines and temporaries
+			if (Iteration > 0)
+			{
+				Samples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+			}
+		}
+
+		std::vector<T> Sorted(Keys.size());
+		Context.readBuffer(KeyBuffer, Sorted.data(), KeysSize);
+		std::vector<uint32_t> Permutation(bPairs ? Keys.size() : 0);
+		if (bPairs)
+		{
+			Context.readBuffer(ValueBuffer, Permutation.data(), ValuesSize);
+		}
+		Context.destroyBuffer(KeyBuffer);
+		Context.destroyBuffer(ValueBuffer);
+		for (size_t I = 0; I < Sorted.size(); ++I)
+		{
+			const bool bOrdered = I == 0 || Sorted[I - 1] <= Sorted[I];
+			const bool bStable = !bPairs || (Keys[Permutation[I]] == Sorted[I] && (I == 0 || Sorted[I - 1] != Sorted[I] || Permutation[I - 1] < Permutation[I]));
+			if (!bOrdered || !bStable)
+			{
+				throw std::runtime_error("radix sort result is wrong at key " + std::to_string(I));
+			}
+		}
+		return Keys.size() / bench::summarize(Samples).P50;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint64_t NumKeys = bench::argValue(Argc, Argv, "keys", 16 * 1024 * 1024 + 7);
+		const uint32_t Iterations = static_cast<uint32_t>(std::max<uint64_t>(bench::argValue(Argc, Argv, "iterations", 5), 1));
+		const uint32_t NumThreads = static_cast<uint32_t>(bench::argValue(Argc, Argv, "threads", std::max(std::thread::hardware_concurrency(), 1u)));
+		ContextOptions Options;
+		Options.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(Options);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		std::cout << "Keys           : " << NumKeys << std::endl;
+		RadixSorter Sorter(Context);
+
+		std::mt19937_64 Random(42);
+		std::vector<uint32_t> Keys32(NumKeys);
+		std::vector<uint64_t> Keys64(NumKeys);
+		for (uint64_t I = 0; I < NumKeys; ++I)
+		{
+			Keys64[I] = Random();
+			// Few distinct values so that stability is actually exercised by the pairs
+			Keys32[I] = static_cast<uint32_t>(Keys64[I] >> 40);
+		}
+
+		std::cout << "u32 keys  : gpu " << gpuMkeysPerSecond(Context, Sorter, Keys32, RadixKeyType::Uint32, false, Iterations)
+				  << " Mkeys/s, std::sort " << hostMkeysPerSecond(Keys32, 1) << " Mkeys/s, " << NumThreads << " threads "
+				  << hostMkeysPerSecond(Keys32, NumThreads) << " Mkeys/s" << std::endl;
+		std::cout << "u32 pairs : gpu " << gpuMkeysPerSecond(Context, Sorter, Keys32, RadixKeyType::Uint32, true, Iterations)
+				  << " Mkeys/s" << std::endl;
+		std::cout << "u64 keys  : gpu " << gpuMkeysPerSecond(Context, Sorter, Keys64, RadixKeyType::Uint64, false, Iterations)
+				  << " Mkeys/s, std::sort " << hostMkeysPerSecond(Keys64, 1) << " Mkeys/s, " << NumThreads << " threads "
+				  << hostMkeysPerSecond(Keys64, NumThreads) << " Mkeys/s" << std::endl;
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
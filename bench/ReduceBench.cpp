@@ -0,0 +1,153 @@
+// Reductions on the GPU (Reducer, one scalar read back) against reading the whole buffer back
+// and reducing it on the host, which is what the demos did so far. Results are cross-checked.
+// Usage: ReduceBench [--elements N] [--iterations N] [--device N]
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "Reducer.h"
+
+namespace
+{
+	using kernels::ReduceOp;
+
+	template <typename T>
+	ReduceResult<T> reduceOnHost(const std::vector<T>& Data, ReduceOp Op)
+	{
+		ReduceResult<T> Result;
+		if (Op == ReduceOp::Sum)
+		{
+			// Integer sums wrap like on the GPU, float sums are accumulated in double as the reference
+			using Accumulator = typename std::conditional<std::is_floating_point<T>::value, double, T>::type;
+			Result.Value = static_cast<T>(std::accumulate(Data.begin(), Data.end(), Accumulator(0)));
+			return Result;
+		}
+		// min_element / max_element keep the first of equal elements, like the shaders
+		const bool bMin = Op == ReduceOp::Min || Op == ReduceOp::ArgMin;
+		const auto Found = bMin ? std::min_element(Data.begin(), Data.end()) : std::max_element(Data.begin(), Data.end());
+		Result.Value = *Found;
+		Result.Index = static_cast<uint32_t>(Found - Data.begin());
+		return Result;
+	}
+
+	template <typename T>
+	void compare(ComputeContext& Context, Reducer& Reduce, const ComputeBuffer& Buffer, const std::vector<T>& Data,
+				 ReduceOp Op, const char* Name, uint32_t Iterations)
+	{
+		ReduceResult<T> Gpu = Reduce.reduce<T>(Buffer, Data.size(), Op);
+		std::vector<double> GpuSamples;
+		for (uint32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			const auto Start = bench::Clock::now();
+			Gpu = Reduce.reduce<T>(Buffer, Data.size(), Op);
+			GpuSamples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+		}
+
+		std::vector<T> ReadBack(Data.size());
+		ReduceResult<T> Host;
+		std::vector<double> HostSamples;
+		for (uint32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			const auto Start = bench::Clock::now();
+			Context.readBuffer(Buffer, ReadBack.data(), Data.size() * sizeof(T));
+			Host = reduceOnHost(ReadBack, Op);
+			HostSamples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+		}
+
+		// Exact for the integer data below, float sums round differently in a tree than in a loop
+		const bool bArg = Op == ReduceOp::ArgMin || Op == ReduceOp::ArgMax;
+		const double Tolerance = std::is_floating_point<T>::value && Op == ReduceOp::Sum ? 1e-6 * 128.0 * Data.size() : 0.0;
+		if (std::abs(double(Gpu.Value) - double(Host.Value)) > Tolerance || (bArg && Gpu.Index != Host.Index))
+		{
+			throw std::runtime_error(std::string(Name) + " differs between the GPU and the host");
+		}
+		const double Bytes = double(Data.size()) * sizeof(T);
+		const double GpuMicroseconds = bench::summarize(GpuSamples).P50;
+		const double HostMicroseconds = bench::summarize(HostSamples).P50;
+		std::cout << Name << " : gpu " << GpuMicroseconds << " us (" << Bytes / GpuMicroseconds * 1e-3 << " GB/s), readback + host "
+				  << HostMicroseconds << " us (" << Bytes / HostMicroseconds * 1e-3 << " GB/s)" << std::endl;
+	}
+
+	template <typename T>
+	void run(ComputeContext& Context, Reducer& Reduce, const std::vector<T>& Data, const char* TypeName, uint32_t Iterations)
+	{
+		const vk::DeviceSize BufferSize = Data.size() * sizeof(T);
+		ComputeBuffer Buffer = Context.createBuffer(BufferSize);
+		try
+		{
+			Context.writeBuffer(Buffer, Data.data(), BufferSize);
+			const std::pair<ReduceOp, const char*> Ops[] = {
+				{ ReduceOp::Sum, "Sum" }, { ReduceOp::Min, "Min" }, { ReduceOp::Max, "Max" },
+				{ ReduceOp::ArgMin, "ArgMin" }, { ReduceOp::ArgMax, "ArgMax" }
+			};
+			for (const auto& Op : Ops)
+			{
+				compare(Context, Reduce, Buffer, Data, Op.first, (std::string(Op.second) + "." + TypeName).c_str(), Iterations);
+			}
+		}
+		catch (...)
+		{
+			Context.destroyBuffer(Buffer);
+			throw;
+		}
+		Context.destroyBuffer(Buffer);
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint64_t NumElements = bench::argValue(Argc, Argv, "elements", 64 * 1024 * 1024 + 17);
+		const uint32_t Iterations = static_cast<uint32_t>(bench::argValue(Argc, Argv, "iterations", 5));
+		ContextOptions Options;
+		Options.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(Options);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		std::cout << "Elements       : " << NumElements << std::endl;
+		Reducer Reduce(Context);
+
+		// Byte sized values keep the float sums exact enough, the uint32 sum wraps on both sides
+		std::vector<uint32_t> DataU32(NumElements);
+		for (uint64_t I = 0; I < NumElements; ++I)
+		{
+			DataU32[I] = static_cast<uint32_t>(I * 2654435761u) >> 24;
+		}
+		run(Context, Reduce, DataU32, "u32", Iterations);
+
+		std::vector<int32_t> DataI32(DataU32.begin(), DataU32.end());
+		for (int32_t& Value : DataI32)
+		{
+			Value -= 128;
+		}
+		run(Context, Reduce, DataI32, "i32", Iterations);
+
+		const std::vector<float> DataF32(DataI32.begin(), DataI32.end());
+		run(Context, Reduce, DataF32, "f32", Iterations);
+
+		if (Reducer::isSupported(Context, kernels::ReduceType::Float64))
+		{
+			const std::vector<double> DataF64(DataI32.begin(), DataI32.end());
+			run(Context, Reduce, DataF64, "f64", Iterations);
+		}
+		else
+		{
+			std::cout << "f64 : skipped, no shaderFloat64" << std::endl;
+		}
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,113 @@
+// Prefix sums with Scanner, single-pass look-back against reduce-then-scan, for inclusive,
+// exclusive and segmented scans. Every result is checked against the host.
+// The single-pass scan is skipped on devices without known forward progress unless --force 1.
+// Usage: ScanBench [--elements N] [--iterations N] [--segment N] [--force 1] [--device N]
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "Scanner.h"
+
+namespace
+{
+	std::vector<uint32_t> scanOnHost(const std::vector<uint32_t>& Data, const std::vector<uint32_t>* Heads, bool bExclusive)
+	{
+		std::vector<uint32_t> Result(Data.size());
+		uint32_t Sum = 0;
+		for (size_t I = 0; I < Data.size(); ++I)
+		{
+			if (Heads && (*Heads)[I] != 0)
+			{
+				Sum = 0;
+			}
+			Result[I] = bExclusive ? Sum : Sum + Data[I];
+			Sum += Data[I];
+		}
+		return Result;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint64_t NumElements = bench::argValue(Argc, Argv, "elements", 32 * 1024 * 1024 + 5);
+		const uint32_t Iterations = static_cast<uint32_t>(bench::argValue(Argc, Argv, "iterations", 10));
+		const uint64_t SegmentLength = std::max<uint64_t>(bench::argValue(Argc, Argv, "segment", 1000), 1);
+		const bool bForce = bench::argValue(Argc, Argv, "force", 0) != 0;
+		ContextOptions Options;
+		Options.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(Options);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		std::cout << "Elements       : " << NumElements << std::endl;
+		Scanner Scan(Context);
+
+		std::vector<uint32_t> Data(NumElements);
+		std::vector<uint32_t> Heads(NumElements);
+		for (uint64_t I = 0; I < NumElements; ++I)
+		{
+			Data[I] = static_cast<uint32_t>(I * 2654435761u) >> 28;
+			Heads[I] = I % SegmentLength == 0 ? 1 : 0;
+		}
+		const vk::DeviceSize BufferSize = NumElements * sizeof(uint32_t);
+		ComputeBuffer Input = Context.createBuffer(BufferSize);
+		ComputeBuffer Output = Context.createBuffer(BufferSize);
+		ComputeBuffer HeadFlags = Context.createBuffer(BufferSize);
+		Context.writeBuffer(Input, Data.data(), BufferSize);
+		Context.writeBuffer(HeadFlags, Heads.data(), BufferSize);
+
+		std::vector<std::pair<ScanAlgorithm, const char*>> Algorithms = { { ScanAlgorithm::ReduceThenScan, "reduce-then-scan" } };
+		if (bForce || Scanner::hasForwardProgress(Context.getDeviceProperties()))
+		{
+			Algorithms.insert(Algorithms.begin(), { ScanAlgorithm::SinglePass, "single-pass" });
+		}
+		std::vector<uint32_t> Result(NumElements);
+		for (const auto& Algorithm : Algorithms)
+		{
+			for (int Variant = 0; Variant < 3; ++Variant)
+			{
+				ScanOptions ScanOpts;
+				ScanOpts.Algorithm = Algorithm.first;
+				ScanOpts.bExclusive = Variant == 1;
+				ScanOpts.HeadFlags = Variant == 2 ? &HeadFlags : nullptr;
+				const char* VariantName = Variant == 0 ? "inclusive" : Variant == 1 ? "exclusive" : "segmented";
+
+				Scan.scan(Input, Output, NumElements, ScanOpts);
+				Context.readBuffer(Output, Result.data(), BufferSize);
+				if (Result != scanOnHost(Data, ScanOpts.HeadFlags ? &Heads : nullptr, ScanOpts.bExclusive))
+				{
+					throw std::runtime_error(std::string(Algorithm.second) + " " + VariantName + " scan differs from the host");
+				}
+
+				std::vector<double> Samples;
+				for (uint32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+				{
+					const auto Start = bench::Clock::now();
+					Scan.scan(Input, Output, NumElements, ScanOpts);
+					Samples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+				}
+				const double Microseconds = bench::summarize(Samples).P50;
+				// One read and one write per element, the head flags add a read
+				const double Bytes = double(BufferSize) * (ScanOpts.HeadFlags ? 3 : 2);
+				std::cout << Algorithm.second << " " << VariantName << " : " << Microseconds << " us, "
+						  << Bytes / Microseconds * 1e-3 << " GB/s" << std::endl;
+			}
+		}
+
+		Context.destroyBuffer(Input);
+		Context.destroyBuffer(Output);
+		Context.destroyBuffer(HeadFlags);
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
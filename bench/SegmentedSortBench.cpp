@@ -0,0 +1,227 @@
+// SegmentedSorter against per-segment std::stable_sort, in Mkeys/s, for many small segments of
+// mixed lengths, many tiny segments with a known bound (and with a bound some segments exceed), and
+// a few segments long enough for the merging fallback. Then a merge path merge of two sorted runs against std::merge.
+// Keys come with their original index as the value, every result is checked for order and stability.
+// Usage: SegmentedSortBench [--segments N] [--iterations N] [--device N]
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "SegmentedSorter.h"
+
+namespace
+{
+	double hostMkeysPerSecond(const std::vector<uint32_t>& Keys, const std::vector<uint32_t>& Offsets)
+	{
+		std::vector<uint32_t> Copy = Keys;
+		const auto Start = bench::Clock::now();
+		for (size_t Segment = 0; Segment + 1 < Offsets.size(); ++Segment)
+		{
+			std::stable_sort(Copy.begin() + Offsets[Segment], Copy.begin() + Offsets[Segment + 1]);
+		}
+		return Keys.size() / bench::elapsedMicroseconds(Start, bench::Clock::now());
+	}
+
+	double gpuMkeysPerSecond(ComputeContext& Context, SegmentedSorter& Sorter, const std::vector<uint32_t>& Keys,
+							 const std::vector<uint32_t>& Offsets, uint32_t MaxSegmentLength, uint32_t Iterations)
+	{
+		const vk::DeviceSize KeysSize = Keys.size() * sizeof(uint32_t);
+		const uint32_t NumSegments = static_cast<uint32_t>(Offsets.size() - 1);
+		std::vector<uint32_t> Indices(Keys.size());
+		for (size_t I = 0; I < Indices.size(); ++I)
+		{
+			Indices[I] = static_cast<uint32_t>(I);
+		}
+		ComputeBuffer KeyBuffer = Context.createBuffer(KeysSize);
+		ComputeBuffer ValueBuffer = Context.createBuffer(KeysSize);
+		ComputeBuffer OffsetBuffer = Context.createBuffer(Offsets.size() * sizeof(uint32_t));
+		Context.writeBuffer(OffsetBuffer, Offsets.data(), Offsets.size() * sizeof(uint32_t));
+		SegmentedSortOptions Options;
+		Options.MaxSegmentLength = MaxSegmentLength;
+		std::vector<double> Samples;
+		for (uint32_t Iteration = 0; Iteration <= Iterations; ++Iteration)
+		{
+			Context.writeBuffer(KeyBuffer, Keys.data(), KeysSize);
+			Context.writeBuffer(ValueBuffer, Indices.data(), KeysSize);
+			const auto Start = bench::Clock::now();
+			Sorter.sort(KeyBuffer, Keys.size(), OffsetBuffer, NumSegments, &ValueBuffer, Options);
+			// The first sort creates the pipeline and temporaries
+			if (Iteration > 0)
+			{
+				Samples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+			}
+		}
+
+		std::vector<uint32_t> Sorted(Keys.size());
+		std::vector<uint32_t> Permutation(Keys.size());
+		Context.readBuffer(KeyBuffer, Sorted.data(), KeysSize);
+		Context.readBuffer(ValueBuffer, Permutation.data(), KeysSize);
+		Context.destroyBuffer(KeyBuffer);
+		Context.destroyBuffer(ValueBuffer);
+		Context.destroyBuffer(OffsetBuffer);
+		for (uint32_t Segment = 0; Segment < NumSegments; ++Segment)
+		{
+			for (uint32_t I = Offsets[Segment]; I < Offsets[Segment + 1]; ++I)
+			{
+				const bool bFirst = I == Offsets[Segment];
+				const bool bInSegment = Permutation[I] >= Offsets[Segment] && Permutation[I] < Offsets[Segment + 1];
+				const bool bOrdered = bFirst || Sorted[I - 1] < Sorted[I] || (Sorted[I - 1] == Sorted[I] && Permutation[I - 1] < Permutation[I]);
+				if (!bInSegment || Keys[Permutation[I]] != Sorted[I] || !bOrdered)
+				{
+					throw std::runtime_error("segmented sort result is wrong at key " + std::to_string(I));
+				}
+			}
+		}
+		return Keys.size() / bench::summarize(Samples).P50;
+	}
+
+	void runSegments(ComputeContext& Context, SegmentedSorter& Sorter, const std::vector<uint32_t>& Lengths, uint32_t MaxSegmentLength,
+					 const std::string& Name, uint32_t Iterations, std::mt19937& Random)
+	{
+		std::vector<uint32_t> Offsets = { 0 };
+		for (uint32_t Length : Lengths)
+		{
+			Offsets.push_back(Offsets.back() + Length);
+		}
+		std::vector<uint32_t> Keys(Offsets.back());
+		for (uint32_t& Key : Keys)
+		{
+			// Few distinct values so that stability is actually exercised
+			Key = Random() >> 20;
+		}
+		std::cout << Name << " : " << Lengths.size() << " segments, " << Keys.size() << " keys, gpu "
+				  << gpuMkeysPerSecond(Context, Sorter, Keys, Offsets, MaxSegmentLength, Iterations) << " Mkeys/s, std::stable_sort "
+				  << hostMkeysPerSecond(Keys, Offsets) << " Mkeys/s" << std::endl;
+	}
+
+	void runMerge(ComputeContext& Context, SegmentedSorter& Sorter, uint32_t NumA, uint32_t NumB, uint32_t Iterations, std::mt19937& Random)
+	{
+		std::vector<uint32_t> A(NumA);
+		std::vector<uint32_t> B(NumB);
+		for (uint32_t& Key : A)
+		{
+			Key = Random() >> 8;
+		}
+		for (uint32_t& Key : B)
+		{
+			Key = Random() >> 8;
+		}
+		std::sort(A.begin(), A.end());
+		std::sort(B.begin(), B.end());
+		// Values tell the runs apart, A's are their index and B's have the top bit set
+		std::vector<uint32_t> ValuesA(NumA);
+		std::vector<uint32_t> ValuesB(NumB);
+		for (uint32_t I = 0; I < NumA; ++I)
+		{
+			ValuesA[I] = I;
+		}
+		for (uint32_t I = 0; I < NumB; ++I)
+		{
+			ValuesB[I] = I | 0x80000000u;
+		}
+
+		const uint64_t Total = uint64_t(NumA) + NumB;
+		ComputeBuffer Buffers[6] = { Context.createBuffer(NumA * sizeof(uint32_t)), Context.createBuffer(NumB * sizeof(uint32_t)),
+									 Context.createBuffer(NumA * sizeof(uint32_t)), Context.createBuffer(NumB * sizeof(uint32_t)),
+									 Context.createBuffer(Total * sizeof(uint32_t)), Context.createBuffer(Total * sizeof(uint32_t)) };
+		Context.writeBuffer(Buffers[0], A.data(), NumA * sizeof(uint32_t));
+		Context.writeBuffer(Buffers[1], B.data(), NumB * sizeof(uint32_t));
+		Context.writeBuffer(Buffers[2], ValuesA.data(), NumA * sizeof(uint32_t));
+		Context.writeBuffer(Buffers[3], ValuesB.data(), NumB * sizeof(uint32_t));
+		const SortedRun RunA = { &Buffers[0], &Buffers[2], NumA };
+		const SortedRun RunB = { &Buffers[1], &Buffers[3], NumB };
+		std::vector<double> Samples;
+		for (uint32_t Iteration = 0; Iteration <= Iterations; ++Iteration)
+		{
+			const auto Start = bench::Clock::now();
+			Sorter.merge(RunA, RunB, Buffers[4], &Buffers[5]);
+			if (Iteration > 0)
+			{
+				Samples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+			}
+		}
+		std::vector<uint32_t> Keys(Total);
+		std::vector<uint32_t> Values(Total);
+		Context.readBuffer(Buffers[4], Keys.data(), Total * sizeof(uint32_t));
+		Context.readBuffer(Buffers[5], Values.data(), Total * sizeof(uint32_t));
+		for (ComputeBuffer& Buffer : Buffers)
+		{
+			Context.destroyBuffer(Buffer);
+		}
+
+		// std::merge takes A first on ties as well, so the values must match exactly
+		std::vector<std::pair<uint32_t, uint32_t>> PairsA(NumA);
+		std::vector<std::pair<uint32_t, uint32_t>> PairsB(NumB);
+		for (uint32_t I = 0; I < NumA; ++I)
+		{
+			PairsA[I] = { A[I], ValuesA[I] };
+		}
+		for (uint32_t I = 0; I < NumB; ++I)
+		{
+			PairsB[I] = { B[I], ValuesB[I] };
+		}
+		std::vector<std::pair<uint32_t, uint32_t>> Expected(Total);
+		const auto Start = bench::Clock::now();
+		std::merge(PairsA.begin(), PairsA.end(), PairsB.begin(), PairsB.end(), Expected.begin(),
+				   [](const std::pair<uint32_t, uint32_t>& L, const std::pair<uint32_t, uint32_t>& R) { return L.first < R.first; });
+		const double HostMicroseconds = bench::elapsedMicroseconds(Start, bench::Clock::now());
+		for (uint64_t I = 0; I < Total; ++I)
+		{
+			if (Keys[I] != Expected[I].first || Values[I] != Expected[I].second)
+			{
+				throw std::runtime_error("merge result is wrong at key " + std::to_string(I));
+			}
+		}
+		std::cout << "merge " << NumA << " + " << NumB << " : gpu " << Total / bench::summarize(Samples).P50 << " Mkeys/s, std::merge "
+				  << Total / HostMicroseconds << " Mkeys/s" << std::endl;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint32_t NumSegments = static_cast<uint32_t>(bench::argValue(Argc, Argv, "segments", 16384));
+		const uint32_t Iterations = static_cast<uint32_t>(std::max<uint64_t>(bench::argValue(Argc, Argv, "iterations", 5), 1));
+		ContextOptions Options;
+		Options.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(Options);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		SegmentedSorter Sorter(Context);
+		std::cout << "Shared segment : " << Sorter.getMaxSharedSegment() << std::endl;
+
+		std::mt19937 Random(42);
+		std::vector<uint32_t> Mixed(NumSegments);
+		for (uint32_t& Length : Mixed)
+		{
+			Length = 64 + Random() % (4096 - 64 + 1);
+		}
+		runSegments(Context, Sorter, Mixed, 0, "64-4096 keys", Iterations, Random);
+		runSegments(Context, Sorter, std::vector<uint32_t>(NumSegments, 64), 64, "64 keys bound", Iterations, Random);
+		runSegments(Context, Sorter, std::vector<uint32_t>(NumSegments, 64), 0, "64 keys", Iterations, Random);
+		// A bound that some segments break, those still sort, through the long-segment path
+		std::vector<uint32_t> Outliers(NumSegments, 64);
+		for (uint32_t Segment = 0; Segment < NumSegments; Segment += 1000)
+		{
+			Outliers[Segment] = 5000;
+		}
+		runSegments(Context, Sorter, Outliers, 64, "64 keys bound, some 5000", Iterations, Random);
+		// Empty and single key segments next to ones that take the merging fallback
+		runSegments(Context, Sorter, { 0, 1, 1000003, 5, 300001, 0, 4 * Sorter.getMaxSharedSegment() + 1 }, 0, "long segments", Iterations,
+					Random);
+		runMerge(Context, Sorter, 8 * 1024 * 1024 + 5, 8 * 1024 * 1024 - 3, Iterations, Random);
+		runMerge(Context, Sorter, 1000, 3 * 1024 * 1024, Iterations, Random);
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
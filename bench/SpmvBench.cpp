@@ -0,0 +1,172 @@
+// Sparse matrix-vector products with SparseMultiplier in every format, plus the format Auto picks
+// from the row lengths. Bandwidth is the minimal CSR traffic (values, columns, row offsets, x and y
+// once), so formats are compared on the same work however much padding or gathering they add.
+// Without --matrix two matrices are generated: short uniform rows, and rows with a long tail.
+// Usage: SpmvBench [--matrix file.mtx] [--rows N] [--iterations N] [--device N]
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "SparseMultiplier.h"
+
+namespace
+{
+	const char* formatName(SpmvFormat Format)
+	{
+		switch (Format)
+		{
+		case SpmvFormat::CsrScalar: return "csr-scalar";
+		case SpmvFormat::CsrVector: return "csr-vector";
+		case SpmvFormat::Sell: return "sell";
+		default: return "auto";
+		}
+	}
+
+	// Row lengths from LengthOf(Row, Hash), columns spread over the whole matrix
+	template <typename LengthFn>
+	CsrMatrix generateMatrix(uint32_t Rows, LengthFn LengthOf)
+	{
+		CsrMatrix Matrix;
+		Matrix.Rows = Rows;
+		Matrix.Cols = Rows;
+		Matrix.RowOffsets.reserve(size_t(Rows) + 1);
+		Matrix.RowOffsets.push_back(0);
+		for (uint32_t Row = 0; Row < Rows; ++Row)
+		{
+			const uint32_t Hash = Row * 2654435761u;
+			const uint32_t Length = std::min(LengthOf(Row, Hash), Rows);
+			for (uint32_t J = 0; J < Length; ++J)
+			{
+				Matrix.Columns.push_back(static_cast<uint32_t>((uint64_t(Row) + uint64_t(J) * (Hash | 1)) % Rows));
+				Matrix.Values.push_back(float(int32_t((Hash >> (J % 24)) & 7) - 3) * 0.125f);
+			}
+			Matrix.RowOffsets.push_back(static_cast<uint32_t>(Matrix.Columns.size()));
+		}
+		return Matrix;
+	}
+
+	std::vector<float> spmvOnHost(const CsrMatrix& Matrix, const std::vector<float>& X)
+	{
+		std::vector<float> Y(Matrix.Rows);
+		for (uint32_t Row = 0; Row < Matrix.Rows; ++Row)
+		{
+			double Sum = 0.0;
+			for (uint32_t I = Matrix.RowOffsets[Row]; I < Matrix.RowOffsets[Row + 1]; ++I)
+			{
+				Sum += double(Matrix.Values[I]) * X[Matrix.Columns[I]];
+			}
+			Y[Row] = float(Sum);
+		}
+		return Y;
+	}
+
+	void run(ComputeContext& Context, SparseMultiplier& Multiplier, const CsrMatrix& Matrix, const char* Name, uint32_t Iterations)
+	{
+		const RowLengthStats Stats = computeRowLengthStats(Matrix, Multiplier.getSliceHeight(), Multiplier.getSigma());
+		std::cout << Name << " : " << Matrix.Rows << " x " << Matrix.Cols << ", " << Matrix.getNonZeros() << " non-zeros, rows "
+				  << Stats.Min << ".." << Stats.Max << " (mean " << Stats.Mean << ", stddev " << Stats.StdDev << "), SELL efficiency "
+				  << Stats.getSellEfficiency(Matrix.getNonZeros()) << ", auto picks "
+				  << formatName(Multiplier.chooseFormat(Stats, Matrix.getNonZeros())) << std::endl;
+
+		std::vector<float> X(Matrix.Cols);
+		for (uint32_t I = 0; I < Matrix.Cols; ++I)
+		{
+			X[I] = float(I % 13) * 0.25f - 1.5f;
+		}
+		const std::vector<float> Expected = spmvOnHost(Matrix, X);
+		ComputeBuffer XBuffer = Context.createBuffer(X.size() * sizeof(float));
+		ComputeBuffer YBuffer = Context.createBuffer(size_t(Matrix.Rows) * sizeof(float));
+		Context.writeBuffer(XBuffer, X.data(), X.size() * sizeof(float));
+		const double Bytes = double(Matrix.getNonZeros()) * 8 + (double(Matrix.Rows) + 1) * 4 + double(Matrix.Cols) * 4 + double(Matrix.Rows) * 4;
+
+		std::vector<float> Result(Matrix.Rows);
+		for (SpmvFormat Format : { SpmvFormat::CsrScalar, SpmvFormat::CsrVector, SpmvFormat::Sell, SpmvFormat::Auto })
+		{
+			if (Format == SpmvFormat::Sell && !RadixSorter::isSupported(Context))
+			{
+				std::cout << "  sell : skipped, the row sort needs subgroup ballots" << std::endl;
+				continue;
+			}
+			const auto UploadStart = bench::Clock::now();
+			DeviceSparseMatrix Device = Multiplier.upload(Matrix, Format);
+			const double UploadMicroseconds = bench::elapsedMicroseconds(UploadStart, bench::Clock::now());
+
+			Multiplier.multiply(Device, XBuffer, YBuffer);
+			Context.readBuffer(YBuffer, Result.data(), Result.size() * sizeof(float));
+			for (uint32_t Row = 0; Row < Matrix.Rows; ++Row)
+			{
+				// Summation order differs, so allow rounding relative to the row length
+				const double Length = Matrix.RowOffsets[Row + 1] - Matrix.RowOffsets[Row];
+				if (std::abs(double(Result[Row]) - Expected[Row]) > 1e-5 * (Length + 1) * (std::abs(Expected[Row]) + 1))
+				{
+					Multiplier.destroy(Device);
+					throw std::runtime_error(std::string(formatName(Format)) + " differs from the host in row " + std::to_string(Row));
+				}
+			}
+
+			std::vector<double> Samples;
+			for (uint32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				const auto Start = bench::Clock::now();
+				Multiplier.multiply(Device, XBuffer, YBuffer);
+				Samples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+			}
+			const double Microseconds = bench::summarize(Samples).P50;
+			std::cout << "  " << formatName(Format);
+			if (Format == SpmvFormat::Auto)
+			{
+				std::cout << " (" << formatName(Device.Format) << ")";
+			}
+			std::cout << " : " << Microseconds << " us, " << Bytes / Microseconds * 1e-3 << " GB/s effective, "
+					  << Device.StoredEntries << " stored entries, upload " << UploadMicroseconds * 1e-3 << " ms" << std::endl;
+			Multiplier.destroy(Device);
+		}
+		Context.destroyBuffer(XBuffer);
+		Context.destroyBuffer(YBuffer);
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const std::string MatrixFile = bench::argString(Argc, Argv, "matrix", "");
+		const uint32_t Rows = static_cast<uint32_t>(bench::argValue(Argc, Argv, "rows", 1024 * 1024));
+		const uint32_t Iterations = static_cast<uint32_t>(bench::argValue(Argc, Argv, "iterations", 10));
+		ContextOptions Options;
+		Options.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(Options);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		if (!SparseMultiplier::isSupported(Context))
+		{
+			std::cout << "SpMV needs subgroup arithmetic, skipped" << std::endl;
+			return 0;
+		}
+		SparseMultiplier Multiplier(Context);
+
+		if (!MatrixFile.empty())
+		{
+			run(Context, Multiplier, loadMatrixMarket(MatrixFile), MatrixFile.c_str(), Iterations);
+			return 0;
+		}
+		// 8 to 15 entries per row, like a low order stencil
+		run(Context, Multiplier, generateMatrix(Rows, [](uint32_t, uint32_t Hash) { return 8 + (Hash >> 29); }),
+			"uniform", Iterations);
+		// Mostly 1 to 4 entries, one row in 64 with 64 to 1023, like a graph with hubs
+		run(Context, Multiplier, generateMatrix(Rows, [](uint32_t Row, uint32_t Hash) { return Row % 64 == 0 ? 64 + (Hash >> 22) : 1 + (Hash >> 30); }),
+			"long-tail", Iterations);
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,224 @@
+// Stencils with Stenciler in cells/s: 2D and 3D star stencils, a 5x5 convolution and a wide 3D
+// star, each with one timestep per dispatch against the temporal blocking chooseTile picks.
+// Every configuration is first checked against the host on a small grid with ragged edge tiles.
+// Usage: StencilBench [--size2d N] [--size3d N] [--steps N] [--iterations N] [--device N]
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "Stenciler.h"
+
+namespace
+{
+	using kernels::StencilBoundary;
+	using kernels::StencilShape;
+
+	const char* boundaryName(StencilBoundary Boundary)
+	{
+		return Boundary == StencilBoundary::Clamp ? "clamp" : Boundary == StencilBoundary::Wrap ? "wrap" : "constant";
+	}
+
+	// Weights summing to one, the center keeps the largest
+	std::vector<float> makeCoefficients(const StencilParams& Params)
+	{
+		const uint32_t Count = kernels::getStencilCoefficientCount(Params.Dims, Params.Shape, Params.Radius);
+		const uint32_t Center = Params.Shape == StencilShape::Star ? 0 : Count / 2;
+		std::vector<float> Coefficients(Count, 0.5f / (Count - 1));
+		Coefficients[Center] = 0.5f;
+		return Coefficients;
+	}
+
+	float cellOnHost(const std::vector<float>& Grid, const StencilParams& Params, int64_t X, int64_t Y, int64_t Z)
+	{
+		const int64_t Size[3] = { Params.SizeX, Params.SizeY, Params.SizeZ };
+		int64_t Cell[3] = { X, Y, Z };
+		for (int Axis = 0; Axis < 3; ++Axis)
+		{
+			if (Cell[Axis] >= 0 && Cell[Axis] < Size[Axis])
+			{
+				continue;
+			}
+			if (Params.Boundary == StencilBoundary::Constant)
+			{
+				return Params.BoundaryValue;
+			}
+			Cell[Axis] = Params.Boundary == StencilBoundary::Wrap ? ((Cell[Axis] % Size[Axis]) + Size[Axis]) % Size[Axis]
+																   : std::min(std::max<int64_t>(Cell[Axis], 0), Size[Axis] - 1);
+		}
+		return Grid[size_t((Cell[2] * Size[1] + Cell[1]) * Size[0] + Cell[0])];
+	}
+
+	std::vector<float> stepOnHost(const std::vector<float>& Grid, const StencilParams& Params)
+	{
+		const int64_t R = Params.Radius;
+		const int64_t RZ = Params.Dims == 3 ? R : 0;
+		std::vector<float> Next(Grid.size());
+		size_t Index = 0;
+		for (int64_t Z = 0; Z < Params.SizeZ; ++Z)
+		{
+			for (int64_t Y = 0; Y < Params.SizeY; ++Y)
+			{
+				for (int64_t X = 0; X < Params.SizeX; ++X, ++Index)
+				{
+					double Sum = 0.0;
+					size_t Coefficient = 0;
+					if (Params.Shape == StencilShape::Star)
+					{
+						Sum = double(Params.Coefficients[0]) * cellOnHost(Grid, Params, X, Y, Z);
+						for (uint32_t Axis = 0; Axis < Params.Dims; ++Axis)
+						{
+							for (int64_t Offset = -R; Offset <= R; ++Offset)
+							{
+								if (Offset == 0)
+								{
+									continue;
+								}
+								const size_t Weight = 1 + Axis * 2 * R + (Offset < 0 ? Offset + R : Offset + R - 1);
+								Sum += double(Params.Coefficients[Weight]) *
+									   cellOnHost(Grid, Params, X + (Axis == 0 ? Offset : 0), Y + (Axis == 1 ? Offset : 0), Z + (Axis == 2 ? Offset : 0));
+							}
+						}
+					}
+					else
+					{
+						for (int64_t DZ = -RZ; DZ <= RZ; ++DZ)
+						{
+							for (int64_t DY = -R; DY <= R; ++DY)
+							{
+								for (int64_t DX = -R; DX <= R; ++DX)
+								{
+									Sum += double(Params.Coefficients[Coefficient++]) * cellOnHost(Grid, Params, X + DX, Y + DY, Z + DZ);
+								}
+							}
+						}
+					}
+					Next[Index] = float(Sum);
+				}
+			}
+		}
+		return Next;
+	}
+
+	std::vector<float> makeGrid(const StencilParams& Params)
+	{
+		std::vector<float> Grid(size_t(Params.SizeX) * Params.SizeY * Params.SizeZ);
+		for (size_t I = 0; I < Grid.size(); ++I)
+		{
+			Grid[I] = float(uint32_t(I * 2654435761u) >> 24) / 255.0f;
+		}
+		return Grid;
+	}
+
+	void verify(ComputeContext& Context, Stenciler& Stencil, StencilParams Params, const char* Name)
+	{
+		// Sizes that leave partial tiles on every axis
+		Params.SizeX = 301;
+		Params.SizeY = 203;
+		Params.SizeZ = Params.Dims == 3 ? 37 : 1;
+		const uint32_t Steps = 7;
+		std::vector<float> Expected = makeGrid(Params);
+		const vk::DeviceSize Size = Expected.size() * sizeof(float);
+		ComputeBuffer Grid = Context.createBuffer(Size);
+		ComputeBuffer Scratch = Context.createBuffer(Size);
+		Context.writeBuffer(Grid, Expected.data(), Size);
+		Stencil.apply(Grid, Scratch, Steps, Params);
+		std::vector<float> Result(Expected.size());
+		Context.readBuffer(Grid, Result.data(), Size);
+		Context.destroyBuffer(Grid);
+		Context.destroyBuffer(Scratch);
+		for (uint32_t Step = 0; Step < Steps; ++Step)
+		{
+			Expected = stepOnHost(Expected, Params);
+		}
+		for (size_t I = 0; I < Expected.size(); ++I)
+		{
+			if (std::abs(Result[I] - Expected[I]) > 1e-4f)
+			{
+				throw std::runtime_error(std::string(Name) + " differs from the host at cell " + std::to_string(I));
+			}
+		}
+	}
+
+	void run(ComputeContext& Context, Stenciler& Stencil, StencilParams Params, const char* Name, uint32_t Steps, uint32_t Iterations)
+	{
+		Params.Coefficients = makeCoefficients(Params);
+		const std::vector<float> Data = makeGrid(Params);
+		const vk::DeviceSize Size = Data.size() * sizeof(float);
+		ComputeBuffer Grid = Context.createBuffer(Size);
+		ComputeBuffer Scratch = Context.createBuffer(Size);
+		Context.writeBuffer(Grid, Data.data(), Size);
+
+		for (uint32_t TemporalSteps : { 1u, 0u })
+		{
+			Params.TemporalSteps = TemporalSteps;
+			verify(Context, Stencil, Params, Name);
+			const kernels::StencilTile Tile = Stencil.chooseTile(Params);
+			Stencil.apply(Grid, Scratch, Steps, Params);
+			std::vector<double> Samples;
+			for (uint32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				const auto Start = bench::Clock::now();
+				Stencil.apply(Grid, Scratch, Steps, Params);
+				Samples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+			}
+			const double Microseconds = bench::summarize(Samples).P50;
+			std::cout << Name << " (" << boundaryName(Params.Boundary) << ", tile " << Tile.X << "x" << Tile.Y << "x" << Tile.Z << ", "
+					  << Tile.TemporalSteps << " steps per dispatch) : " << Microseconds << " us, "
+					  << double(Data.size()) * Steps / Microseconds * 1e-3 << " Gcells/s" << std::endl;
+		}
+		Context.destroyBuffer(Grid);
+		Context.destroyBuffer(Scratch);
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint32_t Size2D = static_cast<uint32_t>(bench::argValue(Argc, Argv, "size2d", 4096));
+		const uint32_t Size3D = static_cast<uint32_t>(bench::argValue(Argc, Argv, "size3d", 256));
+		const uint32_t Steps = static_cast<uint32_t>(bench::argValue(Argc, Argv, "steps", 16));
+		const uint32_t Iterations = static_cast<uint32_t>(bench::argValue(Argc, Argv, "iterations", 5));
+		ContextOptions Options;
+		Options.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(Options);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		std::cout << "Timesteps      : " << Steps << std::endl;
+		Stenciler Stencil(Context);
+
+		StencilParams Params2D;
+		Params2D.SizeX = Size2D;
+		Params2D.SizeY = Size2D;
+		run(Context, Stencil, Params2D, "2D 5-point", Steps, Iterations);
+
+		Params2D.Shape = StencilShape::Box;
+		Params2D.Radius = 2;
+		Params2D.Boundary = StencilBoundary::Wrap;
+		run(Context, Stencil, Params2D, "2D 5x5 box", Steps, Iterations);
+
+		StencilParams Params3D;
+		Params3D.Dims = 3;
+		Params3D.SizeX = Size3D;
+		Params3D.SizeY = Size3D;
+		Params3D.SizeZ = Size3D;
+		Params3D.Boundary = StencilBoundary::Constant;
+		Params3D.BoundaryValue = 1.0f;
+		run(Context, Stencil, Params3D, "3D 7-point", Steps, Iterations);
+
+		Params3D.Radius = 4;
+		Params3D.Boundary = StencilBoundary::Clamp;
+		run(Context, Stencil, Params3D, "3D 25-point", Steps, Iterations);
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,74 @@
+// Sustained throughput of the out-of-core StreamingExecutor. The input is generated chunk by
+// chunk on the host so the stream can be far larger than host or device memory.
+// Usage: StreamBench [--op 0=add|1=square] [--total-mb N] [--chunk-elements N] [--sets N] [--device N]
+#include <iostream>
+#include <stdexcept>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "StreamingExecutor.h"
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const StreamOp Op = bench::argValue(Argc, Argv, "op", 0) == 0 ? StreamOp::Add : StreamOp::Square;
+		const uint64_t TotalElements = bench::argValue(Argc, Argv, "total-mb", 4096) * 1024 * 1024 / sizeof(uint32_t);
+		StreamingOptions Options;
+		Options.ChunkElements = bench::argValue(Argc, Argv, "chunk-elements", Options.ChunkElements);
+		Options.NumBufferSets = static_cast<uint32_t>(bench::argValue(Argc, Argv, "sets", Options.NumBufferSets));
+
+		ContextOptions ContextOpts;
+		ContextOpts.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+		// Room for every chunk in flight, inputs and output
+		ContextOpts.StagingRingSize = std::max<vk::DeviceSize>(ContextOpts.StagingRingSize,
+															   Options.NumBufferSets * 2 * Options.ChunkElements * sizeof(uint32_t));
+		ComputeContext Context(ContextOpts);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		std::cout << "Transfer queue : " << (Context.hasTransferQueue() ? "yes" : "no") << std::endl;
+
+		StreamingExecutor Executor(Context, Op, Options);
+		uint64_t Produced = 0;
+		uint64_t Consumed = 0;
+		const StreamingStats Stats = Executor.run(
+			[&](uint32_t* const* Inputs, uint64_t MaxElements)
+			{
+				const uint64_t NumElements = std::min(MaxElements, TotalElements - Produced);
+				for (uint64_t Index = 0; Index < NumElements; ++Index)
+				{
+					const uint32_t Value = static_cast<uint32_t>(Produced + Index);
+					Inputs[0][Index] = Value;
+					if (Op == StreamOp::Add)
+					{
+						Inputs[1][Index] = Value * 3;
+					}
+				}
+				Produced += NumElements;
+				return NumElements;
+			},
+			[&](const uint32_t* Output, uint64_t NumElements)
+			{
+				// Spot check the first element of every chunk
+				const uint32_t Value = static_cast<uint32_t>(Consumed);
+				const uint32_t Expected = Op == StreamOp::Add ? Value + Value * 3 : Value * Value;
+				if (NumElements > 0 && Output[0] != Expected)
+				{
+					throw std::runtime_error("wrong result at element " + std::to_string(Consumed));
+				}
+				Consumed += NumElements;
+			});
+
+		if (Consumed != TotalElements)
+		{
+			throw std::runtime_error("stream lost elements");
+		}
+		std::cout << (Op == StreamOp::Add ? "add" : "square") << " : " << Stats.NumElements << " elements in " << Stats.NumChunks
+				  << " chunks, " << Stats.Seconds << " s, " << Stats.getGigabytesPerSecond() << " GB/s transferred" << std::endl;
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
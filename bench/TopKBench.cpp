@@ -0,0 +1,167 @@
+// TopKSelector against std::nth_element (unsorted) and std::partial_sort (sorted) on the host, in
+// Melements/s of input, for k from 1 to millions, the largest and the smallest floats, and a uint
+// input where many elements tie with the k-th one. Every result is checked against the host: the
+// selected values as a multiset, every index pointing at its value and, when sorted, the order.
+// Usage: TopKBench [--size N] [--iterations N] [--device N]
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "TopKSelector.h"
+
+namespace
+{
+	template <typename T>
+	void check(const std::vector<T>& Input, const TopKResult<T>& Result, uint32_t K, const TopKOptions& Options, const std::string& Name)
+	{
+		std::vector<T> Expected = Input;
+		std::vector<T> Values = Result.Values;
+		if (Options.bLargest)
+		{
+			std::partial_sort(Expected.begin(), Expected.begin() + K, Expected.end(), std::greater<T>());
+			std::sort(Values.begin(), Values.end(), std::greater<T>());
+		}
+		else
+		{
+			std::partial_sort(Expected.begin(), Expected.begin() + K, Expected.end());
+			std::sort(Values.begin(), Values.end());
+		}
+		Expected.resize(K);
+		if (Values != Expected)
+		{
+			throw std::runtime_error(Name + " selects other values than the host");
+		}
+		if (Options.bSorted && Result.Values != Expected)
+		{
+			throw std::runtime_error(Name + " is not sorted");
+		}
+		std::vector<uint32_t> Indices = Result.Indices;
+		for (uint32_t I = 0; I < K; ++I)
+		{
+			if (Indices[I] >= Input.size() || Input[Indices[I]] != Result.Values[I])
+			{
+				throw std::runtime_error(Name + " has a wrong index at " + std::to_string(I));
+			}
+		}
+		std::sort(Indices.begin(), Indices.end());
+		if (std::adjacent_find(Indices.begin(), Indices.end()) != Indices.end())
+		{
+			throw std::runtime_error(Name + " selects an element twice");
+		}
+	}
+
+	template <typename T>
+	void run(TopKSelector& Selector, const ComputeBuffer& Buffer, const std::vector<T>& Input, uint32_t K,
+			 const TopKOptions& Options, const std::string& Name, uint32_t Iterations)
+	{
+		std::vector<T> Copy;
+		std::vector<double> HostSamples;
+		for (uint32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			Copy = Input;
+			const auto Start = bench::Clock::now();
+			if (Options.bSorted && Options.bLargest)
+			{
+				std::partial_sort(Copy.begin(), Copy.begin() + K, Copy.end(), std::greater<T>());
+			}
+			else if (Options.bSorted)
+			{
+				std::partial_sort(Copy.begin(), Copy.begin() + K, Copy.end());
+			}
+			else if (Options.bLargest)
+			{
+				std::nth_element(Copy.begin(), Copy.begin() + (K - 1), Copy.end(), std::greater<T>());
+			}
+			else
+			{
+				std::nth_element(Copy.begin(), Copy.begin() + (K - 1), Copy.end());
+			}
+			HostSamples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+		}
+
+		TopKResult<T> Result;
+		std::vector<double> Samples;
+		for (uint32_t Iteration = 0; Iteration <= Iterations; ++Iteration)
+		{
+			const auto Start = bench::Clock::now();
+			Result = Selector.select<T>(Buffer, Input.size(), K, Options);
+			// The first selection creates the pipelines and result buffers
+			if (Iteration > 0)
+			{
+				Samples.push_back(bench::elapsedMicroseconds(Start, bench::Clock::now()));
+			}
+		}
+		check(Input, Result, K, Options, Name);
+		std::cout << Name << " k " << K << " : gpu " << Input.size() / bench::summarize(Samples).P50 << " Melem/s, host "
+				  << Input.size() / bench::summarize(HostSamples).P50 << " Melem/s (including readback)" << std::endl;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const size_t Size = static_cast<size_t>(bench::argValue(Argc, Argv, "size", 64 * 1024 * 1024 + 5));
+		const uint32_t Iterations = static_cast<uint32_t>(std::max<uint64_t>(bench::argValue(Argc, Argv, "iterations", 5), 1));
+		ContextOptions ContextOpts;
+		ContextOpts.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(ContextOpts);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		TopKSelector Selector(Context);
+
+		std::mt19937 Random(42);
+		std::vector<float> Scores(Size);
+		std::normal_distribution<float> Normal(0.0f, 100.0f);
+		for (float& Score : Scores)
+		{
+			Score = Normal(Random);
+		}
+		ComputeBuffer ScoreBuffer = Context.createBuffer(Size * sizeof(float));
+		Context.writeBuffer(ScoreBuffer, Scores.data(), Size * sizeof(float));
+		for (uint32_t K : { 1u, 100u, 4096u, 100000u, 4000000u })
+		{
+			if (K > Size)
+			{
+				continue;
+			}
+			for (bool bSorted : { false, true })
+			{
+				TopKOptions Options;
+				Options.bSorted = bSorted;
+				run(Selector, ScoreBuffer, Scores, K, Options, bSorted ? "largest floats, sorted" : "largest floats", Iterations);
+			}
+		}
+		TopKOptions Smallest;
+		Smallest.bLargest = false;
+		Smallest.bSorted = true;
+		run(Selector, ScoreBuffer, Scores, static_cast<uint32_t>(std::min<size_t>(1000, Size)), Smallest, "smallest floats, sorted",
+			Iterations);
+		Context.destroyBuffer(ScoreBuffer);
+
+		// 256 distinct values, so the k-th element ties with about Size / 256 others
+		std::vector<uint32_t> Buckets(Size);
+		std::uniform_int_distribution<uint32_t> Bucket(0, 255);
+		for (uint32_t& Value : Buckets)
+		{
+			Value = Bucket(Random) * 0x01010101u;
+		}
+		ComputeBuffer BucketBuffer = Context.createBuffer(Size * sizeof(uint32_t));
+		Context.writeBuffer(BucketBuffer, Buckets.data(), Size * sizeof(uint32_t));
+		run(Selector, BucketBuffer, Buckets, static_cast<uint32_t>(std::min<size_t>(12345, Size)), TopKOptions(), "tied uints",
+			Iterations);
+		Context.destroyBuffer(BucketBuffer);
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,73 @@
+// Runs the workgroup size autotuner for the add and square kernels over a range of element
+// counts and prints every sweep. Results land in cache/workgroup_sizes.txt and are picked up
+// by every later ComputeContext on the same device.
+// Usage: TuneBench [--min-log2 N] [--max-log2 N] [--iterations N] [--device N]
+#include <iostream>
+
+#include "BenchUtils.h"
+#include "ComputeContext.h"
+#include "Kernels.h"
+
+int main(int Argc, char** Argv)
+{
+	try
+	{
+		const uint64_t MinLog2 = bench::argValue(Argc, Argv, "min-log2", 10);
+		const uint64_t MaxLog2 = bench::argValue(Argc, Argv, "max-log2", 24);
+		const uint32_t Iterations = static_cast<uint32_t>(bench::argValue(Argc, Argv, "iterations", 10));
+		ContextOptions Options;
+		Options.DeviceIndex = static_cast<int32_t>(bench::argValue(Argc, Argv, "device", uint64_t(-1)));
+
+		ComputeContext Context(Options);
+		std::cout << "Device Name    : " << Context.getDeviceProperties().deviceName << std::endl;
+		WorkgroupTuner Tuner(Context);
+
+		const ComputeKernel& Add = Context.createKernel(kernels::add());
+		const ComputeKernel& Square = Context.createKernel(kernels::square());
+
+		const uint64_t MaxElements = uint64_t(1) << MaxLog2;
+		ComputeBuffer Buffers[3];
+		for (ComputeBuffer& Buffer : Buffers)
+		{
+			Buffer = Context.createBuffer(MaxElements * sizeof(uint32_t), VMA_MEMORY_USAGE_GPU_ONLY);
+		}
+
+		for (uint64_t Log2 = MinLog2; Log2 <= MaxLog2; ++Log2)
+		{
+			const uint64_t NumElements = uint64_t(1) << Log2;
+			for (const ComputeKernel* Kernel : { &Add, &Square })
+			{
+				ComputeJob Job;
+				Job.Kernel = Kernel;
+				Job.ElementCount = NumElements;
+				if (Kernel == &Add)
+				{
+					Job.Buffers = { &Buffers[0], &Buffers[1], &Buffers[2] };
+				}
+				else
+				{
+					Job.Buffers = { &Buffers[0], &Buffers[1] };
+				}
+
+				const uint32_t BestSize = Tuner.tune(Job, Iterations);
+				std::cout << Kernel->Desc.Name << " 2^" << Log2 << " :";
+				for (const auto& Sample : Tuner.getLastSweep())
+				{
+					std::cout << " " << Sample.first << "=" << Sample.second / 1000.0 << "us";
+				}
+				std::cout << " -> " << BestSize << std::endl;
+			}
+		}
+
+		for (ComputeBuffer& Buffer : Buffers)
+		{
+			Context.destroyBuffer(Buffer);
+		}
+	}
+	catch (const std::exception& Exception)
+	{
+		std::cout << "Error: " << Exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ComputeContext.h"
+#include "Kernels.h"
+#include "Scanner.h"
+
+// What a compaction writes to its args buffer: a VkDispatchIndirectCommand, then the kept count
+constexpr vk::DeviceSize CompactArgsSize = 4 * sizeof(uint32_t);
+constexpr vk::DeviceSize CompactCountOffset = 3 * sizeof(uint32_t);
+
+// Which 32-bit elements a compaction keeps. Comparisons follow the element type, NaNs only pass
+// NotEqual, the bitmask looks at the raw bits
+struct CompactFilter
+{
+	kernels::CompactPredicate Predicate = kernels::CompactPredicate::NonZero;
+	kernels::CompareOp Compare = kernels::CompareOp::Equal;
+	kernels::ElementType Type = kernels::ElementType::Uint;
+	// Bits of the predicate's constants, see kernels::CompactPredicate
+	uint32_t A = 0;
+	uint32_t B = 0;
+
+	// T is uint32_t, int32_t or float
+	template <typename T>
+	static CompactFilter compare(kernels::CompareOp Op, T Value);
+	template <typename T>
+	static CompactFilter range(T Min, T Max);
+	template <typename T>
+	static CompactFilter nonZero();
+	static CompactFilter bitmask(uint32_t Mask, uint32_t Bits);
+};
+
+enum class CompactOrder
+{
+	// Kept elements stay in input order: count per tile, Scanner, scatter
+	Stable,
+	// One dispatch, the order between tiles is arbitrary
+	Unordered
+};
+
+struct CompactOptions
+{
+	CompactOrder Order = CompactOrder::Stable;
+	// The args hold ceil(Count / ElementsPerGroup) workgroups for the job that consumes the output,
+	// 0 for getTileSize()
+	uint32_t ElementsPerGroup = 0;
+};
+
+// copy_if for 32-bit elements: writes the kept elements densely to Output and their count to an
+// args buffer of CompactArgsSize bytes, which a following job can use as its IndirectBuffer.
+// Output needs room for every element. Buffers are bound whole, so they are limited to
+// maxStorageBufferRange. Needs subgroup ballots in compute shaders
+class Compactor
+{
+public:
+	explicit Compactor(ComputeContext& Context);
+	~Compactor();
+
+	Compactor(const Compactor&) = delete;
+	Compactor& operator=(const Compactor&) = delete;
+
+	// Waits and returns the kept count
+	uint32_t compact(const ComputeBuffer& Input, uint64_t NumElements, const ComputeBuffer& Output, const CompactFilter& Filter,
+					 const CompactOptions& Options = CompactOptions());
+	// Runs after Dependencies and after the previous compaction of this Compactor, which shares the status buffer
+	JobTicket compactAsync(const ComputeBuffer& Input, uint64_t NumElements, const ComputeBuffer& Output, const ComputeBuffer& Args,
+						   const CompactFilter& Filter, const CompactOptions& Options = CompactOptions(),
+						   const std::vector<JobTicket>& Dependencies = {});
+	// Compacts the first count of InputArgs elements of Input, e.g. the output of an earlier compaction,
+	// dispatched from InputArgs with no host round trip. At most Capacity elements, unordered only
+	JobTicket compactIndirectAsync(const ComputeBuffer& Input, const ComputeBuffer& InputArgs, uint64_t Capacity, const ComputeBuffer& Output,
+								   const ComputeBuffer& Args, const CompactFilter& Filter, const CompactOptions& Options = CompactOptions(),
+								   const std::vector<JobTicket>& Dependencies = {});
+
+	static bool isSupported(const ComputeContext& Context);
+	uint32_t getTileSize() const;
+
+private:
+	void ensureStatus(vk::DeviceSize Size);
+	ComputeJob makeJob(kernels::CompactMode Mode, const ComputeBuffer& Input, const ComputeBuffer& Output, const ComputeBuffer& Args,
+					   const ComputeBuffer* InputArgs, const CompactFilter& Filter, uint32_t NumElements, uint32_t ElementsPerGroup);
+
+	ComputeContext& Context;
+	Scanner Scan;
+	uint32_t GroupSize = 0;
+	uint32_t SubgroupSlots = 0;
+	// Finished workgroups (unordered) or the kept count per tile (stable)
+	ComputeBuffer Status;
+	// Args of compact(), which only reads the count back
+	ComputeBuffer CountArgs;
+	JobTicket LastJob;
+};
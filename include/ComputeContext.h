@@ -0,0 +1,361 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+#include "vk_mem_alloc.h"
+
+#include "DispatchPlanner.h"
+#include "GpuProfiler.h"
+#include "PipelineCacheFile.h"
+#include "StagingRing.h"
+#include "WorkgroupTuner.h"
+
+struct ContextOptions
+{
+	std::string AppName = "VulkanCompute";
+	// Silently skipped when VK_LAYER_KHRONOS_validation is not installed
+	bool EnableValidation = false;
+	// Index into enumeratePhysicalDevices(), -1 picks the first device with a compute queue
+	int32_t DeviceIndex = -1;
+	uint32_t MaxDescriptorSets = 64;
+	// submitAsync waits for the oldest job once this many are in flight
+	uint32_t MaxJobsInFlight = 16;
+	// Run uploads and downloads on a transfer-only queue family when the device has one
+	bool UseTransferQueue = true;
+	// Time every dispatch and copy with timestamp queries, see getProfiler()
+	bool EnableProfiling = false;
+	// Size of each of the persistently mapped upload and readback staging rings
+	vk::DeviceSize StagingRingSize = 64 * 1024 * 1024;
+	// Tuned workgroup sizes, see WorkgroupTuner
+	std::string GroupSizeCachePath = "cache/workgroup_sizes.txt";
+	// Where the pipeline cache is loaded from and saved to (see PipelineCacheFile), empty disables it
+	std::string PipelineCacheDirectory = "cache";
+};
+
+// A storage buffer allocated through the context's VMA allocator
+struct ComputeBuffer
+{
+	vk::Buffer Buffer;
+	VmaAllocation Allocation = nullptr;
+	vk::DeviceSize Size = 0;
+	// Only set for buffers created with VMA_ALLOCATION_CREATE_MAPPED_BIT
+	uint8_t* Mapped = nullptr;
+};
+
+// Host data copied into Buffer through a staging buffer before the job's dispatch
+struct BufferUpload
+{
+	const ComputeBuffer* Buffer = nullptr;
+	const void* Data = nullptr;
+	vk::DeviceSize Size = 0;
+	vk::DeviceSize Offset = 0;
+};
+
+// Buffer contents copied back to Data through a staging buffer after the job's dispatch
+struct BufferDownload
+{
+	const ComputeBuffer* Buffer = nullptr;
+	void* Data = nullptr;
+	vk::DeviceSize Size = 0;
+	vk::DeviceSize Offset = 0;
+};
+
+// Filled with a repeated 32-bit Value on the compute queue right before the job's dispatch,
+// e.g. to clear counters. Size and Offset are multiples of 4, VK_WHOLE_SIZE fills to the end
+struct BufferFill
+{
+	const ComputeBuffer* Buffer = nullptr;
+	uint32_t Value = 0;
+	vk::DeviceSize Size = VK_WHOLE_SIZE;
+	vk::DeviceSize Offset = 0;
+};
+
+struct KernelDesc
+{
+	std::string Name;
+	std::string SpirvPath;
+	std::string EntryPoint = "main";
+	std::vector<vk::DescriptorSetLayoutBinding> Bindings;
+	uint32_t PushConstantSize = 0;
+	// (constant_id, value) pairs applied to every pipeline of the kernel
+	std::vector<std::pair<uint32_t, uint32_t>> SpecConstants;
+	// Non-zero when the shader takes local_size_x from specialization constant 0
+	// (local_size_x_id = 0), used when nothing was tuned for the job's element count.
+	// Such kernels are elementwise and receive DispatchParams at push constant offset 0
+	uint32_t DefaultGroupSize = 0;
+};
+
+struct ComputeKernel
+{
+	KernelDesc Desc;
+	vk::ShaderModule ShaderModule;
+	vk::DescriptorSetLayout DescriptorSetLayout;
+	vk::PipelineLayout PipelineLayout;
+	// Keyed by workgroup size, 0 for kernels with a fixed size. Created on first use
+	mutable std::map<uint32_t, vk::Pipeline> Pipelines;
+	// Sum of descriptorCount over all bindings
+	uint32_t NumDescriptors = 0;
+
+	bool isGroupSizeTunable() const { return Desc.DefaultGroupSize != 0; }
+};
+
+struct ComputeJob
+{
+	// May be null for a job that only transfers data
+	const ComputeKernel* Kernel = nullptr;
+	// Flattened in binding order, the array elements of one binding are consecutive
+	std::vector<const ComputeBuffer*> Buffers;
+	std::array<uint32_t, 3> GroupCount = { 1, 1, 1 };
+	std::vector<uint8_t> PushConstants;
+	// Tunable (elementwise) kernels only: when set, the dispatch is planned by planDispatch and
+	// GroupCount is ignored. PushConstants then start after the DispatchParams prefix
+	uint64_t ElementCount = 0;
+	// Non-zero binds every slice as its own window of ElementSize byte elements in all buffers,
+	// which lifts the 2^32 element and maxStorageBufferRange limits
+	uint32_t ElementSize = 0;
+	// 0 picks the tuned size for ElementCount, or the kernel's DefaultGroupSize
+	uint32_t GroupSize = 0;
+	// Optional (offset, size) per entry of Buffers, size 0 binds the rest of the buffer. Lets a job
+	// bind a part of a buffer larger than maxStorageBufferRange. Not allowed with ElementSize
+	std::vector<std::pair<vk::DeviceSize, vk::DeviceSize>> BufferRanges;
+	// Optional, dispatches the VkDispatchIndirectCommand at IndirectOffset, written by an earlier job,
+	// instead of GroupCount or the planned grid. Planned kernels get ElementCount in DispatchParams as
+	// an upper bound and read their exact count themselves. Not allowed with ElementSize
+	const ComputeBuffer* IndirectBuffer = nullptr;
+	vk::DeviceSize IndirectOffset = 0;
+	// Recorded into the same command buffer as the dispatch, uploads before and downloads after it
+	std::vector<BufferUpload> Uploads;
+	// Recorded before every dispatch of the job, after the uploads
+	std::vector<BufferFill> Fills;
+	std::vector<BufferDownload> Downloads;
+};
+
+std::vector<uint32_t> readSpirvFile(const std::string& FileName);
+
+class ComputeContext;
+
+// Completion handle of a job returned by ComputeContext::submitAsync, cheap to copy.
+// Only usable while the context that issued it is alive
+class JobTicket
+{
+public:
+	JobTicket() = default;
+
+	bool isValid() const { return Context != nullptr; }
+	// Does not block
+	bool isReady() const;
+	// Returns false when the job did not finish within TimeoutNs
+	bool wait(uint64_t TimeoutNs = UINT64_MAX) const;
+
+private:
+	friend class ComputeContext;
+	JobTicket(ComputeContext* InContext, uint64_t InComputeValue, uint64_t InTransferValue)
+		: Context(InContext), ComputeValue(InComputeValue), TransferValue(InTransferValue) {}
+
+	ComputeContext* Context = nullptr;
+	// The job is done once the compute and transfer queue timelines reached these
+	uint64_t ComputeValue = 0;
+	uint64_t TransferValue = 0;
+};
+
+// Owns everything that is expensive to bring up (instance, device, queue, VMA allocator,
+// pipeline cache, descriptor and command pools) so that many jobs can share it.
+class ComputeContext
+{
+public:
+	explicit ComputeContext(const ContextOptions& Options = ContextOptions());
+	~ComputeContext();
+
+	ComputeContext(const ComputeContext&) = delete;
+	ComputeContext& operator=(const ComputeContext&) = delete;
+
+	// Device-local unless asked otherwise, fill it with writeBuffer or a job's Uploads
+	ComputeBuffer createBuffer(vk::DeviceSize Size, VmaMemoryUsage Usage = VMA_MEMORY_USAGE_GPU_ONLY, VmaAllocationCreateFlags Flags = 0);
+	void destroyBuffer(ComputeBuffer& Buffer);
+	bool isHostVisible(const ComputeBuffer& Buffer) const;
+	// Host visible buffers are copied through their persistent mapping (or mapped for the call),
+	// all others go through a staged transfer and wait for it
+	void writeBuffer(const ComputeBuffer& Buffer, const void* Data, vk::DeviceSize Size, vk::DeviceSize Offset = 0);
+	void readBuffer(const ComputeBuffer& Buffer, void* Data, vk::DeviceSize Size, vk::DeviceSize Offset = 0);
+
+	// Kernels are cached by name, creating the same name twice returns the first kernel
+	const ComputeKernel& createKernel(const KernelDesc& Desc);
+	const ComputeKernel* findKernel(const std::string& Name) const;
+
+	// Records the job's uploads, dispatch and downloads into one submit and waits for it.
+	// The job runs after every job submitted before it
+	void submit(const ComputeJob& Job);
+	// Same as submit but returns right after queuing the job. The job's download Data must stay
+	// valid until its ticket is ready, downloads are copied out once the context sees the job finish.
+	// Jobs start in submission order but may overlap on the GPU, pass the tickets of the jobs whose
+	// results this one reads (or whose inputs it overwrites) as Dependencies.
+	// Not thread safe, one host thread drives the context
+	JobTicket submitAsync(const ComputeJob& Job, const std::vector<JobTicket>& Dependencies = {});
+	// Waits for every job submitted so far
+	void waitIdle();
+	size_t getJobsInFlight() const { return InFlightJobs.size(); }
+	// Average GPU time of one dispatch in nanoseconds over Iterations back to back dispatches,
+	// the job's transfers are not recorded.
+	// Falls back to host timing when the compute queue has no timestamp support
+	double timeJob(const ComputeJob& Job, uint32_t Iterations);
+
+	uint32_t resolveGroupSize(const ComputeJob& Job) const;
+	vk::Pipeline getPipeline(const ComputeKernel& Kernel, uint32_t GroupSize);
+	WorkgroupSizeCache& getGroupSizeCache() { return GroupSizeCache; }
+	// Null unless ContextOptions::EnableProfiling, timings of a job show up once it completed
+	const GpuProfiler* getProfiler() const { return Profiler.get(); }
+	GpuProfiler* getProfiler() { return Profiler.get(); }
+
+	vk::Instance getInstance() const { return Instance; }
+	vk::PhysicalDevice getPhysicalDevice() const { return PhysicalDevice; }
+	const vk::PhysicalDeviceProperties& getDeviceProperties() const { return DeviceProps; }
+	// Optional features (shaderFloat64, shaderInt64) are enabled whenever the device has them
+	const vk::PhysicalDeviceFeatures& getDeviceFeatures() const { return DeviceFeatures; }
+	// Atomics on 64-bit integers in storage buffers, enabled whenever the device has them and shaderInt64
+	bool hasBufferInt64Atomics() const { return bBufferInt64Atomics; }
+	const vk::PhysicalDeviceSubgroupProperties& getSubgroupProperties() const { return SubgroupProps; }
+	vk::Device getDevice() const { return Device; }
+	vk::Queue getComputeQueue() const { return Compute.Queue; }
+	uint32_t getComputeQueueFamilyIndex() const { return Compute.FamilyIndex; }
+	bool hasTransferQueue() const { return bool(Transfer.Queue); }
+	vk::Queue getTransferQueue() const { return Transfer.Queue; }
+	uint32_t getTransferQueueFamilyIndex() const { return Transfer.FamilyIndex; }
+	VmaAllocator getAllocator() const { return Allocator; }
+	vk::PipelineCache getPipelineCache() const { return PipelineCache; }
+	// Empty when the pipeline cache is not persisted
+	std::string getPipelineCachePath() const { return PipelineCacheStore ? PipelineCacheStore->getPath() : std::string(); }
+	// Also done by the destructor. Returns false when nothing was written
+	bool savePipelineCache();
+
+private:
+	friend class JobTicket;
+
+	// Descriptor sets and dispatch slices of one job between recording and completion
+	struct PreparedJob
+	{
+		uint32_t GroupSize = 0;
+		bool bWindowed = false;
+		std::vector<DispatchSlice> Slices;
+		// One per slice when windowed, otherwise a single set
+		std::vector<vk::DescriptorSet> DescriptorSets;
+		// One per upload followed by one per download, from the staging rings when they have room
+		std::vector<StagingRegion> Staging;
+		std::vector<ComputeBuffer> DedicatedStaging;
+	};
+
+	// One queue with its own command buffers and timeline semaphore, every submission to it
+	// signals the next value of its timeline
+	struct QueueState
+	{
+		vk::Queue Queue;
+		uint32_t FamilyIndex = 0;
+		vk::CommandPool CommandPool;
+		std::vector<vk::CommandBuffer> FreeCommandBuffers;
+		vk::Semaphore Timeline;
+		uint64_t TimelineValue = 0;
+		uint64_t CompletedValue = 0;
+		uint32_t ProfileSlot = 0;
+	};
+
+	struct TimelineWait
+	{
+		const QueueState* Queue = nullptr;
+		uint64_t Value = 0;
+	};
+
+	struct SubmittedCommands
+	{
+		QueueState* Queue = nullptr;
+		vk::CommandBuffer Cmd;
+		uint32_t ProfileSlab = GpuProfiler::NoSlab;
+	};
+
+	// The submitted command buffers of a job and everything they use, recycled once the job is done
+	struct InFlightJob
+	{
+		// Submission order of jobs, staging regions retire against it
+		uint64_t Serial = 0;
+		uint64_t ComputeValue = 0;
+		uint64_t TransferValue = 0;
+		std::vector<SubmittedCommands> Cmds;
+		PreparedJob Prepared;
+		std::vector<BufferDownload> Downloads;
+	};
+
+	// WindowRange == 0 binds the buffers whole, or the job's BufferRanges when it has them
+	vk::DescriptorSet allocateDescriptorSet(const ComputeJob& Job, vk::DeviceSize WindowOffset, vk::DeviceSize WindowRange);
+	PreparedJob prepareJob(const ComputeJob& Job);
+	StagingRegion acquireStaging(StagingRing& Ring, vk::DeviceSize Size, VmaMemoryUsage Usage, uint64_t RetireValue, PreparedJob& Prepared);
+	void releaseJob(PreparedJob& Prepared);
+	// Everything on the compute queue, used without a transfer queue or for jobs without transfers
+	void recordJob(vk::CommandBuffer Cmd, const ComputeJob& Job, const PreparedJob& Prepared);
+	void recordUploads(vk::CommandBuffer Cmd, const ComputeJob& Job, const PreparedJob& Prepared);
+	void recordDownloads(vk::CommandBuffer Cmd, const ComputeJob& Job, const PreparedJob& Prepared);
+	void recordDispatch(vk::CommandBuffer Cmd, const ComputeJob& Job, const PreparedJob& Prepared);
+	// Uploads on the transfer queue, dispatch on the compute queue and downloads back on the transfer
+	// queue, handing the buffers over with queue family ownership transfers and timeline waits
+	void submitSplitJob(const ComputeJob& Job, InFlightJob& InFlight, const std::vector<TimelineWait>& Waits);
+	// Records into a recycled command buffer of Queue and submits it after Waits. Returns the timeline
+	// value the submission signals, the command buffer is added to InFlight.Cmds. Submissions to the
+	// compute queue first acquire the buffers of Job that a download handed to the transfer queue
+	uint64_t submitCommands(QueueState& Queue, const ComputeJob& Job, const std::function<void(vk::CommandBuffer)>& Record,
+							std::vector<TimelineWait> Waits, InFlightJob& InFlight);
+	void takePendingAcquires(const ComputeJob& Job, std::vector<vk::BufferMemoryBarrier>& Acquires, std::vector<TimelineWait>& Waits);
+	JobTicket trackJob(InFlightJob&& InFlight);
+	// For jobs that failed half way, waits for whatever part of it was submitted
+	void abandonJob(InFlightJob& InFlight);
+	void recycleJob(InFlightJob& InFlight);
+	// Copies the downloads out of their staging buffers once the job finished
+	void completeJob(const std::vector<BufferDownload>& Downloads, const PreparedJob& Prepared);
+	// Returns false on timeout, otherwise completes and recycles every finished job
+	bool waitForJob(uint64_t ComputeValue, uint64_t TransferValue, uint64_t TimeoutNs);
+	void waitForOldestJob();
+	void updateCompletedValues();
+	void collectCompleted();
+	void destroyKernel(ComputeKernel& Kernel);
+
+	vk::Instance Instance;
+	vk::PhysicalDevice PhysicalDevice;
+	vk::PhysicalDeviceProperties DeviceProps;
+	vk::PhysicalDeviceFeatures DeviceFeatures;
+	bool bBufferInt64Atomics = false;
+	vk::PhysicalDeviceSubgroupProperties SubgroupProps;
+	vk::Device Device;
+	uint32_t TimestampValidBits = 0;
+	QueueState Compute;
+	// Queue is null when the device has no transfer-only queue family or it is disabled
+	QueueState Transfer;
+	VmaAllocator Allocator = nullptr;
+	vk::PipelineCache PipelineCache;
+	std::unique_ptr<PipelineCacheFile> PipelineCacheStore;
+	// Pipelines were created since the cache was loaded or saved
+	bool bPipelineCacheDirty = false;
+	vk::DescriptorPool DescriptorPool;
+	uint32_t MaxJobsInFlight = 0;
+	uint64_t JobSerial = 0;
+	uint64_t CompletedJobSerial = 0;
+	std::deque<InFlightJob> InFlightJobs;
+	// Buffer ranges the transfer queue released back after a download, the next compute submission
+	// using the buffer acquires them once the transfer timeline reached TransferValue
+	struct PendingAcquire
+	{
+		vk::BufferMemoryBarrier Barrier;
+		uint64_t TransferValue = 0;
+	};
+	std::vector<PendingAcquire> PendingAcquires;
+	std::unique_ptr<GpuProfiler> Profiler;
+	std::unique_ptr<StagingRing> UploadRing;
+	std::unique_ptr<StagingRing> ReadbackRing;
+
+	std::unordered_map<std::string, std::unique_ptr<ComputeKernel>> Kernels;
+	WorkgroupSizeCache GroupSizeCache;
+};
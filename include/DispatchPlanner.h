@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+// Push constant prefix of every elementwise kernel, mirrors shaders/dispatch.glsl.
+// Kernel specific push constants follow at offset sizeof(DispatchParams)
+struct DispatchParams
+{
+	uint32_t IndexOffset = 0;	// Added to the slice-local index, 0 when the slice is bound as its own window
+	uint32_t ElementCount = 0;	// Elements covered by this slice
+	uint32_t GroupCountX = 0;	// Grid shape, HLSL has no SV_ equivalent of gl_NumWorkGroups
+	uint32_t GroupCountY = 0;
+};
+
+// One vkCmdDispatch of a logical elementwise dispatch
+struct DispatchSlice
+{
+	uint64_t FirstElement = 0;
+	uint32_t ElementCount = 0;
+	std::array<uint32_t, 3> GroupCount = { 1, 1, 1 };
+};
+
+// Splits ElementCount elements into slices of at most 2^31 elements whose workgroups are folded
+// into a grid that respects maxComputeWorkGroupCount. A non-zero ElementSize means every slice is
+// bound as its own buffer window, so slices are also capped at maxStorageBufferRange and the
+// total is unbounded. With ElementSize == 0 the buffers are bound whole and the element count must
+// fit in 32 bits.
+std::vector<DispatchSlice> planDispatch(uint64_t ElementCount, uint32_t GroupSize, uint32_t ElementSize, const vk::PhysicalDeviceLimits& Limits);
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "ComputeContext.h"
+
+enum class FftDirection
+{
+	// exp(-2 pi i j k / N)
+	Forward,
+	// exp(+2 pi i j k / N)
+	Inverse
+};
+
+enum class FftNormalization
+{
+	// Only the inverse is scaled, by 1 / N, so a round trip restores the input
+	Backward,
+	// Both directions are scaled by 1 / sqrt(N)
+	Orthonormal,
+	None
+};
+
+// Batch transforms of SizeX points, or of SizeY rows of SizeX points each for 2D, stored one after
+// the other as interleaved complex floats (std::complex<float>), x fastest. Sizes are products of
+// 2, 3 and 5
+struct FftParams
+{
+	uint32_t SizeX = 0;
+	// 1 for 1D transforms
+	uint32_t SizeY = 1;
+	uint32_t Batch = 1;
+	FftDirection Direction = FftDirection::Forward;
+	FftNormalization Normalization = FftNormalization::Backward;
+};
+
+// Batched complex FFTs with the Stockham auto-sort algorithm. Transforms of up to getMaxSharedSize()
+// points run entirely in shared memory, one read and one write per point. Larger ones take one
+// dispatch per radix pass through global memory. Twiddle tables are computed in double precision
+// once per size and kept. The data is bound whole, so it is limited to maxStorageBufferRange
+class FourierTransformer
+{
+public:
+	explicit FourierTransformer(ComputeContext& Context);
+	~FourierTransformer();
+
+	FourierTransformer(const FourierTransformer&) = delete;
+	FourierTransformer& operator=(const FourierTransformer&) = delete;
+
+	// Transforms Data in place. Scratch, of Data's size, is only used by sizes beyond
+	// getMaxSharedSize() and may be null otherwise
+	void transform(const ComputeBuffer& Data, const ComputeBuffer* Scratch, const FftParams& Params);
+	JobTicket transformAsync(const ComputeBuffer& Data, const ComputeBuffer* Scratch, const FftParams& Params,
+							 const std::vector<JobTicket>& Dependencies = {});
+
+	uint32_t getMaxSharedSize() const;
+	static bool isSupportedSize(uint32_t N);
+
+private:
+	// How one axis of the data splits into signals, mirrors the push constants of the shaders
+	struct AxisLayout
+	{
+		uint32_t N;
+		uint32_t NumSignals;
+		uint32_t ElementStride;
+		uint32_t InnerCount;
+		uint32_t InnerStride;
+		uint32_t OuterStride;
+	};
+
+	const ComputeBuffer& getTwiddles(uint32_t N);
+	JobTicket transformAxis(const ComputeBuffer& Data, const ComputeBuffer* Scratch, const AxisLayout& Axis, const FftParams& Params,
+							const std::vector<JobTicket>& Dependencies);
+
+	ComputeContext& Context;
+	uint32_t Threads = 0;
+	// W_N^m for m < N, keyed by N
+	std::map<uint32_t, ComputeBuffer> Twiddles;
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+struct GpuTimingStats
+{
+	uint64_t Count = 0;
+	double TotalNs = 0.0;
+	double MinNs = 0.0;
+	double MaxNs = 0.0;
+
+	double getMeanNs() const { return Count > 0 ? TotalNs / Count : 0.0; }
+	void add(double Ns);
+};
+
+enum class ProfileCategory
+{
+	Kernel,
+	Upload,
+	Download
+};
+
+// Timestamp queries around the dispatches and copies the context records. Every profiled command
+// buffer takes a slab of queries from its queue's pool, the slab is read back and returned once
+// the command buffer completed. Queues whose family has timestampValidBits == 0 are not profiled,
+// and queue latency (submit to start of execution) needs VK_EXT_calibrated_timestamps.
+// Driven by ComputeContext, which is single threaded, so the profiler is too
+class GpuProfiler
+{
+public:
+	static constexpr uint32_t NoSlab = UINT32_MAX;
+	static constexpr uint32_t NoScope = UINT32_MAX;
+
+	// True when the device can report its timestamp counter next to a submission
+	static bool supportsCalibratedTimestamps(vk::Instance Instance, vk::PhysicalDevice PhysicalDevice);
+
+	// bHostQueryReset: the hostQueryReset feature is enabled, needed to profile transfer-only queues.
+	// bCalibratedTimestamps: VK_EXT_calibrated_timestamps is enabled on Device
+	GpuProfiler(vk::PhysicalDevice PhysicalDevice, vk::Device Device, bool bHostQueryReset, bool bCalibratedTimestamps);
+	~GpuProfiler();
+
+	GpuProfiler(const GpuProfiler&) = delete;
+	GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+	// Returns the slot to pass to beginCommands
+	uint32_t addQueue(uint32_t FamilyIndex, vk::QueueFlags QueueFlags);
+
+	// Right after Cmd.begin(), returns NoSlab when the queue cannot be profiled or all slabs are in flight
+	uint32_t beginCommands(uint32_t QueueSlot, vk::CommandBuffer Cmd);
+	// Scopes go to the command buffer between beginCommands and endCommands, no-ops outside of it
+	uint32_t beginScope(vk::CommandBuffer Cmd, ProfileCategory Category, const std::string& Name);
+	void endScope(vk::CommandBuffer Cmd, uint32_t Scope);
+	void endCommands();
+	// Right before the command buffer is submitted
+	void markSubmitted(uint32_t Slab);
+	// Once the command buffer completed, adds its timings to the stats and frees the slab
+	void resolve(uint32_t Slab);
+	// For command buffers that were never submitted
+	void discard(uint32_t Slab);
+
+	const std::map<std::string, GpuTimingStats>& getKernelStats() const { return KernelStats; }
+	const GpuTimingStats& getUploadStats() const { return UploadStats; }
+	const GpuTimingStats& getDownloadStats() const { return DownloadStats; }
+	// Empty without calibrated timestamps
+	const GpuTimingStats& getQueueLatencyStats() const { return QueueLatencyStats; }
+	// Scopes lost because their command buffer ran out of queries
+	uint64_t getDroppedScopes() const { return DroppedScopes; }
+	void resetStats();
+	void report(std::ostream& Out) const;
+
+private:
+	struct Scope
+	{
+		ProfileCategory Category;
+		std::string Name;
+		// Begin query, the end query follows it
+		uint32_t Query;
+	};
+
+	struct Slab
+	{
+		uint32_t QueueSlot = 0;
+		uint32_t FirstQuery = 0;
+		// Query FirstQuery marks the start of the command buffer
+		uint32_t NumQueries = 0;
+		std::vector<Scope> Scopes;
+		bool bHasSubmitTime = false;
+		uint64_t SubmitTime = 0;
+	};
+
+	struct QueueSlot
+	{
+		vk::QueryPool QueryPool;
+		uint64_t ValidMask = 0;
+		// Without host query reset the pool is reset from the command buffer, compute queues only
+		bool bHostReset = false;
+		std::vector<uint32_t> FreeSlabs;
+	};
+
+	double ticksToNs(const QueueSlot& Queue, uint64_t Begin, uint64_t End) const;
+	void freeSlab(uint32_t Slab);
+
+	vk::PhysicalDevice PhysicalDevice;
+	vk::Device Device;
+	double TimestampPeriod = 1.0;
+	bool bHostQueryReset = false;
+	PFN_vkGetCalibratedTimestampsEXT GetCalibratedTimestamps = nullptr;
+
+	std::vector<QueueSlot> Queues;
+	std::vector<Slab> Slabs;
+	uint32_t ActiveSlab = NoSlab;
+
+	std::map<std::string, GpuTimingStats> KernelStats;
+	GpuTimingStats UploadStats;
+	GpuTimingStats DownloadStats;
+	GpuTimingStats QueueLatencyStats;
+	uint64_t DroppedScopes = 0;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ComputeContext.h"
+#include "Kernels.h"
+
+struct AggregateColumn
+{
+	// 32-bit values, one per row. May be null for Count
+	const ComputeBuffer* Values = nullptr;
+	kernels::ElementType Type = kernels::ElementType::Float;
+	kernels::AggregateOp Op = kernels::AggregateOp::Sum;
+};
+
+enum class GroupByStrategy
+{
+	// Shared unless ExpectedGroups is more than half of getSharedSlots()
+	Auto,
+	// Every workgroup aggregates into a table in shared memory and merges it into the global table
+	// once, rows whose key finds no shared slot go to the global table directly. Best when few
+	// groups take many rows each
+	Shared,
+	// One global atomic per row and column, best when most groups are small
+	Global
+};
+
+struct GroupByOptions
+{
+	GroupByStrategy Strategy = GroupByStrategy::Auto;
+	// Estimate of the distinct keys for Auto, 0 when unknown
+	uint32_t ExpectedGroups = 0;
+};
+
+struct GroupByResult
+{
+	std::vector<uint32_t> Keys;
+	// Rows per group
+	std::vector<uint32_t> Counts;
+	// One vector per column, aligned with Keys
+	std::vector<std::vector<double>> Aggregates;
+};
+
+// Hash group-by of up to kernels::GroupByMaxColumns value columns by uint keys, all resident in
+// device buffers. Groups are kept in an open addressing table of 2 * MaxGroups slots in device
+// memory, then written densely as rows of key, count and one 32-bit word per column, which is all
+// aggregate() reads back. Sums, averages and float additions happen in 32 bits in no particular
+// order. The key 0xffffffff cannot be grouped. Buffers are bound whole, so they are limited to
+// maxStorageBufferRange
+class GroupByAggregator
+{
+public:
+	GroupByAggregator(ComputeContext& Context, uint32_t MaxGroups);
+	~GroupByAggregator();
+
+	GroupByAggregator(const GroupByAggregator&) = delete;
+	GroupByAggregator& operator=(const GroupByAggregator&) = delete;
+
+	// Groups in no particular order. Throws when there are more than MaxGroups
+	GroupByResult aggregate(const ComputeBuffer& Keys, uint32_t NumRows, const std::vector<AggregateColumn>& Columns,
+							const GroupByOptions& Options = GroupByOptions());
+	// Writes getGroupCount() rows of 2 + Columns.size() words to Output: the key, the count and the
+	// aggregates in their column type, averages as floats. Output needs room for MaxGroups rows.
+	// Runs after Dependencies and after the previous aggregation of this GroupByAggregator, which shares the table
+	JobTicket aggregateAsync(const ComputeBuffer& Keys, uint32_t NumRows, const std::vector<AggregateColumn>& Columns, const ComputeBuffer& Output,
+							 const GroupByOptions& Options = GroupByOptions(), const std::vector<JobTicket>& Dependencies = {});
+	// Of the last aggregation, waits for it. Throws when rows were not aggregated because the table
+	// was full or their key was 0xffffffff
+	uint32_t getGroupCount();
+
+	uint32_t getMaxGroups() const { return MaxGroups; }
+	// Shared groups per workgroup for that many columns
+	uint32_t getSharedSlots(uint32_t NumColumns) const;
+
+private:
+	void ensureBuffer(ComputeBuffer& Buffer, vk::DeviceSize Size);
+
+	ComputeContext& Context;
+	uint32_t MaxGroups = 0;
+	uint32_t NumSlots = 0;
+	uint32_t GroupSize = 0;
+	ComputeBuffer TableKeys;
+	// Counts and column states, NumSlots words each
+	ComputeBuffer TableWords;
+	// Groups, failed rows, output rows
+	ComputeBuffer Status;
+	// Output of aggregate()
+	ComputeBuffer Rows;
+	JobTicket LastJob;
+};
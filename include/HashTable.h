@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ComputeContext.h"
+#include "Kernels.h"
+#include "Scanner.h"
+
+struct HashTableOptions
+{
+	kernels::HashKeyType KeyType = kernels::HashKeyType::Uint32;
+	// Fraction of the slots Capacity keys fill, the table has Capacity / MaxLoadFactor slots.
+	// Linear probing stays short up to about 0.5 and degrades quickly past 0.8
+	float MaxLoadFactor = 0.5f;
+	// One slot per key, inserting a present key keeps the smaller value. Otherwise every inserted pair
+	// takes a slot, which is what the build side of a join with duplicate keys needs
+	bool bUnique = true;
+};
+
+// Counters of shaders/hash_table.glsl in the order of its status buffer
+struct HashTableStats
+{
+	uint32_t Size = 0;
+	// Live and erased slots, erased slots are only reclaimed by clear()
+	uint32_t UsedSlots = 0;
+	// Inserted keys that found no free slot or were one of the marker keys
+	uint32_t FailedInserts = 0;
+	// Of the last retrieve and join
+	uint32_t Retrieved = 0;
+	uint32_t JoinMatches = 0;
+};
+
+// Open addressing hash table with linear probing in device buffers, uint32 or uint64 keys with uint32
+// values. Bulk insert, find and erase run one invocation per key with compare-and-swap on the key
+// slots, so a batch may hold the same key several times. The two largest keys of the type are markers
+// (empty and erased slots) and cannot be stored. Uint64 keys need hasBufferInt64Atomics().
+// join() probes the table with a key column and writes the (probe index, value) pair of every match,
+// ordered by probe index: matches are counted per probe key, Scanner turns the counts into offsets
+// and a second probe writes the pairs. Insert keys without values to have the build row indices as
+// the values. Key and value buffers are bound whole, so they are limited to maxStorageBufferRange.
+// Every operation runs after the previous one of this table
+class HashTable
+{
+public:
+	static constexpr uint32_t NotFound = 0xffffffffu;
+
+	HashTable(ComputeContext& Context, uint32_t Capacity, const HashTableOptions& Options = HashTableOptions());
+	~HashTable();
+
+	HashTable(const HashTable&) = delete;
+	HashTable& operator=(const HashTable&) = delete;
+
+	// Empties the table with the next operation
+	void clear();
+	// Values may be null to insert the key indices. Throws when keys could not be inserted, the table
+	// then holds the others
+	void insert(const ComputeBuffer& Keys, uint32_t NumKeys, const ComputeBuffer* Values = nullptr);
+	// Failed inserts show up in getStats()
+	JobTicket insertAsync(const ComputeBuffer& Keys, uint32_t NumKeys, const ComputeBuffer* Values = nullptr,
+						  const std::vector<JobTicket>& Dependencies = {});
+	// Writes the value of every key to Values, NotFound for missing keys (one of the values of a key
+	// inserted several times into a table that is not unique)
+	void find(const ComputeBuffer& Keys, uint32_t NumKeys, const ComputeBuffer& Values);
+	JobTicket findAsync(const ComputeBuffer& Keys, uint32_t NumKeys, const ComputeBuffer& Values, const std::vector<JobTicket>& Dependencies = {});
+	// Erases every pair of the keys
+	void erase(const ComputeBuffer& Keys, uint32_t NumKeys);
+	JobTicket eraseAsync(const ComputeBuffer& Keys, uint32_t NumKeys, const std::vector<JobTicket>& Dependencies = {});
+	// Writes up to Capacity stored pairs to Keys and Values in no particular order and returns the
+	// number of stored pairs, the distinct keys of a unique table. Rerun with larger outputs when it
+	// exceeds Capacity, getStats().Size pairs always fit
+	uint32_t retrieve(const ComputeBuffer& Keys, const ComputeBuffer& Values, uint32_t Capacity);
+	JobTicket retrieveAsync(const ComputeBuffer& Keys, const ComputeBuffer& Values, uint32_t Capacity,
+							const std::vector<JobTicket>& Dependencies = {});
+	// Writes up to Capacity matches to ProbeIndices and BuildValues and returns the number of matches,
+	// rerun with larger outputs when it exceeds Capacity
+	uint32_t join(const ComputeBuffer& ProbeKeys, uint32_t NumProbeKeys, const ComputeBuffer& ProbeIndices, const ComputeBuffer& BuildValues,
+				  uint32_t Capacity);
+	JobTicket joinAsync(const ComputeBuffer& ProbeKeys, uint32_t NumProbeKeys, const ComputeBuffer& ProbeIndices,
+						const ComputeBuffer& BuildValues, uint32_t Capacity, const std::vector<JobTicket>& Dependencies = {});
+
+	// Waits for the operations so far
+	HashTableStats getStats();
+	uint32_t getSlotCount() const { return NumSlots; }
+	static bool isSupported(const ComputeContext& Context, kernels::HashKeyType KeyType);
+
+private:
+	ComputeJob makeJob(kernels::HashTableMode Mode, const ComputeBuffer& Keys, const ComputeBuffer* Values, uint32_t NumKeys,
+					   uint32_t OutputCapacity = 0);
+	JobTicket submit(ComputeJob& Job, const std::vector<JobTicket>& Dependencies);
+	void checkKeys(const ComputeBuffer& Keys, uint32_t NumKeys) const;
+	void ensureCounts(vk::DeviceSize Size);
+
+	ComputeContext& Context;
+	HashTableOptions Options;
+	Scanner Scan;
+	uint32_t GroupSize = 0;
+	uint32_t NumSlots = 0;
+	uint32_t KeySize = 0;
+	ComputeBuffer TableKeys;
+	ComputeBuffer TableValues;
+	// HashTableStats words
+	ComputeBuffer Status;
+	// Matches per probe key, then their offsets
+	ComputeBuffer Counts;
+	// The next job clears the table first
+	bool bClearPending = true;
+	JobTicket LastJob;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ComputeContext.h"
+#include "Kernels.h"
+
+enum class HistogramStrategy
+{
+	// SharedMemory when the bins fit maxComputeSharedMemorySize, GlobalAtomics otherwise
+	Auto,
+	// Per-workgroup bins in shared memory, added to the global bins once per workgroup
+	SharedMemory,
+	// Every element is an atomic add on the global bins
+	GlobalAtomics
+};
+
+// Counts uint32, int32 or float elements into BinCount uint32 bins. Integer keys in [Min, Max]
+// fall into bins ceil((Max - Min + 1) / BinCount) wide, floats in [Min, Max] into BinCount equal
+// bins with Max in the last one. Elements outside the range and NaNs are not counted.
+// The bins are cleared first. The elements are bound whole, so they are limited to
+// maxStorageBufferRange
+class Histogrammer
+{
+public:
+	explicit Histogrammer(ComputeContext& Context);
+
+	Histogrammer(const Histogrammer&) = delete;
+	Histogrammer& operator=(const Histogrammer&) = delete;
+
+	// T is uint32_t, int32_t or float
+	template <typename T>
+	void histogram(const ComputeBuffer& Input, uint64_t NumElements, T Min, T Max, uint32_t BinCount, const ComputeBuffer& Bins,
+				   HistogramStrategy Strategy = HistogramStrategy::Auto);
+	template <typename T>
+	JobTicket histogramAsync(const ComputeBuffer& Input, uint64_t NumElements, T Min, T Max, uint32_t BinCount, const ComputeBuffer& Bins,
+							 HistogramStrategy Strategy = HistogramStrategy::Auto, const std::vector<JobTicket>& Dependencies = {});
+
+	// Most bins one workgroup can keep in shared memory
+	uint32_t getMaxSharedBins() const { return MaxSharedBins; }
+
+private:
+	JobTicket histogramRaw(const ComputeBuffer& Input, uint64_t NumElements, kernels::HistogramType Type, uint32_t MinBits, uint32_t MaxBits,
+						   uint32_t BinWidth, uint32_t BinCount, const ComputeBuffer& Bins, HistogramStrategy Strategy,
+						   const std::vector<JobTicket>& Dependencies);
+
+	ComputeContext& Context;
+	uint32_t GroupSize = 0;
+	uint32_t MaxSharedBins = 0;
+};
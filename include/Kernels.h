@@ -0,0 +1,301 @@
+#pragma once
+
+#include "ComputeContext.h"
+
+// Descriptions of the kernels shipped in shaders/, create them with ComputeContext::createKernel
+namespace kernels
+{
+	// Mirrors the OP_ constants of shaders/elementwise_vec4.comp
+	enum class ElementwiseOp : uint32_t
+	{
+		Add,		// c = a + b
+		Sub,		// c = a - b
+		Mul,		// c = a * b
+		Square,		// c = a * a, b is not read
+		Fma,		// c = a * b + c
+		Min,
+		Max
+	};
+
+	// How the 32-bit elements are interpreted, mirrors the TYPE_ constants
+	enum class ElementType : uint32_t
+	{
+		Uint,
+		Int,
+		Float
+	};
+
+	// uvec4 vectors each invocation of an elementwise_vec4 kernel handles
+	constexpr uint32_t Vec4VectorsPerThread = 4;
+
+	// Mirrors the OP_ constants of shaders/reduce.glsl
+	enum class ReduceOp : uint32_t
+	{
+		Sum,
+		Min,
+		Max,
+		ArgMin,
+		ArgMax
+	};
+
+	// Element type of a reduction, picks the shaders/reduce_<type>.comp variant
+	enum class ReduceType : uint32_t
+	{
+		Uint32,
+		Int32,
+		Float32,
+		Float64		// Needs shaderFloat64
+	};
+
+	// Mirrors the MODE_ constants of shaders/scan.comp
+	enum class ScanMode : uint32_t
+	{
+		SinglePass,			// Decoupled look-back, needs forward progress between workgroups
+		ReduceTiles,		// Reduce-then-scan fallback, pass 1
+		ScanTiles,			// Pass 2, one workgroup
+		ScanWithCarry		// Pass 3
+	};
+
+	// Elements each invocation of a scan kernel handles, a tile is that times the workgroup size
+	constexpr uint32_t ScanItemsPerThread = 8;
+
+	// Mirrors the MODE_ constants of shaders/radix_sort.comp
+	enum class RadixSortMode : uint32_t
+	{
+		Histogram,			// Digit counts of all passes
+		Upsweep,			// Per-tile digit counts of one pass (reduce-then-scan fallback)
+		ScatterLookBack,	// Onesweep scatter, needs forward progress between workgroups
+		ScatterScanned		// Scatter with the scanned per-tile counts (fallback)
+	};
+
+	// Keys each invocation of a radix sort kernel handles per pass
+	constexpr uint32_t RadixItemsPerThread = 8;
+
+	// Outputs each invocation of a merge kernel writes
+	constexpr uint32_t MergeItemsPerThread = 8;
+
+	// Mirrors the MODE_ constants of shaders/top_k.comp
+	enum class TopKMode : uint32_t
+	{
+		Histogram,		// Digit counts of one pass under the prefix found so far
+		Select,			// One workgroup extends the prefix by the digit holding the K-th element
+		Compact,		// Writes the selected elements and their indices
+		Restore			// Turns sorted select keys back into elements
+	};
+
+	// Elements each invocation of a top-k compaction handles per tile
+	constexpr uint32_t TopKItemsPerThread = 4;
+
+	// Key type of a hash table, picks the shaders/hash_table_<type>.comp variant
+	enum class HashKeyType : uint32_t
+	{
+		Uint32,
+		Uint64		// Needs shaderInt64 and shaderBufferInt64Atomics
+	};
+
+	// Mirrors the MODE_ constants of shaders/hash_table.glsl
+	enum class HashTableMode : uint32_t
+	{
+		Insert,
+		Find,
+		Erase,
+		Retrieve,		// Live slots written densely
+		JoinCount,		// Matches per probe key, Scanner follows
+		JoinWrite		// Matched pairs at the scanned offsets
+	};
+
+	// Mirrors the OP_ constants of shaders/group_by.comp
+	enum class AggregateOp : uint32_t
+	{
+		Sum,		// In the column type, 32-bit ints wrap around
+		Count,		// Rows of the group, the column is not read
+		Min,
+		Max,
+		Avg			// Float sum in the column type divided by the count
+	};
+
+	// Mirrors the MODE_ constants of shaders/group_by.comp
+	enum class GroupByMode : uint32_t
+	{
+		Aggregate,		// Rows into the global table, through shared memory first when SharedSlots > 0
+		Output			// Groups written densely as rows
+	};
+
+	// Value columns one group-by aggregates at most
+	constexpr uint32_t GroupByMaxColumns = 8;
+
+	// Element type of a histogram, mirrors the TYPE_ constants of shaders/histogram.comp
+	enum class HistogramType : uint32_t
+	{
+		Uint32,
+		Int32,
+		Float32
+	};
+
+	// Mirrors the MODE_ constants of shaders/compact.comp
+	enum class CompactMode : uint32_t
+	{
+		Unordered,			// One dispatch, tiles reserve their output with an atomic
+		CountTiles,			// Stable, pass 1: kept elements per tile
+		ScatterScanned		// Stable, pass 2 after Scanner
+	};
+
+	// Mirrors the PREDICATE_ constants of shaders/compact.comp
+	enum class CompactPredicate : uint32_t
+	{
+		Compare,	// x <op> A
+		Range,		// A <= x <= B
+		NonZero,
+		Bitmask		// (x & A) == B
+	};
+
+	// Mirrors the COMPARE_ constants of shaders/compact.comp
+	enum class CompareOp : uint32_t
+	{
+		Equal,
+		NotEqual,
+		Less,
+		LessEqual,
+		Greater,
+		GreaterEqual
+	};
+
+	// Elements each invocation of a compact kernel handles
+	constexpr uint32_t CompactItemsPerThread = 4;
+
+	// Mirrors the MODE_ constants of shaders/spmv.comp
+	enum class SpmvMode : uint32_t
+	{
+		CsrScalar,		// One invocation per row
+		CsrVector,		// One subgroup per row
+		Sell			// SELL-C-sigma, one invocation per sorted row
+	};
+
+	// Mirrors the MODE_ constants of shaders/sell_convert.comp
+	enum class SellConvertMode : uint32_t
+	{
+		Keys,		// Sort keys and identity permutation, RadixSorter follows
+		Widths,		// Padded slice sizes, Scanner follows
+		Fill		// Copy the rows into their slices
+	};
+
+	// Mirrors the SHAPE_ constants of shaders/stencil.comp
+	enum class StencilShape : uint32_t
+	{
+		Star,		// The center and RADIUS cells along each axis
+		Box			// Every cell within RADIUS on all axes, a convolution
+	};
+
+	// Value of the cells outside the grid, mirrors the BOUNDARY_ constants of shaders/stencil.comp
+	enum class StencilBoundary : uint32_t
+	{
+		Clamp,		// The nearest edge cell
+		Wrap,		// Periodic grid
+		Constant	// A fixed value
+	};
+
+	// Cells one stencil workgroup updates and the timesteps it takes per dispatch.
+	// Mirrors the TILE_ and TEMPORAL constants of shaders/stencil.comp, Z is 1 for 2D grids
+	struct StencilTile
+	{
+		uint32_t X = 32;
+		uint32_t Y = 32;
+		uint32_t Z = 1;
+		uint32_t TemporalSteps = 1;
+
+		// Both copies of the tile and its halo
+		uint32_t getSharedSize(uint32_t Dims, uint32_t Radius) const
+		{
+			const uint32_t Halo = Radius * TemporalSteps;
+			return 2 * (X + 2 * Halo) * (Y + 2 * Halo) * (Z + (Dims == 3 ? 2 * Halo : 0)) * sizeof(float);
+		}
+	};
+
+	// Coefficients a stencil takes, see shaders/stencil.comp for their order
+	uint32_t getStencilCoefficientCount(uint32_t Dims, StencilShape Shape, uint32_t Radius);
+
+	// Block of C one gemm workgroup computes, and the block of it each invocation keeps in registers.
+	// Mirrors the TILE_ and THREAD_ constants of shaders/gemm.comp
+	struct GemmTile
+	{
+		uint32_t M = 64;
+		uint32_t N = 64;
+		uint32_t K = 16;
+		uint32_t ThreadM = 4;
+		uint32_t ThreadN = 4;
+
+		uint32_t getThreads() const { return (M / ThreadM) * (N / ThreadN); }
+		// Both staged K slices, padded by one column
+		uint32_t getSharedSize() const { return K * (M + 1 + N + 1) * sizeof(float); }
+	};
+
+	// shaders/compute.comp: data[2] = data[0] + data[1], three uint buffers in binding 0
+	KernelDesc add();
+	// shaders/Square.hlsl: OutBuffer = InBuffer * InBuffer, int buffers in bindings 0 and 1
+	KernelDesc square();
+	// shaders/elementwise_vec4.comp: 128-bit loads and stores, data[2] = data[0] op data[1] over
+	// three buffers in binding 0 that start 16 byte aligned. Set the job up with setVec4ElementCount
+	KernelDesc elementwiseVec4(ElementwiseOp Op, ElementType Type);
+	// Sets ElementCount (in invocations) and the push constants of a job running an elementwise_vec4
+	// kernel over NumElements 32-bit elements, any count including ones that are not a multiple of 4
+	void setVec4ElementCount(ComputeJob& Job, uint32_t NumElements);
+	// shaders/reduce_<type>.comp, binding 0 the input, binding 1 the partials written.
+	// Stage 0 reduces elements, stage 1 partials, see Reducer for how they are dispatched
+	KernelDesc reduce(ReduceOp Op, ReduceType Type, uint32_t Stage);
+	// shaders/scan.comp over uint elements: bindings 0 input, 1 output, 2 head flags (bind the
+	// input when not segmented), 3 tile status. See Scanner for how the modes are dispatched
+	KernelDesc scan(ScanMode Mode, bool bExclusive, bool bSegmented);
+	// shaders/radix_sort.comp: bindings 0/1 keys in/out, 2/3 values in/out (bind the keys when
+	// there are none), 4 histogram, 5 tile status. SubgroupSlots bounds the subgroups per
+	// workgroup. See RadixSorter for how the modes are dispatched
+	KernelDesc radixSort(RadixSortMode Mode, uint32_t KeyWords, bool bValues, uint32_t SubgroupSlots);
+	// shaders/segmented_sort.comp over 32-bit keys of KeyType: bindings 0 keys, 1 values (bind the keys
+	// when there are none), 2 segment offsets, 3/4 key and value temporaries for segments longer than
+	// Capacity. Dispatch one workgroup of Threads per segment, see SegmentedSorter
+	KernelDesc segmentedSort(ElementType KeyType, bool bValues, uint32_t Capacity, uint32_t Threads);
+	// shaders/merge.comp over 32-bit keys of KeyType: bindings 0/1 keys of A/B, 2/3 values of A/B,
+	// 4/5 keys and values out (bind the keys when there are no values). See SegmentedSorter
+	KernelDesc merge(ElementType KeyType, bool bValues);
+	// shaders/transpose.comp: binding 0 row-major matrices of ElementWords (1, 2 or 4) uints, binding 1
+	// their transposes. Dispatch one workgroup of Threads (a multiple of Tile) per Tile x Tile block
+	KernelDesc transpose(uint32_t ElementWords, uint32_t Tile, uint32_t Threads);
+	// shaders/layout_convert.comp between records of StrideWords uints and field arrays: bindings 0 input,
+	// 1 output, 2 field table. Dispatch one workgroup of Threads per TileRecords records, see LayoutConverter
+	KernelDesc layoutConvert(bool bAosToSoa, uint32_t StrideWords, uint32_t TileRecords, uint32_t Threads);
+	// shaders/top_k.comp over 32-bit elements of Type: bindings 0 input, 1 state, 2/3 selected values and
+	// indices. bSortKeys makes Compact write sortable select keys instead of values. See TopKSelector
+	KernelDesc topK(TopKMode Mode, ElementType Type, bool bLargest, bool bSortKeys);
+	// shaders/hash_table_<type>.comp: bindings 0/1 table keys and values, 2 keys in or out, 3 values in
+	// or out (bind the table values when unused), 4/5 join probe indices and build values out, 6 status.
+	// bUnique tables keep one slot per key, bValues inserts the values of binding 3 instead of the key
+	// indices. See HashTable
+	KernelDesc hashTable(HashTableMode Mode, HashKeyType KeyType, bool bUnique, bool bValues);
+	// shaders/group_by.comp over uint keys and 32-bit columns of Types: bindings 0 keys, 1/2 table keys and
+	// words, 3 status, 4 output rows, 5 an array of GroupByMaxColumns columns (bind the keys for the
+	// unused ones). SharedSlots groups per workgroup in shared memory, 0 for none. See GroupByAggregator
+	KernelDesc groupBy(GroupByMode Mode, const std::vector<AggregateOp>& Ops, const std::vector<ElementType>& Types, uint32_t SharedSlots);
+	// shaders/histogram.comp: binding 0 the elements, binding 1 the uint bins it adds to.
+	// SharedBins sizes the per-workgroup bins when bPrivatized, see Histogrammer
+	KernelDesc histogram(HistogramType Type, bool bPrivatized, uint32_t SharedBins);
+	// shaders/compact.comp over 32-bit elements of Type: bindings 0 input, 1 output, 2 tile status,
+	// 3 output args, 4 input args (bind the output args unless bCountFromArgs). See Compactor
+	KernelDesc compact(CompactMode Mode, CompactPredicate Predicate, CompareOp Compare, ElementType Type, uint32_t SubgroupSlots,
+					   bool bCountFromArgs);
+	// shaders/gemm.comp: bindings 0 A, 1 B (floats, or halves packed in uints when bHalf), 2 C floats.
+	// Dispatch (N / Tile.N, M / Tile.M) workgroups rounded up, see MatrixMultiplier
+	KernelDesc gemm(const GemmTile& Tile, bool bTransposeA, bool bTransposeB, bool bHalf);
+	// shaders/spmv.comp: bindings 0 row or slice offsets, 1 columns, 2 values, 3 SELL permutation
+	// (bind the offsets for CSR), 4 x, 5 y. See SparseMultiplier
+	KernelDesc spmv(SpmvMode Mode);
+	// shaders/sell_convert.comp: bindings 0 CSR row offsets, 1 sort keys, 2 permutation, 3 slice
+	// offsets, 4/5 CSR columns/values, 6/7 SELL columns/values. See SparseMultiplier
+	KernelDesc sellConvert(SellConvertMode Mode);
+	// shaders/stencil.comp over float grids of Dims (2 or 3) dimensions: bindings 0 input, 1 output,
+	// 2 coefficients. Dispatch one workgroup of Threads per tile, see Stenciler
+	KernelDesc stencil(uint32_t Dims, StencilShape Shape, uint32_t Radius, StencilBoundary Boundary, const StencilTile& Tile, uint32_t Threads);
+	// shaders/fft_shared.comp: whole N point FFTs of Signals signals per workgroup in shared memory,
+	// binding 0 the complex data transformed in place, 1 the twiddles of N. See FourierTransformer
+	KernelDesc fftShared(uint32_t N, uint32_t Signals, bool bInverse, uint32_t Threads);
+	// shaders/fft_pass.comp: one Stockham pass, bindings 0 input, 1 output, 2 twiddles
+	KernelDesc fftPass(bool bInverse);
+}
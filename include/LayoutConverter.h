@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "ComputeContext.h"
+
+// A field of a record, in bytes. Offsets and sizes are multiples of 4
+struct RecordField
+{
+	uint32_t Offset = 0;
+	uint32_t Size = 0;
+};
+
+// How the records of an array of structs are laid out: Stride bytes apart (a multiple of 4), holding
+// non-overlapping Fields. The struct of arrays side stores every field's values back to back, the
+// arrays one after the other in the order of Fields
+struct RecordLayout
+{
+	uint32_t Stride = 0;
+	std::vector<RecordField> Fields;
+
+	// Byte offset of field Field's array in a struct of arrays of NumRecords records
+	vk::DeviceSize getSoaOffset(size_t Field, uint64_t NumRecords) const;
+	vk::DeviceSize getSoaSize(uint64_t NumRecords) const;
+};
+
+// Reshapes data on the device: tiled matrix transposes of 4, 8 or 16 byte elements, and conversions
+// between arrays of structs and structs of arrays. Both move tiles through padded shared memory so
+// that reads and writes are coalesced and shared memory is free of bank conflicts. Layouts whose
+// fields are equally sized (4, 8 or 16 bytes) and fill the record in order are converted as
+// transposes. Outputs must not overlap inputs, buffers are bound whole, so they are limited to
+// maxStorageBufferRange
+class LayoutConverter
+{
+public:
+	explicit LayoutConverter(ComputeContext& Context);
+	~LayoutConverter();
+
+	LayoutConverter(const LayoutConverter&) = delete;
+	LayoutConverter& operator=(const LayoutConverter&) = delete;
+
+	// Out = transpose(In) for Batch row-major Rows x Cols matrices stored one after the other
+	void transpose(const ComputeBuffer& In, const ComputeBuffer& Out, uint32_t Rows, uint32_t Cols, uint32_t ElementSize, uint32_t Batch = 1);
+	JobTicket transposeAsync(const ComputeBuffer& In, const ComputeBuffer& Out, uint32_t Rows, uint32_t Cols, uint32_t ElementSize,
+							 uint32_t Batch = 1, const std::vector<JobTicket>& Dependencies = {});
+
+	void aosToSoa(const ComputeBuffer& Aos, const ComputeBuffer& Soa, uint64_t NumRecords, const RecordLayout& Layout);
+	JobTicket aosToSoaAsync(const ComputeBuffer& Aos, const ComputeBuffer& Soa, uint64_t NumRecords, const RecordLayout& Layout,
+							const std::vector<JobTicket>& Dependencies = {});
+	// Record bytes that belong to no field are left as they are in Aos
+	void soaToAos(const ComputeBuffer& Soa, const ComputeBuffer& Aos, uint64_t NumRecords, const RecordLayout& Layout);
+	JobTicket soaToAosAsync(const ComputeBuffer& Soa, const ComputeBuffer& Aos, uint64_t NumRecords, const RecordLayout& Layout,
+							const std::vector<JobTicket>& Dependencies = {});
+
+	// Largest record stride in bytes that one record of fits shared memory
+	uint32_t getMaxStride() const;
+
+private:
+	JobTicket convert(bool bAosToSoa, const ComputeBuffer& In, const ComputeBuffer& Out, uint64_t NumRecords, const RecordLayout& Layout,
+					  const std::vector<JobTicket>& Dependencies);
+	// Field table of shaders/layout_convert.comp, uploaded once per layout and kept
+	const ComputeBuffer& getFieldTable(const RecordLayout& Layout);
+	// Transpose tile of ElementWords uint elements that fits shared memory
+	uint32_t getTransposeTile(uint32_t ElementWords) const;
+
+	ComputeContext& Context;
+	uint32_t Threads = 0;
+	std::map<std::vector<uint32_t>, ComputeBuffer> FieldTables;
+};
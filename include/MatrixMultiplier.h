@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ComputeContext.h"
+#include "Kernels.h"
+
+enum class MatrixLayout
+{
+	RowMajor,
+	ColumnMajor
+};
+
+enum class GemmPrecision
+{
+	Float32,
+	// A and B hold IEEE halves packed two per uint32 (uint16_t arrays), accumulated and written as float
+	Float16
+};
+
+// C = Alpha * op(A) * op(B) + Beta * C, op(A) is M x K and op(B) K x N. The layout applies to all
+// three matrices. Leading dimensions are in elements, 0 packs the stored rows (columns) tightly
+struct GemmParams
+{
+	uint32_t M = 0;
+	uint32_t N = 0;
+	uint32_t K = 0;
+	bool bTransposeA = false;
+	bool bTransposeB = false;
+	MatrixLayout Layout = MatrixLayout::RowMajor;
+	uint32_t LdA = 0;
+	uint32_t LdB = 0;
+	uint32_t LdC = 0;
+	float Alpha = 1.0f;
+	float Beta = 0.0f;
+	GemmPrecision Precision = GemmPrecision::Float32;
+	// All zero picks one of getTiles() for the matrix size
+	kernels::GemmTile Tile = { 0, 0, 0, 0, 0 };
+};
+
+// Shared-memory tiled GEMM with register blocking. The matrices are bound whole, so they are
+// limited to maxStorageBufferRange
+class MatrixMultiplier
+{
+public:
+	explicit MatrixMultiplier(ComputeContext& Context);
+
+	MatrixMultiplier(const MatrixMultiplier&) = delete;
+	MatrixMultiplier& operator=(const MatrixMultiplier&) = delete;
+
+	void multiply(const ComputeBuffer& A, const ComputeBuffer& B, const ComputeBuffer& C, const GemmParams& Params);
+	JobTicket multiplyAsync(const ComputeBuffer& A, const ComputeBuffer& B, const ComputeBuffer& C, const GemmParams& Params,
+							const std::vector<JobTicket>& Dependencies = {});
+
+	// Tiles that fit this device's workgroup and shared memory limits, largest first
+	const std::vector<kernels::GemmTile>& getTiles() const { return Tiles; }
+	// The largest tile that still gives the GPU enough workgroups for an M x N result
+	const kernels::GemmTile& chooseTile(uint32_t M, uint32_t N) const;
+
+private:
+	ComputeContext& Context;
+	std::vector<kernels::GemmTile> Tiles;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+// vkGetPipelineCacheData blob of one device persisted as
+// "<directory>/pipelines_<vendor>_<device>_<driver>_<pipelineCacheUUID>.bin", hex encoded.
+// The blob is prefixed with a small header (magic, device identity, size and checksum) so that
+// truncated, corrupt or foreign files are rejected before the driver sees them
+class PipelineCacheFile
+{
+public:
+	PipelineCacheFile(const std::string& Directory, const vk::PhysicalDeviceProperties& DeviceProps);
+
+	// Empty when the file is missing, stale or corrupt
+	std::vector<uint8_t> load() const;
+	// Writes a temporary file and renames it over the old one, a crash never leaves half a file behind.
+	// Returns false when writing failed
+	bool save(const std::vector<uint8_t>& Data) const;
+
+	const std::string& getPath() const { return FilePath; }
+
+private:
+	bool isValidBlob(const std::vector<uint8_t>& Data) const;
+
+	std::string FilePath;
+	uint32_t VendorID = 0;
+	uint32_t DeviceID = 0;
+	uint32_t DriverVersion = 0;
+	std::array<uint8_t, VK_UUID_SIZE> PipelineCacheUUID = {};
+};
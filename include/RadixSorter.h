@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ComputeContext.h"
+#include "Scanner.h"
+
+enum class RadixKeyType
+{
+	Uint32,
+	// Two uint32 words per key, low word first (little endian uint64_t)
+	Uint64
+};
+
+// LSD radix sort with 8-bit digits, stable, ascending. Sorts in place: the keys (and the uint32
+// values permuted along with them) end up back in the caller's buffers, temporaries are kept
+// between calls. Up to 2^32 - 1 keys, 2^30 - 1 with the single-pass (onesweep) scatter, and the
+// key buffer is bound whole so it is limited to maxStorageBufferRange.
+// Needs subgroup ballots in compute shaders
+class RadixSorter
+{
+public:
+	explicit RadixSorter(ComputeContext& Context);
+	~RadixSorter();
+
+	RadixSorter(const RadixSorter&) = delete;
+	RadixSorter& operator=(const RadixSorter&) = delete;
+
+	// Algorithm picks onesweep (SinglePass) or histogram + Scanner + scatter per pass (ReduceThenScan)
+	void sort(const ComputeBuffer& Keys, uint64_t NumKeys, RadixKeyType KeyType, const ComputeBuffer* Values = nullptr,
+			  ScanAlgorithm Algorithm = ScanAlgorithm::Auto);
+	// Runs after Dependencies and after the previous sort of this RadixSorter, which shares the temporaries
+	JobTicket sortAsync(const ComputeBuffer& Keys, uint64_t NumKeys, RadixKeyType KeyType, const ComputeBuffer* Values = nullptr,
+						ScanAlgorithm Algorithm = ScanAlgorithm::Auto, const std::vector<JobTicket>& Dependencies = {});
+
+	static bool isSupported(const ComputeContext& Context);
+
+private:
+	void ensureBuffer(ComputeBuffer& Buffer, vk::DeviceSize Size);
+
+	ComputeContext& Context;
+	Scanner Scan;
+	uint32_t GroupSize = 0;
+	uint32_t SubgroupSlots = 0;
+	ComputeBuffer KeysTemp;
+	ComputeBuffer ValuesTemp;
+	ComputeBuffer Histogram;
+	ComputeBuffer Status;
+	JobTicket LastJob;
+};
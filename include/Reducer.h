@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ComputeContext.h"
+#include "Kernels.h"
+
+template <typename T>
+struct ReduceResult
+{
+	T Value = T();
+	// First element holding Value, ArgMin and ArgMax only
+	uint32_t Index = 0;
+};
+
+// Reduces a device buffer to one value on the GPU, only the result is read back.
+// Inputs larger than maxStorageBufferRange are reduced window by window, up to 2^32 - 1 elements.
+// Sums wrap around for the integer types, float sums are not bit-reproducible across devices.
+// Needs subgroup arithmetic in compute shaders, Float64 also needs shaderFloat64
+class Reducer
+{
+public:
+	explicit Reducer(ComputeContext& Context);
+	~Reducer();
+
+	Reducer(const Reducer&) = delete;
+	Reducer& operator=(const Reducer&) = delete;
+
+	// T is uint32_t, int32_t, float or double, Buffer holds NumElements of them from offset 0.
+	// Reads Buffer after Dependencies, the tickets of the async jobs writing it
+	template <typename T>
+	ReduceResult<T> reduce(const ComputeBuffer& Buffer, uint64_t NumElements, kernels::ReduceOp Op,
+						   const std::vector<JobTicket>& Dependencies = {});
+
+	static bool isSupported(const ComputeContext& Context, kernels::ReduceType Type);
+
+private:
+	// Writes the final Partial, sizeof(T) + index padded to the alignment of T, to Result
+	void reduceRaw(const ComputeBuffer& Buffer, uint64_t NumElements, kernels::ReduceOp Op, kernels::ReduceType Type,
+				   uint32_t ElementSize, void* Result, uint32_t ResultSize, const std::vector<JobTicket>& Dependencies);
+	void ensurePartials(vk::DeviceSize Size);
+
+	ComputeContext& Context;
+	uint32_t GroupSize = 0;
+	// One partial per workgroup of every window, then the final one
+	ComputeBuffer Partials;
+	ComputeBuffer ResultBuffer;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ComputeContext.h"
+
+enum class ScanAlgorithm
+{
+	// SinglePass on desktop GPUs known to keep earlier workgroups running, ReduceThenScan elsewhere
+	Auto,
+	// One dispatch, tiles get their carry by decoupled look-back over a tile status buffer
+	SinglePass,
+	// Three dispatches, no workgroup ever waits for another
+	ReduceThenScan
+};
+
+struct ScanOptions
+{
+	// Output[i] leaves out Input[i]
+	bool bExclusive = false;
+	// Optional uint per element, the sum restarts at every element with a non-zero flag
+	const ComputeBuffer* HeadFlags = nullptr;
+	ScanAlgorithm Algorithm = ScanAlgorithm::Auto;
+};
+
+// Prefix sums of uint32 elements (int32 too, sums wrap around). Input and Output may be the same
+// buffer. Both are bound whole, so they are limited to maxStorageBufferRange
+class Scanner
+{
+public:
+	explicit Scanner(ComputeContext& Context);
+	~Scanner();
+
+	Scanner(const Scanner&) = delete;
+	Scanner& operator=(const Scanner&) = delete;
+
+	void scan(const ComputeBuffer& Input, const ComputeBuffer& Output, uint64_t NumElements, const ScanOptions& Options = ScanOptions());
+	// Runs after Dependencies and after the previous scan of this Scanner, which shares the status buffer
+	JobTicket scanAsync(const ComputeBuffer& Input, const ComputeBuffer& Output, uint64_t NumElements,
+						const ScanOptions& Options = ScanOptions(), const std::vector<JobTicket>& Dependencies = {});
+
+	// Whether the device is known to schedule workgroups so that the look-back cannot deadlock
+	static bool hasForwardProgress(const vk::PhysicalDeviceProperties& DeviceProps);
+	uint32_t getTileSize() const;
+
+private:
+	void ensureStatus(vk::DeviceSize Size);
+
+	ComputeContext& Context;
+	uint32_t GroupSize = 0;
+	// Tile counter, then (state, aggregate, prefix) per tile
+	ComputeBuffer Status;
+	JobTicket LastScan;
+};
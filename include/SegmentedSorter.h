@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ComputeContext.h"
+#include "Kernels.h"
+
+struct SegmentedSortOptions
+{
+	// How the 32-bit keys compare, see shaders/sort_keys.glsl for where NaNs go
+	kernels::ElementType KeyType = kernels::ElementType::Uint;
+	// Longest segment when the caller knows it, 0 otherwise. Short bounds pick a smaller shared network
+	// and workgroup. A segment longer than the bound is still sorted, blockwise through the
+	// temporaries, just slower. The temporaries are skipped when NumKeys fits the network
+	uint32_t MaxSegmentLength = 0;
+};
+
+// A sorted run of 32-bit keys, with uint32 values that follow them when Values is set
+struct SortedRun
+{
+	const ComputeBuffer* Keys = nullptr;
+	const ComputeBuffer* Values = nullptr;
+	uint64_t Count = 0;
+};
+
+// Sorts many small independent arrays in one dispatch, and merges two sorted buffers in another.
+// Segments are given by NumSegments + 1 uint32 offsets into the keys, segment s is
+// [Offsets[s], Offsets[s + 1]), and each one is sorted by one workgroup. Up to getMaxSharedSegment()
+// keys a segment is a bitonic sort in shared memory, longer ones sort blocks of that size and merge
+// them in global memory within the same workgroup, which is correct but leaves most of the GPU idle
+// when few segments are long. Both sorts are ascending and stable, uint32 values follow their keys.
+// Buffers are bound whole, so they are limited to maxStorageBufferRange
+class SegmentedSorter
+{
+public:
+	explicit SegmentedSorter(ComputeContext& Context);
+	~SegmentedSorter();
+
+	SegmentedSorter(const SegmentedSorter&) = delete;
+	SegmentedSorter& operator=(const SegmentedSorter&) = delete;
+
+	// Sorts the segments of Keys, and of Values along with them, in place. Offsets must not exceed NumKeys
+	void sort(const ComputeBuffer& Keys, uint64_t NumKeys, const ComputeBuffer& Offsets, uint32_t NumSegments,
+			  const ComputeBuffer* Values = nullptr, const SegmentedSortOptions& Options = SegmentedSortOptions());
+	// Runs after Dependencies and after the previous sort of this SegmentedSorter that used the temporaries
+	JobTicket sortAsync(const ComputeBuffer& Keys, uint64_t NumKeys, const ComputeBuffer& Offsets, uint32_t NumSegments,
+						const ComputeBuffer* Values = nullptr, const SegmentedSortOptions& Options = SegmentedSortOptions(),
+						const std::vector<JobTicket>& Dependencies = {});
+
+	// Merges A and B into A.Count + B.Count keys of KeysOut, ties take A first. Either both runs have
+	// values and ValuesOut is set or none of them. The outputs must not overlap the inputs
+	void merge(const SortedRun& A, const SortedRun& B, const ComputeBuffer& KeysOut, const ComputeBuffer* ValuesOut = nullptr,
+			   kernels::ElementType KeyType = kernels::ElementType::Uint);
+	JobTicket mergeAsync(const SortedRun& A, const SortedRun& B, const ComputeBuffer& KeysOut, const ComputeBuffer* ValuesOut = nullptr,
+						 kernels::ElementType KeyType = kernels::ElementType::Uint, const std::vector<JobTicket>& Dependencies = {});
+
+	// Longest segment sorted entirely in shared memory
+	uint32_t getMaxSharedSegment() const { return MaxCapacity; }
+	uint32_t getMergeTileSize() const { return MergeGroupSize * kernels::MergeItemsPerThread; }
+
+private:
+	void ensureBuffer(ComputeBuffer& Buffer, vk::DeviceSize Size);
+
+	ComputeContext& Context;
+	uint32_t SortThreads = 0;
+	uint32_t MaxCapacity = 0;
+	uint32_t MergeGroupSize = 0;
+	// Segments longer than the shared capacity merge through these
+	ComputeBuffer KeysTemp;
+	ComputeBuffer ValuesTemp;
+	JobTicket LastTempJob;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Compressed sparse rows on the host, float values
+struct CsrMatrix
+{
+	uint32_t Rows = 0;
+	uint32_t Cols = 0;
+	// Rows + 1 entries, the last one is the number of non-zeros
+	std::vector<uint32_t> RowOffsets;
+	std::vector<uint32_t> Columns;
+	std::vector<float> Values;
+
+	uint64_t getNonZeros() const { return Columns.size(); }
+};
+
+// Reads a Matrix Market coordinate file (real, integer or pattern; general, symmetric or
+// skew-symmetric). Symmetric entries off the diagonal are stored twice, duplicates are kept
+CsrMatrix loadMatrixMarket(const std::string& FileName);
+
+// What the SpMV format is picked from
+struct RowLengthStats
+{
+	uint32_t Min = 0;
+	uint32_t Max = 0;
+	double Mean = 0.0;
+	double StdDev = 0.0;
+	// Entries of the SELL-C-sigma form, non-zeros plus padding
+	uint64_t SellPaddedSize = 0;
+
+	// Share of the SELL entries that are non-zeros
+	double getSellEfficiency(uint64_t NonZeros) const { return SellPaddedSize != 0 ? double(NonZeros) / double(SellPaddedSize) : 1.0; }
+};
+
+// SliceHeight and Sigma as for SparseMultiplier, Sigma a multiple of SliceHeight
+RowLengthStats computeRowLengthStats(const CsrMatrix& Matrix, uint32_t SliceHeight, uint32_t Sigma);
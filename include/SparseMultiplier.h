@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ComputeContext.h"
+#include "RadixSorter.h"
+#include "Scanner.h"
+#include "SparseMatrix.h"
+
+enum class SpmvFormat
+{
+	// Picked from the row length distribution, see SparseMultiplier::chooseFormat
+	Auto,
+	// CSR, one invocation per row
+	CsrScalar,
+	// CSR, one subgroup per row
+	CsrVector,
+	// SELL-C-sigma: rows sorted by length inside windows of Sigma rows, slices of SliceHeight rows
+	// padded to their longest row and stored column by column
+	Sell
+};
+
+// A sparse matrix in device buffers. CSR: RowOffsets has Rows + 1 entries. SELL: RowOffsets holds
+// the NumSlices + 1 slice offsets, Permutation the original row of every sorted row
+struct DeviceSparseMatrix
+{
+	SpmvFormat Format = SpmvFormat::CsrScalar;
+	uint32_t Rows = 0;
+	uint32_t Cols = 0;
+	uint64_t NonZeros = 0;
+	// Entries in Columns and Values, NonZeros plus the SELL padding
+	uint64_t StoredEntries = 0;
+	uint32_t NumSlices = 0;
+	ComputeBuffer RowOffsets;
+	ComputeBuffer Columns;
+	ComputeBuffer Values;
+	ComputeBuffer Permutation;
+};
+
+// Sparse matrix-vector products y = A * x with float values. Padding entries of SELL multiply x[0]
+// by zero, so an infinite or NaN x[0] spreads into padded rows. Buffers are bound whole, so every
+// array is limited to maxStorageBufferRange. Needs subgroup arithmetic in compute shaders
+class SparseMultiplier
+{
+public:
+	// Sigma must be a multiple of SliceHeight
+	explicit SparseMultiplier(ComputeContext& Context, uint32_t SliceHeight = 32, uint32_t Sigma = 1024);
+	~SparseMultiplier();
+
+	SparseMultiplier(const SparseMultiplier&) = delete;
+	SparseMultiplier& operator=(const SparseMultiplier&) = delete;
+
+	// Uploads CSR through the staging buffers in chunks and, for SELL, converts it on the GPU
+	DeviceSparseMatrix upload(const CsrMatrix& Matrix, SpmvFormat Format = SpmvFormat::Auto);
+	void destroy(DeviceSparseMatrix& Matrix);
+	SpmvFormat chooseFormat(const RowLengthStats& Stats, uint64_t NonZeros) const;
+
+	// x has Cols floats, y Rows floats
+	void multiply(const DeviceSparseMatrix& Matrix, const ComputeBuffer& X, const ComputeBuffer& Y);
+	JobTicket multiplyAsync(const DeviceSparseMatrix& Matrix, const ComputeBuffer& X, const ComputeBuffer& Y,
+							const std::vector<JobTicket>& Dependencies = {});
+
+	static bool isSupported(const ComputeContext& Context);
+	uint32_t getSliceHeight() const { return SliceHeight; }
+	uint32_t getSigma() const { return Sigma; }
+
+private:
+	// Appends the tickets of the chunk uploads to Uploaded
+	void uploadStaged(const ComputeBuffer& Buffer, const void* Data, vk::DeviceSize Size, std::vector<JobTicket>& Uploaded);
+	// Runs after Dependencies, which write the CSR buffers
+	void convertToSell(DeviceSparseMatrix& Matrix, uint64_t PaddedSize, const std::vector<JobTicket>& Dependencies);
+
+	ComputeContext& Context;
+	RadixSorter Sorter;
+	Scanner Scan;
+	uint32_t GroupSize = 0;
+	uint32_t SliceHeight = 0;
+	uint32_t Sigma = 0;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include <vulkan/vulkan.hpp>
+#include "vk_mem_alloc.h"
+
+// A piece of persistently mapped staging memory used as the source or destination of one copy
+struct StagingRegion
+{
+	vk::Buffer Buffer;
+	VmaAllocation Allocation = nullptr;
+	vk::DeviceSize Offset = 0;
+	vk::DeviceSize Size = 0;
+	uint8_t* Data = nullptr;
+};
+
+// Ring allocator over a single VMA_ALLOCATION_CREATE_MAPPED_BIT buffer. Producers reserve() a
+// region, write or read it through Data, and commit() it with the submission value after which
+// the GPU no longer touches it. retire() hands regions back once their value has completed.
+// Regions are reclaimed strictly in reservation order.
+class StagingRing
+{
+public:
+	StagingRing(VmaAllocator Allocator, vk::DeviceSize Capacity, VmaMemoryUsage Usage, uint32_t QueueFamilyIndex);
+	~StagingRing();
+
+	StagingRing(const StagingRing&) = delete;
+	StagingRing& operator=(const StagingRing&) = delete;
+
+	// Returns false when Size does not fit into the free part of the ring right now
+	bool reserve(vk::DeviceSize Size, StagingRegion& Region);
+	void commit(const StagingRegion& Region, uint64_t RetireValue);
+	void retire(uint64_t CompletedValue);
+
+	vk::DeviceSize getCapacity() const { return Capacity; }
+	// Bytes between the oldest region still in flight and the next reservation
+	vk::DeviceSize getBytesInFlight() const;
+
+private:
+	struct InFlightRegion
+	{
+		vk::DeviceSize Offset;
+		vk::DeviceSize End;
+		uint64_t RetireValue;
+	};
+
+	VmaAllocator Allocator = nullptr;
+	vk::Buffer Buffer;
+	VmaAllocation Allocation = nullptr;
+	uint8_t* Mapped = nullptr;
+	vk::DeviceSize Capacity = 0;
+	// Next free byte and start of the oldest region in flight
+	vk::DeviceSize Head = 0;
+	vk::DeviceSize Tail = 0;
+	std::deque<InFlightRegion> InFlightRegions;
+};
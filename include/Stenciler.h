@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ComputeContext.h"
+#include "Kernels.h"
+
+// A stencil over a float grid of SizeX * SizeY * SizeZ cells, x fastest. 2D grids have SizeZ 1
+struct StencilParams
+{
+	uint32_t Dims = 2;
+	uint32_t SizeX = 0;
+	uint32_t SizeY = 0;
+	uint32_t SizeZ = 1;
+	kernels::StencilShape Shape = kernels::StencilShape::Star;
+	uint32_t Radius = 1;
+	// kernels::getStencilCoefficientCount(Dims, Shape, Radius) weights, ordered as described in
+	// shaders/stencil.comp
+	std::vector<float> Coefficients;
+	kernels::StencilBoundary Boundary = kernels::StencilBoundary::Clamp;
+	// Value of the cells outside the grid for StencilBoundary::Constant
+	float BoundaryValue = 0.0f;
+	// Timesteps every dispatch takes in shared memory, 0 picks them with the tile
+	uint32_t TemporalSteps = 0;
+};
+
+// Halo-tiled stencils with temporal blocking: every workgroup reads its tile and halo once and
+// takes several timesteps before writing the tile back, trading redundant halo updates for
+// global memory traffic. The grids are bound whole, so they are limited to maxStorageBufferRange
+class Stenciler
+{
+public:
+	explicit Stenciler(ComputeContext& Context);
+	~Stenciler();
+
+	Stenciler(const Stenciler&) = delete;
+	Stenciler& operator=(const Stenciler&) = delete;
+
+	// Advances Grid by Steps timesteps. Scratch has the size of Grid and holds every other timestep,
+	// the result always ends up in Grid
+	void apply(const ComputeBuffer& Grid, const ComputeBuffer& Scratch, uint32_t Steps, const StencilParams& Params);
+	JobTicket applyAsync(const ComputeBuffer& Grid, const ComputeBuffer& Scratch, uint32_t Steps, const StencilParams& Params,
+						 const std::vector<JobTicket>& Dependencies = {});
+
+	// The tile and timesteps per dispatch used for Params, fitted to the shared memory limit
+	kernels::StencilTile chooseTile(const StencilParams& Params) const;
+
+	// Upper bound of the timesteps per dispatch chooseTile picks, more mostly adds redundant work
+	static constexpr uint32_t MaxTemporalSteps = 4;
+
+private:
+	void ensureCoefficients(vk::DeviceSize Size);
+
+	ComputeContext& Context;
+	uint32_t Threads = 0;
+	ComputeBuffer CoefficientBuffer;
+	JobTicket LastApply;
+};
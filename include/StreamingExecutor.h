@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "ComputeContext.h"
+
+// Elementwise stages a StreamingExecutor can run, all on 32 bit elements
+enum class StreamOp
+{
+	// Output = Input0 + Input1, kernels::add()
+	Add,
+	// Output = Input0 * Input0, kernels::square()
+	Square
+};
+
+uint32_t getStreamOpInputCount(StreamOp Op);
+
+struct StreamingOptions
+{
+	// Elements per chunk. Every chunk in flight holds its uploads and readback in the context's
+	// staging rings, keep NumBufferSets * (inputs + 1) chunks within ContextOptions::StagingRingSize
+	uint64_t ChunkElements = 1024 * 1024;
+	// Device buffer sets cycled through upload -> dispatch -> readback, 3 keeps one in each step
+	uint32_t NumBufferSets = 3;
+};
+
+struct StreamingStats
+{
+	uint64_t NumElements = 0;
+	uint64_t NumChunks = 0;
+	// Uploaded plus read back
+	uint64_t BytesTransferred = 0;
+	double Seconds = 0.0;
+
+	double getGigabytesPerSecond() const { return Seconds > 0.0 ? BytesTransferred / Seconds * 1e-9 : 0.0; }
+};
+
+// Streams inputs of any length through a device that only holds NumBufferSets chunks at a time
+class StreamingExecutor
+{
+public:
+	// Fills Inputs[0 .. inputs) with up to MaxElements elements each and returns how many it wrote,
+	// 0 ends the stream
+	using ChunkSource = std::function<uint64_t(uint32_t* const* Inputs, uint64_t MaxElements)>;
+	// Receives the results of the chunks in stream order
+	using ChunkSink = std::function<void(const uint32_t* Output, uint64_t NumElements)>;
+
+	StreamingExecutor(ComputeContext& Context, StreamOp Op, const StreamingOptions& Options = StreamingOptions());
+	~StreamingExecutor();
+
+	StreamingExecutor(const StreamingExecutor&) = delete;
+	StreamingExecutor& operator=(const StreamingExecutor&) = delete;
+
+	StreamingStats run(const ChunkSource& Source, const ChunkSink& Sink);
+
+private:
+	struct BufferSet
+	{
+		std::vector<ComputeBuffer> Inputs;
+		ComputeBuffer Output;
+		std::vector<std::vector<uint32_t>> HostInputs;
+		std::vector<uint32_t> HostOutput;
+		JobTicket Ticket;
+		uint64_t NumElements = 0;
+	};
+
+	// Waits for the set's chunk in flight and hands its result to Sink
+	void drain(BufferSet& Set, const ChunkSink& Sink);
+
+	ComputeContext& Context;
+	StreamOp Op;
+	StreamingOptions Options;
+	const ComputeKernel* Kernel = nullptr;
+	std::vector<BufferSet> BufferSets;
+};
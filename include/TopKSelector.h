@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ComputeContext.h"
+#include "Kernels.h"
+#include "RadixSorter.h"
+#include "SegmentedSorter.h"
+
+struct TopKOptions
+{
+	// The K largest elements, otherwise the K smallest. Positive NaNs count as the largest floats
+	bool bLargest = true;
+	// Best first (largest first for bLargest). Equal elements are in no particular order, and without
+	// bSorted neither is anything else
+	bool bSorted = false;
+};
+
+template <typename T>
+struct TopKResult
+{
+	std::vector<T> Values;
+	// Where every value is in the input
+	std::vector<uint32_t> Indices;
+};
+
+// Selects the K largest or smallest of up to 2^32 - 1 32-bit elements with a radix select: three
+// histogram passes over the elements narrow down the K-th element 11 bits at a time, without a host
+// round trip, then one pass writes the elements up to it and their indices. Ties at the K-th element
+// are broken arbitrarily. Inputs larger than maxStorageBufferRange are bound window by window.
+// The sorted output sorts only the K selected elements, in shared memory when they fit one workgroup
+// and with RadixSorter otherwise
+class TopKSelector
+{
+public:
+	explicit TopKSelector(ComputeContext& Context);
+	~TopKSelector();
+
+	TopKSelector(const TopKSelector&) = delete;
+	TopKSelector& operator=(const TopKSelector&) = delete;
+
+	// T is uint32_t, int32_t or float. Reads back only the K selected elements
+	template <typename T>
+	TopKResult<T> select(const ComputeBuffer& Input, uint64_t NumElements, uint32_t K, const TopKOptions& Options = TopKOptions());
+	// Writes K elements of Type to Values and their indices to Indices.
+	// Runs after Dependencies and after the previous selection of this TopKSelector, which shares its state
+	JobTicket selectAsync(const ComputeBuffer& Input, uint64_t NumElements, kernels::ElementType Type, uint32_t K, const ComputeBuffer& Values,
+						  const ComputeBuffer& Indices, const TopKOptions& Options = TopKOptions(),
+						  const std::vector<JobTicket>& Dependencies = {});
+
+private:
+	void ensureBuffer(ComputeBuffer& Buffer, vk::DeviceSize Size);
+
+	ComputeContext& Context;
+	uint32_t GroupSize = 0;
+	// Prefix, mask, counters and bins of shaders/top_k.comp
+	ComputeBuffer State;
+	// The one segment a small sorted selection is sorted as
+	ComputeBuffer SegmentOffsets;
+	// Outputs of select()
+	ComputeBuffer ResultValues;
+	ComputeBuffer ResultIndices;
+	SegmentedSorter SmallSorter;
+	// Created on the first sorted selection too large for SmallSorter's shared memory
+	std::unique_ptr<RadixSorter> LargeSorter;
+	JobTicket LastJob;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+class ComputeContext;
+struct ComputeJob;
+
+// Best workgroup size per (kernel, device, element count bucket), persisted as a text file
+// with one "<device> <kernel> <bucket> <group size>" entry per line
+class WorkgroupSizeCache
+{
+public:
+	explicit WorkgroupSizeCache(std::string FilePath);
+
+	// Selects the device whose entries find() and store() operate on
+	void setDevice(const vk::PhysicalDeviceProperties& DeviceProps);
+	// Returns 0 when nothing was tuned for this kernel and bucket
+	uint32_t find(const std::string& KernelName, uint64_t ElementCount) const;
+	void store(const std::string& KernelName, uint64_t ElementCount, uint32_t GroupSize);
+	void save() const;
+
+	// Element counts are bucketed by floor(log2(ElementCount))
+	static uint32_t bucketOf(uint64_t ElementCount);
+
+private:
+	std::string makeKey(const std::string& KernelName, uint64_t ElementCount) const;
+
+	std::string FilePath;
+	std::string DeviceKey;
+	// Entries of all devices, so saving never drops what other devices tuned
+	std::map<std::string, uint32_t> Entries;
+};
+
+// Sweeps power of two workgroup sizes up to maxComputeWorkGroupInvocations for a job and
+// stores the fastest one in the context's WorkgroupSizeCache
+class WorkgroupTuner
+{
+public:
+	explicit WorkgroupTuner(ComputeContext& Context);
+
+	std::vector<uint32_t> candidateSizes() const;
+	// Job must use a tunable kernel and set ElementCount, its GroupSize is ignored
+	uint32_t tune(const ComputeJob& Job, uint32_t Iterations = 5);
+	// (group size, ns per dispatch) of the last tune() call
+	const std::vector<std::pair<uint32_t, double>>& getLastSweep() const { return LastSweep; }
+
+private:
+	ComputeContext& Context;
+	std::vector<std::pair<uint32_t, double>> LastSweep;
+};
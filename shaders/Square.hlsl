@@ -1,9 +1,32 @@
-
 [[vk::binding(0, 0)]] RWStructuredBuffer<int> InBuffer;
 [[vk::binding(1, 0)]] RWStructuredBuffer<int> OutBuffer;
 
-[numthreads(1, 1, 1)]
-void main(uint3 DTid : SV_DispatchThreadID)
+// Workgroup size comes from specialization constant 0, tuned per device by WorkgroupTuner
+[[vk::constant_id(0)]] const uint GroupSize = 64;
+
+// Mirrors DispatchParams in include/DispatchPlanner.h
+struct DispatchParams
+{
+	uint IndexOffset;
+	uint ElementCount;
+	uint GroupCountX;
+	uint GroupCountY;
+};
+[[vk::push_constant]] DispatchParams Params;
+
+[numthreads(GroupSize, 1, 1)]
+void main(uint3 GroupId : SV_GroupID, uint3 GroupThreadId : SV_GroupThreadID)
 {
-	OutBuffer[DTid.x] = InBuffer[DTid.x] * InBuffer[DTid.x];
+	uint Group = (GroupId.z * Params.GroupCountY + GroupId.y) * Params.GroupCountX + GroupId.x;
+	if (Params.ElementCount == 0 || Group > (Params.ElementCount - 1) / GroupSize)
+	{
+		return;
+	}
+	uint Index = Group * GroupSize + GroupThreadId.x;
+	if (Index >= Params.ElementCount)
+	{
+		return;
+	}
+	Index += Params.IndexOffset;
+	OutBuffer[Index] = InBuffer[Index] * InBuffer[Index];
 }
@@ -0,0 +1,16 @@
+// Shared by the elementwise kernels, mirrors DispatchParams in include/DispatchPlanner.h.
+// Put DISPATCH_PARAMS first in the push constant block, kernel parameters follow at offset 16.
+#define DISPATCH_PARAMS uint IndexOffset; uint ElementCount; uint GroupCountX; uint GroupCountY;
+
+// Folds the 3D grid back into a slice-local linear index. Returns false for the invocations
+// past ElementCount that the rounded up grid launches.
+bool dispatchIndex(uint ElementCount, out uint Index)
+{
+    Index = 0;
+    uint Group = (gl_WorkGroupID.z * gl_NumWorkGroups.y + gl_WorkGroupID.y) * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    // Compare groups first so that Group * gl_WorkGroupSize.x cannot wrap around
+    if (ElementCount == 0 || Group > (ElementCount - 1) / gl_WorkGroupSize.x)
+        return false;
+    Index = Group * gl_WorkGroupSize.x + gl_LocalInvocationID.x;
+    return Index < ElementCount;
+}
@@ -0,0 +1,104 @@
+// Stockham auto-sort FFT shared by fft_shared.comp and fft_pass.comp, which declare the twiddles
+// buffer before including this file. A pass with radix R after Ns points of every sub-transform
+// are done runs N / R butterflies: butterfly J reads the R inputs J + i * N / R, twiddles them by
+// W_N^(i * (J % Ns) * N / (Ns * R)), takes their DFT and writes output i to
+// (J / Ns) * Ns * R + J % Ns + i * Ns. Radices are 2, 3, 4 and 5, radix 1 copies.
+// Complex values are vec2 (real, imaginary), the twiddle table holds W_N^m = exp(-2 pi i m / N)
+layout(constant_id = 1) const bool INVERSE = false;
+
+const uint MAX_RADIX = 5;
+
+vec2 complexMul(vec2 A, vec2 B)
+{
+    return vec2(A.x * B.x - A.y * B.y, A.x * B.y + A.y * B.x);
+}
+
+// Times -i for the forward transform, times i for the inverse
+vec2 rotateQuarter(vec2 A)
+{
+    return INVERSE ? vec2(-A.y, A.x) : vec2(A.y, -A.x);
+}
+
+// Largest supported radix of the Remaining points, the same order FourierTransformer plans with
+uint radixOf(uint Remaining)
+{
+    if (Remaining % 4 == 0)
+        return 4;
+    if (Remaining % 2 == 0)
+        return 2;
+    return Remaining % 3 == 0 ? 3 : 5;
+}
+
+// In place DFT of X[0..Radix)
+void butterfly(inout vec2 X[MAX_RADIX], uint Radix)
+{
+    if (Radix == 2)
+    {
+        vec2 A = X[0];
+        X[0] = A + X[1];
+        X[1] = A - X[1];
+    }
+    else if (Radix == 4)
+    {
+        vec2 T0 = X[0] + X[2];
+        vec2 T1 = X[0] - X[2];
+        vec2 T2 = X[1] + X[3];
+        vec2 T3 = rotateQuarter(X[1] - X[3]);
+        X[0] = T0 + T2;
+        X[1] = T1 + T3;
+        X[2] = T0 - T2;
+        X[3] = T1 - T3;
+    }
+    else if (Radix == 3)
+    {
+        const float SIN_60 = 0.866025403784438647;
+        vec2 Sum = X[1] + X[2];
+        vec2 Middle = X[0] - 0.5 * Sum;
+        vec2 Rotated = rotateQuarter(SIN_60 * (X[1] - X[2]));
+        X[0] += Sum;
+        X[1] = Middle + Rotated;
+        X[2] = Middle - Rotated;
+    }
+    else if (Radix == 5)
+    {
+        const float COS_72 = 0.309016994374947424;
+        const float COS_144 = -0.809016994374947424;
+        const float SIN_72 = 0.951056516295153572;
+        const float SIN_144 = 0.587785252292473129;
+        vec2 S1 = X[1] + X[4];
+        vec2 D1 = X[1] - X[4];
+        vec2 S2 = X[2] + X[3];
+        vec2 D2 = X[2] - X[3];
+        vec2 A1 = X[0] + COS_72 * S1 + COS_144 * S2;
+        vec2 A2 = X[0] + COS_144 * S1 + COS_72 * S2;
+        vec2 B1 = rotateQuarter(SIN_72 * D1 + SIN_144 * D2);
+        vec2 B2 = rotateQuarter(SIN_144 * D1 - SIN_72 * D2);
+        X[0] += S1 + S2;
+        X[1] = A1 + B1;
+        X[2] = A2 + B2;
+        X[3] = A2 - B2;
+        X[4] = A1 - B1;
+    }
+}
+
+// Twiddles and transforms the inputs of butterfly J
+void stockhamButterfly(inout vec2 X[MAX_RADIX], uint J, uint Radix, uint Ns, uint N)
+{
+    uint K = J % Ns;
+    if (Ns > 1)
+    {
+        uint Step = K * (N / (Ns * Radix));
+        for (uint I = 1; I < Radix; ++I)
+        {
+            vec2 Twiddle = twiddles.val[I * Step];
+            X[I] = complexMul(X[I], INVERSE ? vec2(Twiddle.x, -Twiddle.y) : Twiddle);
+        }
+    }
+    butterfly(X, Radix);
+}
+
+// Where output 0 of butterfly J goes, output i follows at i * Ns
+uint stockhamOutput(uint J, uint Radix, uint Ns)
+{
+    return (J / Ns) * Ns * Radix + J % Ns;
+}
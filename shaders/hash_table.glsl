@@ -0,0 +1,260 @@
+// Open addressing hash table with linear probing, shared by hash_table_<type>.comp, which define
+// KEY_T, KEY_EMPTY, KEY_TOMBSTONE and uint hashKey(KEY_T) before including this file. The table is
+// NumSlots keys and as many uint values; a key is placed at the first free slot at or after
+// hashKey(Key) * NumSlots / 2^32, wrapping around at the end. Slots start as KEY_EMPTY and become
+// KEY_TOMBSTONE when erased, which probes skip and inserts do not reuse.
+//   MODE 0: inserts the keys with their values (their indices without HAS_VALUES). UNIQUE keys take
+//           one slot each and keep the smallest value inserted, otherwise every pair takes a slot
+//   MODE 1: writes the value of every key, NOT_FOUND for missing ones
+//   MODE 2: erases every slot holding one of the keys
+//   MODE 3: writes the live slots densely to the key and value outputs, up to OutputCapacity of
+//           them, and counts them all. The grid covers the slots
+//   MODE 4: counts the slots matching every probe key, Scanner turns the counts into offsets
+//   MODE 5: writes the (probe index, value) pair of every match from the scanned offsets, up to
+//           OutputCapacity pairs
+// The status counters are updated with one atomic per workgroup. Mirrors HashTableMode in
+// include/Kernels.h and the status layout in include/HashTable.h
+#include "dispatch.glsl"
+
+layout(local_size_x = 256, local_size_x_id = 0) in;
+layout(constant_id = 1) const uint MODE = 0;
+layout(constant_id = 2) const bool UNIQUE = true;
+layout(constant_id = 3) const bool HAS_VALUES = true;
+
+const uint MODE_INSERT = 0;
+const uint MODE_FIND = 1;
+const uint MODE_ERASE = 2;
+const uint MODE_RETRIEVE = 3;
+const uint MODE_JOIN_COUNT = 4;
+const uint MODE_JOIN_WRITE = 5;
+
+const uint NOT_FOUND = 0xffffffffu;
+
+// Live keys, slots ever taken, keys that found no free slot, retrieved slots, join matches
+const uint STATUS_LIVE = 0;
+const uint STATUS_USED = 1;
+const uint STATUS_FAILED = 2;
+const uint STATUS_RETRIEVED = 3;
+const uint STATUS_MATCHES = 4;
+const uint STATUS_WORDS = 5;
+
+layout(binding = 0) coherent buffer TableKeys {
+    KEY_T val[];
+} tableKeys;
+layout(binding = 1) coherent buffer TableValues {
+    uint val[];
+} tableValues;
+// Input keys, or the retrieved keys
+layout(binding = 2) buffer Keys {
+    KEY_T val[];
+} keysData;
+// Input values (MODE 0), found values (1), retrieved values (3), per probe key counts (4) and
+// their exclusive scan (5). Bound to the table values when unused
+layout(binding = 3) buffer Values {
+    uint val[];
+} valuesData;
+layout(binding = 4) writeonly buffer OutProbeIndices {
+    uint val[];
+} outProbeIndices;
+layout(binding = 5) writeonly buffer OutBuildValues {
+    uint val[];
+} outBuildValues;
+layout(binding = 6) buffer Status {
+    uint val[];
+} status;
+
+layout(push_constant) uniform PushConstants {
+    DISPATCH_PARAMS
+    // Input keys, or the slots for MODE 3
+    uint NumKeys;
+    uint NumSlots;
+    uint OutputCapacity;
+} params;
+
+shared uint SharedCounters[STATUS_WORDS];
+shared uint SharedBase;
+
+// The marker keys cannot be stored, inserting them counts as failed
+bool isMarker(KEY_T Key)
+{
+    return Key == KEY_EMPTY || Key == KEY_TOMBSTONE;
+}
+
+uint homeSlot(KEY_T Key)
+{
+    uint Slot;
+    uint Low;
+    umulExtended(hashKey(Key), params.NumSlots, Slot, Low);
+    return Slot;
+}
+
+uint nextSlot(uint Slot)
+{
+    return Slot + 1 == params.NumSlots ? 0 : Slot + 1;
+}
+
+void insertKey(KEY_T Key, uint Value)
+{
+    if (isMarker(Key))
+    {
+        atomicAdd(SharedCounters[STATUS_FAILED], 1);
+        return;
+    }
+    uint Slot = homeSlot(Key);
+    for (uint Probe = 0; Probe < params.NumSlots; ++Probe)
+    {
+        KEY_T Found = tableKeys.val[Slot];
+        if (Found == KEY_EMPTY)
+        {
+            Found = atomicCompSwap(tableKeys.val[Slot], KEY_EMPTY, Key);
+            if (Found == KEY_EMPTY)
+            {
+                if (UNIQUE)
+                    atomicMin(tableValues.val[Slot], Value);
+                else
+                    tableValues.val[Slot] = Value;
+                atomicAdd(SharedCounters[STATUS_LIVE], 1);
+                atomicAdd(SharedCounters[STATUS_USED], 1);
+                return;
+            }
+        }
+        // Found is the slot's key now, another invocation may just have taken it for the same key
+        if (UNIQUE && Found == Key)
+        {
+            atomicMin(tableValues.val[Slot], Value);
+            return;
+        }
+        Slot = nextSlot(Slot);
+    }
+    atomicAdd(SharedCounters[STATUS_FAILED], 1);
+}
+
+uint findKey(KEY_T Key)
+{
+    if (isMarker(Key))
+        return NOT_FOUND;
+    uint Slot = homeSlot(Key);
+    for (uint Probe = 0; Probe < params.NumSlots; ++Probe)
+    {
+        KEY_T Found = tableKeys.val[Slot];
+        if (Found == Key)
+            return tableValues.val[Slot];
+        if (Found == KEY_EMPTY)
+            break;
+        Slot = nextSlot(Slot);
+    }
+    return NOT_FOUND;
+}
+
+void eraseKey(KEY_T Key)
+{
+    if (isMarker(Key))
+        return;
+    uint Slot = homeSlot(Key);
+    for (uint Probe = 0; Probe < params.NumSlots; ++Probe)
+    {
+        KEY_T Found = tableKeys.val[Slot];
+        if (Found == KEY_EMPTY)
+            break;
+        // The same key may be erased by another invocation, only the one swapping it counts
+        if (Found == Key && atomicCompSwap(tableKeys.val[Slot], Key, KEY_TOMBSTONE) == Key)
+        {
+            atomicAdd(SharedCounters[STATUS_LIVE], 0xffffffffu);
+            if (UNIQUE)
+                break;
+        }
+        Slot = nextSlot(Slot);
+    }
+}
+
+// Matches of Key, written from Offset on when bWrite
+uint joinKey(KEY_T Key, uint ProbeIndex, bool bWrite, uint Offset)
+{
+    uint Matches = 0;
+    if (isMarker(Key))
+        return Matches;
+    uint Slot = homeSlot(Key);
+    for (uint Probe = 0; Probe < params.NumSlots; ++Probe)
+    {
+        KEY_T Found = tableKeys.val[Slot];
+        if (Found == KEY_EMPTY)
+            break;
+        if (Found == Key)
+        {
+            uint Output = Offset + Matches;
+            if (bWrite && Output < params.OutputCapacity)
+            {
+                outProbeIndices.val[Output] = ProbeIndex;
+                outBuildValues.val[Output] = tableValues.val[Slot];
+            }
+            ++Matches;
+            if (UNIQUE)
+                break;
+        }
+        Slot = nextSlot(Slot);
+    }
+    return Matches;
+}
+
+void main()
+{
+    uint Local = gl_LocalInvocationID.x;
+    if (Local < STATUS_WORDS)
+        SharedCounters[Local] = 0;
+    barrier();
+
+    uint Index;
+    bool bActive = dispatchIndex(params.ElementCount, Index);
+    Index += params.IndexOffset;
+    bActive = bActive && Index < params.NumKeys;
+
+    if (MODE == MODE_RETRIEVE)
+    {
+        KEY_T Key = bActive ? tableKeys.val[Index] : KEY_EMPTY;
+        bool bLive = !isMarker(Key);
+        uint LocalOffset = bLive ? atomicAdd(SharedCounters[STATUS_RETRIEVED], 1) : 0;
+        barrier();
+        if (Local == 0)
+        {
+            uint Count = SharedCounters[STATUS_RETRIEVED];
+            SharedBase = Count != 0 ? atomicAdd(status.val[STATUS_RETRIEVED], Count) : 0;
+        }
+        barrier();
+        if (bLive && SharedBase + LocalOffset < params.OutputCapacity)
+        {
+            keysData.val[SharedBase + LocalOffset] = Key;
+            valuesData.val[SharedBase + LocalOffset] = tableValues.val[Index];
+        }
+        return;
+    }
+
+    if (bActive)
+    {
+        KEY_T Key = keysData.val[Index];
+        if (MODE == MODE_INSERT)
+        {
+            insertKey(Key, HAS_VALUES ? valuesData.val[Index] : Index);
+        }
+        else if (MODE == MODE_FIND)
+        {
+            valuesData.val[Index] = findKey(Key);
+        }
+        else if (MODE == MODE_ERASE)
+        {
+            eraseKey(Key);
+        }
+        else if (MODE == MODE_JOIN_COUNT)
+        {
+            uint Matches = joinKey(Key, Index, false, 0);
+            valuesData.val[Index] = Matches;
+            atomicAdd(SharedCounters[STATUS_MATCHES], Matches);
+        }
+        else
+        {
+            joinKey(Key, Index, true, valuesData.val[Index]);
+        }
+    }
+    barrier();
+    if (Local < STATUS_WORDS && SharedCounters[Local] != 0)
+        atomicAdd(status.val[Local], SharedCounters[Local]);
+}
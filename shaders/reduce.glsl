@@ -0,0 +1,149 @@
+// Two-level reduction shared by reduce_<type>.comp, which define VALUE_T, VALUE_MAX and
+// VALUE_LOWEST before including this file. Every workgroup reduces its invocations' grid-stride
+// ranges with subgroup arithmetic, then the per-subgroup results through shared memory.
+// STAGE 0 reduces the input window into one Partial per workgroup, STAGE 1 reduces those partials.
+// Mirrors ReduceOp in include/Kernels.h
+#extension GL_KHR_shader_subgroup_basic : require
+#extension GL_KHR_shader_subgroup_arithmetic : require
+#include "dispatch.glsl"
+
+layout(local_size_x = 256, local_size_x_id = 0) in;
+layout(constant_id = 1) const uint OP = 0;
+layout(constant_id = 2) const uint STAGE = 0;
+
+const uint OP_SUM = 0;
+const uint OP_MIN = 1;
+const uint OP_MAX = 2;
+const uint OP_ARGMIN = 3;
+const uint OP_ARGMAX = 4;
+
+const uint NO_INDEX = 0xffffffffu;
+
+struct Partial {
+    VALUE_T Value;
+    // Index of the first element holding Value, arg ops only
+    uint Index;
+};
+
+// Both input views alias binding 0, the one matching STAGE is used
+layout(binding = 0) readonly buffer Input {
+    VALUE_T val[];
+} inputData;
+layout(binding = 0) readonly buffer InputPartials {
+    Partial val[];
+} inputPartials;
+layout(binding = 1) writeonly buffer Output {
+    Partial val[];
+} outputData;
+
+layout(push_constant) uniform PushConstants {
+    DISPATCH_PARAMS
+    // Elements (STAGE 0) or partials (STAGE 1) to reduce
+    uint NumElements;
+    // Global index of the first element of the bound input window
+    uint FirstIndex;
+    // Where the partial of workgroup 0 goes
+    uint OutputOffset;
+} params;
+
+shared VALUE_T SharedValues[gl_WorkGroupSize.x];
+shared uint SharedIndices[gl_WorkGroupSize.x];
+
+VALUE_T identity()
+{
+    if (OP == OP_SUM)
+        return VALUE_T(0);
+    return OP == OP_MIN || OP == OP_ARGMIN ? VALUE_MAX : VALUE_LOWEST;
+}
+
+void combine(inout VALUE_T Value, inout uint Index, VALUE_T Other, uint OtherIndex)
+{
+    if (OP == OP_SUM)
+    {
+        Value += Other;
+    }
+    else if (OP == OP_MIN)
+    {
+        Value = min(Value, Other);
+    }
+    else if (OP == OP_MAX)
+    {
+        Value = max(Value, Other);
+    }
+    else
+    {
+        bool bBetter = OP == OP_ARGMIN ? Other < Value : Other > Value;
+        if (bBetter || (Other == Value && OtherIndex < Index))
+        {
+            Value = Other;
+            Index = OtherIndex;
+        }
+    }
+}
+
+void reduceSubgroup(inout VALUE_T Value, inout uint Index)
+{
+    if (OP == OP_SUM)
+    {
+        Value = subgroupAdd(Value);
+    }
+    else if (OP == OP_MIN || OP == OP_ARGMIN)
+    {
+        VALUE_T Best = subgroupMin(Value);
+        if (OP == OP_ARGMIN)
+            Index = subgroupMin(Value == Best ? Index : NO_INDEX);
+        Value = Best;
+    }
+    else
+    {
+        VALUE_T Best = subgroupMax(Value);
+        if (OP == OP_ARGMAX)
+            Index = subgroupMin(Value == Best ? Index : NO_INDEX);
+        Value = Best;
+    }
+}
+
+void main()
+{
+    // No early return, every invocation takes part in the barrier
+    uint Group = (gl_WorkGroupID.z * gl_NumWorkGroups.y + gl_WorkGroupID.y) * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uint Stride = gl_NumWorkGroups.x * gl_NumWorkGroups.y * gl_NumWorkGroups.z * gl_WorkGroupSize.x;
+
+    VALUE_T Value = identity();
+    uint Index = NO_INDEX;
+    for (uint I = Group * gl_WorkGroupSize.x + gl_LocalInvocationID.x; I < params.NumElements; I += Stride)
+    {
+        if (STAGE == 0)
+        {
+            combine(Value, Index, inputData.val[I], params.FirstIndex + I);
+        }
+        else
+        {
+            Partial Other = inputPartials.val[I];
+            combine(Value, Index, Other.Value, Other.Index);
+        }
+    }
+
+    reduceSubgroup(Value, Index);
+    if (subgroupElect())
+    {
+        SharedValues[gl_SubgroupID] = Value;
+        SharedIndices[gl_SubgroupID] = Index;
+    }
+    barrier();
+    if (gl_SubgroupID == 0)
+    {
+        Value = identity();
+        Index = NO_INDEX;
+        for (uint S = gl_SubgroupInvocationID; S < gl_NumSubgroups; S += gl_SubgroupSize)
+        {
+            combine(Value, Index, SharedValues[S], SharedIndices[S]);
+        }
+        reduceSubgroup(Value, Index);
+        // The planned grid may round up past the workgroups the host asked for
+        if (subgroupElect() && Group * gl_WorkGroupSize.x < params.ElementCount)
+        {
+            outputData.val[params.OutputOffset + Group] = Partial(Value, Index);
+        }
+    }
+}
@@ -0,0 +1,27 @@
+// Key order shared by segmented_sort.comp and merge.comp. Keys are compared as uints after a
+// transform that preserves the order of their type: ints get their sign bit flipped, floats all
+// bits when negative and the sign bit otherwise. -0 sorts before +0, NaNs after +inf (or before
+// -inf when their sign bit is set). Mirrors ElementType in include/Kernels.h
+layout(constant_id = 1) const uint KEY_TYPE = 0;
+
+const uint TYPE_UINT = 0;
+const uint TYPE_INT = 1;
+const uint TYPE_FLOAT = 2;
+
+uint sortableKey(uint Bits)
+{
+    if (KEY_TYPE == TYPE_INT)
+        return Bits ^ 0x80000000u;
+    if (KEY_TYPE == TYPE_FLOAT)
+        return (Bits & 0x80000000u) != 0 ? ~Bits : Bits | 0x80000000u;
+    return Bits;
+}
+
+uint keyBits(uint Sortable)
+{
+    if (KEY_TYPE == TYPE_INT)
+        return Sortable ^ 0x80000000u;
+    if (KEY_TYPE == TYPE_FLOAT)
+        return (Sortable & 0x80000000u) != 0 ? Sortable & 0x7fffffffu : ~Sortable;
+    return Sortable;
+}
@@ -0,0 +1,244 @@
+#include "Compactor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	// Workgroups of an unordered compaction stride over the tiles beyond this
+	constexpr uint32_t MaxGroups = 4096;
+	// Smallest subgroup the driver may pick for a compute pipeline without subgroup size control
+	constexpr uint32_t MinSubgroupSize = 8;
+
+	template <typename T>
+	struct ElementTypeOf;
+	template <>
+	struct ElementTypeOf<uint32_t> { static constexpr kernels::ElementType Value = kernels::ElementType::Uint; };
+	template <>
+	struct ElementTypeOf<int32_t> { static constexpr kernels::ElementType Value = kernels::ElementType::Int; };
+	template <>
+	struct ElementTypeOf<float> { static constexpr kernels::ElementType Value = kernels::ElementType::Float; };
+
+	template <typename T>
+	uint32_t bitsOf(T Value)
+	{
+		uint32_t Bits;
+		std::memcpy(&Bits, &Value, sizeof(Bits));
+		return Bits;
+	}
+
+	uint32_t tilesOf(uint64_t NumElements, uint32_t TileSize)
+	{
+		return static_cast<uint32_t>((NumElements + TileSize - 1) / TileSize);
+	}
+}
+
+template <typename T>
+CompactFilter CompactFilter::compare(kernels::CompareOp Op, T Value)
+{
+	CompactFilter Filter;
+	Filter.Predicate = kernels::CompactPredicate::Compare;
+	Filter.Compare = Op;
+	Filter.Type = ElementTypeOf<T>::Value;
+	Filter.A = bitsOf(Value);
+	return Filter;
+}
+
+template <typename T>
+CompactFilter CompactFilter::range(T Min, T Max)
+{
+	CompactFilter Filter;
+	Filter.Predicate = kernels::CompactPredicate::Range;
+	Filter.Type = ElementTypeOf<T>::Value;
+	Filter.A = bitsOf(Min);
+	Filter.B = bitsOf(Max);
+	return Filter;
+}
+
+template <typename T>
+CompactFilter CompactFilter::nonZero()
+{
+	CompactFilter Filter;
+	Filter.Predicate = kernels::CompactPredicate::NonZero;
+	Filter.Type = ElementTypeOf<T>::Value;
+	return Filter;
+}
+
+CompactFilter CompactFilter::bitmask(uint32_t Mask, uint32_t Bits)
+{
+	CompactFilter Filter;
+	Filter.Predicate = kernels::CompactPredicate::Bitmask;
+	Filter.A = Mask;
+	Filter.B = Bits;
+	return Filter;
+}
+
+template CompactFilter CompactFilter::compare<uint32_t>(kernels::CompareOp, uint32_t);
+template CompactFilter CompactFilter::compare<int32_t>(kernels::CompareOp, int32_t);
+template CompactFilter CompactFilter::compare<float>(kernels::CompareOp, float);
+template CompactFilter CompactFilter::range<uint32_t>(uint32_t, uint32_t);
+template CompactFilter CompactFilter::range<int32_t>(int32_t, int32_t);
+template CompactFilter CompactFilter::range<float>(float, float);
+template CompactFilter CompactFilter::nonZero<uint32_t>();
+template CompactFilter CompactFilter::nonZero<int32_t>();
+template CompactFilter CompactFilter::nonZero<float>();
+
+Compactor::Compactor(ComputeContext& InContext)
+	: Context(InContext)
+	, Scan(InContext)
+{
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	GroupSize = std::min({ 256u, Limits.maxComputeWorkGroupInvocations, Limits.maxComputeWorkGroupSize[0] });
+	// The shader scans CompactItemsPerThread counters per subgroup with one invocation each
+	const uint32_t SmallestSubgroup = std::max(std::min(Context.getSubgroupProperties().subgroupSize, MinSubgroupSize), kernels::CompactItemsPerThread);
+	SubgroupSlots = std::max(GroupSize / SmallestSubgroup, 1u);
+	CountArgs = Context.createBuffer(CompactArgsSize);
+}
+
+Compactor::~Compactor()
+{
+	Context.waitIdle();
+	Context.destroyBuffer(Status);
+	Context.destroyBuffer(CountArgs);
+}
+
+bool Compactor::isSupported(const ComputeContext& Context)
+{
+	const vk::PhysicalDeviceSubgroupProperties& Subgroup = Context.getSubgroupProperties();
+	const vk::SubgroupFeatureFlags Needed = vk::SubgroupFeatureFlagBits::eBasic | vk::SubgroupFeatureFlagBits::eBallot;
+	return (Subgroup.supportedStages & vk::ShaderStageFlagBits::eCompute) && (Subgroup.supportedOperations & Needed) == Needed &&
+		Subgroup.subgroupSize >= kernels::CompactItemsPerThread && Subgroup.subgroupSize <= 128;
+}
+
+uint32_t Compactor::getTileSize() const
+{
+	return GroupSize * kernels::CompactItemsPerThread;
+}
+
+void Compactor::ensureStatus(vk::DeviceSize Size)
+{
+	if (Status.Size >= Size)
+	{
+		return;
+	}
+	if (LastJob.isValid())
+	{
+		LastJob.wait();
+	}
+	Context.destroyBuffer(Status);
+	Status = Context.createBuffer(Size);
+}
+
+ComputeJob Compactor::makeJob(kernels::CompactMode Mode, const ComputeBuffer& Input, const ComputeBuffer& Output, const ComputeBuffer& Args,
+							  const ComputeBuffer* InputArgs, const CompactFilter& Filter, uint32_t NumElements, uint32_t ElementsPerGroup)
+{
+	ComputeJob Job;
+	Job.Kernel = &Context.createKernel(kernels::compact(Mode, Filter.Predicate, Filter.Compare, Filter.Type, SubgroupSlots, InputArgs != nullptr));
+	Job.Buffers = { &Input, &Output, &Status, &Args, InputArgs ? InputArgs : &Args };
+	Job.GroupSize = GroupSize;
+	const uint32_t NumTiles = tilesOf(NumElements, getTileSize());
+	const uint32_t Values[] = { NumElements, NumTiles, Filter.A, Filter.B, ElementsPerGroup != 0 ? ElementsPerGroup : getTileSize() };
+	Job.PushConstants.resize(sizeof(Values));
+	std::memcpy(Job.PushConstants.data(), Values, sizeof(Values));
+	const uint32_t NumGroups = Mode == kernels::CompactMode::Unordered ? std::min(NumTiles, MaxGroups) : NumTiles;
+	Job.ElementCount = uint64_t(std::max(NumGroups, 1u)) * GroupSize;
+	return Job;
+}
+
+uint32_t Compactor::compact(const ComputeBuffer& Input, uint64_t NumElements, const ComputeBuffer& Output, const CompactFilter& Filter,
+							const CompactOptions& Options)
+{
+	compactAsync(Input, NumElements, Output, CountArgs, Filter, Options);
+	// Runs after every job submitted before it, so after the compaction
+	uint32_t Count = 0;
+	Context.readBuffer(CountArgs, &Count, sizeof(Count), CompactCountOffset);
+	return Count;
+}
+
+JobTicket Compactor::compactAsync(const ComputeBuffer& Input, uint64_t NumElements, const ComputeBuffer& Output, const ComputeBuffer& Args,
+								  const CompactFilter& Filter, const CompactOptions& Options, const std::vector<JobTicket>& Dependencies)
+{
+	if (NumElements == 0 || NumElements > UINT32_MAX)
+	{
+		throw std::invalid_argument("compactions take 1 to 2^32 - 1 elements");
+	}
+	const vk::DeviceSize Size = NumElements * sizeof(uint32_t);
+	if (Input.Size < Size || Output.Size < Size || Args.Size < CompactArgsSize)
+	{
+		throw std::invalid_argument("compaction buffers are smaller than their elements or args");
+	}
+	if (!isSupported(Context))
+	{
+		throw std::runtime_error("compaction needs subgroup ballots of 4 to 128 invocations in compute shaders");
+	}
+	const uint32_t NumTiles = tilesOf(NumElements, getTileSize());
+	ensureStatus(std::max<vk::DeviceSize>(NumTiles, 1) * sizeof(uint32_t));
+	std::vector<JobTicket> Waits = Dependencies;
+	if (LastJob.isValid())
+	{
+		Waits.push_back(LastJob);
+	}
+
+	const uint32_t Count = static_cast<uint32_t>(NumElements);
+	if (Options.Order == CompactOrder::Unordered)
+	{
+		ComputeJob Job = makeJob(kernels::CompactMode::Unordered, Input, Output, Args, nullptr, Filter, Count, Options.ElementsPerGroup);
+		// The finished-workgroup counter and the count the tiles add to
+		Job.Fills = { { &Status, 0, sizeof(uint32_t), 0 }, { &Args, 0, CompactArgsSize, 0 } };
+		LastJob = Context.submitAsync(Job, Waits);
+		return LastJob;
+	}
+
+	// 稳定路径: 先数每个 tile 保留的元素, 排他前缀和给出每个 tile 的输出起点, 再写出
+	const JobTicket Counted = Context.submitAsync(makeJob(kernels::CompactMode::CountTiles, Input, Output, Args, nullptr, Filter, Count,
+														  Options.ElementsPerGroup), Waits);
+	ScanOptions ScanOpts;
+	ScanOpts.bExclusive = true;
+	const JobTicket Scanned = Scan.scanAsync(Status, Status, NumTiles, ScanOpts, { Counted });
+	LastJob = Context.submitAsync(makeJob(kernels::CompactMode::ScatterScanned, Input, Output, Args, nullptr, Filter, Count,
+										  Options.ElementsPerGroup), { Scanned });
+	return LastJob;
+}
+
+JobTicket Compactor::compactIndirectAsync(const ComputeBuffer& Input, const ComputeBuffer& InputArgs, uint64_t Capacity,
+										  const ComputeBuffer& Output, const ComputeBuffer& Args, const CompactFilter& Filter,
+										  const CompactOptions& Options, const std::vector<JobTicket>& Dependencies)
+{
+	if (Options.Order != CompactOrder::Unordered)
+	{
+		throw std::invalid_argument("indirect compactions are unordered, the stable scan needs the count on the host");
+	}
+	if (Capacity == 0 || Capacity > UINT32_MAX)
+	{
+		throw std::invalid_argument("compactions take 1 to 2^32 - 1 elements");
+	}
+	const vk::DeviceSize Size = Capacity * sizeof(uint32_t);
+	if (Input.Size < Size || Output.Size < Size || InputArgs.Size < CompactArgsSize || Args.Size < CompactArgsSize)
+	{
+		throw std::invalid_argument("compaction buffers are smaller than their elements or args");
+	}
+	if (&InputArgs == &Args || InputArgs.Buffer == Args.Buffer)
+	{
+		throw std::invalid_argument("an indirect compaction cannot write the args it is dispatched from");
+	}
+	if (!isSupported(Context))
+	{
+		throw std::runtime_error("compaction needs subgroup ballots of 4 to 128 invocations in compute shaders");
+	}
+	ensureStatus(sizeof(uint32_t));
+	std::vector<JobTicket> Waits = Dependencies;
+	if (LastJob.isValid())
+	{
+		Waits.push_back(LastJob);
+	}
+
+	ComputeJob Job = makeJob(kernels::CompactMode::Unordered, Input, Output, Args, &InputArgs, Filter, static_cast<uint32_t>(Capacity),
+							 Options.ElementsPerGroup);
+	// The grid comes from InputArgs, the workgroups stride over however many tiles the count needs
+	Job.IndirectBuffer = &InputArgs;
+	Job.IndirectOffset = 0;
+	Job.Fills = { { &Status, 0, sizeof(uint32_t), 0 }, { &Args, 0, CompactArgsSize, 0 } };
+	LastJob = Context.submitAsync(Job, Waits);
+	return LastJob;
+}
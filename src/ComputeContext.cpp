@@ -0,0 +1,1322 @@
+#include "ComputeContext.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+	const char* ValidationLayerName = "VK_LAYER_KHRONOS_validation";
+	// 1.2 for timeline semaphores
+	constexpr uint32_t ApiVersion = VK_API_VERSION_1_2;
+
+	bool hasInstanceLayer(const char* LayerName)
+	{
+		const std::vector<vk::LayerProperties> LayerProps = vk::enumerateInstanceLayerProperties();
+		return std::any_of(LayerProps.begin(), LayerProps.end(), [LayerName](const vk::LayerProperties& Prop)
+		{
+			return std::strcmp(Prop.layerName.data(), LayerName) == 0;
+		});
+	}
+
+	bool findQueueFamily(vk::PhysicalDevice PhysicalDevice, vk::QueueFlags QueueBit, uint32_t& FamilyIndex)
+	{
+		const std::vector<vk::QueueFamilyProperties> QueueFamilyProps = PhysicalDevice.getQueueFamilyProperties();
+		auto PropIt = std::find_if(QueueFamilyProps.begin(), QueueFamilyProps.end(), [QueueBit](const vk::QueueFamilyProperties& Prop)
+		{
+			return (Prop.queueFlags & QueueBit) == QueueBit;
+		});
+		if (PropIt == QueueFamilyProps.end())
+		{
+			return false;
+		}
+		FamilyIndex = static_cast<uint32_t>(std::distance(QueueFamilyProps.begin(), PropIt));
+		return true;
+	}
+
+	// Transfer-only families usually map to the copy engines, which run alongside the compute units
+	bool findTransferOnlyQueueFamily(vk::PhysicalDevice PhysicalDevice, uint32_t& FamilyIndex)
+	{
+		const std::vector<vk::QueueFamilyProperties> QueueFamilyProps = PhysicalDevice.getQueueFamilyProperties();
+		auto PropIt = std::find_if(QueueFamilyProps.begin(), QueueFamilyProps.end(), [](const vk::QueueFamilyProperties& Prop)
+		{
+			return (Prop.queueFlags & vk::QueueFlagBits::eTransfer) &&
+				!(Prop.queueFlags & (vk::QueueFlagBits::eCompute | vk::QueueFlagBits::eGraphics));
+		});
+		if (PropIt == QueueFamilyProps.end())
+		{
+			return false;
+		}
+		FamilyIndex = static_cast<uint32_t>(std::distance(QueueFamilyProps.begin(), PropIt));
+		return true;
+	}
+
+	bool supportsHostQueryReset(vk::PhysicalDevice PhysicalDevice)
+	{
+		const auto Features = PhysicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceHostQueryResetFeatures>();
+		return Features.get<vk::PhysicalDeviceHostQueryResetFeatures>().hostQueryReset == VK_TRUE;
+	}
+
+	bool supportsTimelineSemaphores(vk::PhysicalDevice PhysicalDevice)
+	{
+		if (PhysicalDevice.getProperties().apiVersion < VK_API_VERSION_1_2)
+		{
+			return false;
+		}
+		const auto Features = PhysicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceTimelineSemaphoreFeatures>();
+		return Features.get<vk::PhysicalDeviceTimelineSemaphoreFeatures>().timelineSemaphore == VK_TRUE;
+	}
+
+	// Destroys the query pool of timeJob on every way out of it
+	struct ScopedQueryPool
+	{
+		vk::Device Device;
+		vk::QueryPool Pool;
+
+		~ScopedQueryPool()
+		{
+			if (Pool)
+			{
+				Device.destroyQueryPool(Pool);
+			}
+		}
+	};
+}
+
+bool JobTicket::isReady() const
+{
+	return wait(0);
+}
+
+bool JobTicket::wait(uint64_t TimeoutNs) const
+{
+	if (!Context)
+	{
+		throw std::logic_error("waiting on an empty job ticket");
+	}
+	return Context->waitForJob(ComputeValue, TransferValue, TimeoutNs);
+}
+
+std::vector<uint32_t> readSpirvFile(const std::string& FileName)
+{
+	std::ifstream ShaderFile{ FileName, std::ios::binary | std::ios::ate };
+	if (!ShaderFile)
+	{
+		throw std::runtime_error("failed to open shader file " + FileName);
+	}
+
+	const size_t FileSize = ShaderFile.tellg();
+	if (FileSize == 0 || FileSize % sizeof(uint32_t) != 0)
+	{
+		throw std::runtime_error("invalid SPIR-V file " + FileName);
+	}
+	std::vector<uint32_t> ShaderContents(FileSize / sizeof(uint32_t));
+	ShaderFile.seekg(0);
+	ShaderFile.read(reinterpret_cast<char*>(ShaderContents.data()), FileSize);
+	return ShaderContents;
+}
+
+ComputeContext::ComputeContext(const ContextOptions& Options)
+	: MaxJobsInFlight(std::max(Options.MaxJobsInFlight, 1u))
+	, GroupSizeCache(Options.GroupSizeCachePath)
+{
+	vk::ApplicationInfo AppInfo{
+		Options.AppName.c_str(),	// Application Name
+		1,							// Application Version
+		nullptr,					// Engine Name or nullptr
+		0,							// Engine Version
+		ApiVersion					// Vulkan API version
+	};
+
+	std::vector<const char*> Layers;
+	if (Options.EnableValidation && hasInstanceLayer(ValidationLayerName))
+	{
+		Layers.push_back(ValidationLayerName);
+	}
+	vk::InstanceCreateInfo InstanceCreateInfo(vk::InstanceCreateFlags(),			// Flags
+											  &AppInfo,								// Application Info
+											  static_cast<uint32_t>(Layers.size()),	// Layers count
+											  Layers.data());						// Layers
+	Instance = vk::createInstance(InstanceCreateInfo);
+
+	const std::vector<vk::PhysicalDevice> PhysicalDevices = Instance.enumeratePhysicalDevices();
+	bool bFoundDevice = false;
+	for (size_t Index = 0; Index < PhysicalDevices.size() && !bFoundDevice; ++Index)
+	{
+		if (Options.DeviceIndex >= 0 && static_cast<size_t>(Options.DeviceIndex) != Index)
+		{
+			continue;
+		}
+		if (findQueueFamily(PhysicalDevices[Index], vk::QueueFlagBits::eCompute, Compute.FamilyIndex) &&
+			supportsTimelineSemaphores(PhysicalDevices[Index]))
+		{
+			PhysicalDevice = PhysicalDevices[Index];
+			bFoundDevice = true;
+		}
+	}
+	if (!bFoundDevice)
+	{
+		Instance.destroy();
+		throw std::runtime_error("no Vulkan 1.2 device with a compute queue and timeline semaphores found");
+	}
+	DeviceProps = PhysicalDevice.getProperties();
+	SubgroupProps = PhysicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceSubgroupProperties>()
+						.get<vk::PhysicalDeviceSubgroupProperties>();
+	TimestampValidBits = PhysicalDevice.getQueueFamilyProperties()[Compute.FamilyIndex].timestampValidBits;
+	GroupSizeCache.setDevice(DeviceProps);
+	const bool bTransferQueue = Options.UseTransferQueue && findTransferOnlyQueueFamily(PhysicalDevice, Transfer.FamilyIndex);
+
+	// Just to avoid a warning from the Vulkan Validation Layer
+	const float QueuePriority = 1.0f;
+	std::vector<vk::DeviceQueueCreateInfo> DeviceQueueCreateInfos;
+	DeviceQueueCreateInfos.emplace_back(vk::DeviceQueueCreateFlags(),	// Flags
+										Compute.FamilyIndex,			// Queue Family Index
+										1,								// Number of Queues
+										&QueuePriority);
+	if (bTransferQueue)
+	{
+		DeviceQueueCreateInfos.emplace_back(vk::DeviceQueueCreateFlags(), Transfer.FamilyIndex, 1, &QueuePriority);
+	}
+	// Profiling resets queries from the host, which also works on transfer-only queues
+	const bool bHostQueryReset = Options.EnableProfiling && supportsHostQueryReset(PhysicalDevice);
+	const bool bCalibratedTimestamps = Options.EnableProfiling && GpuProfiler::supportsCalibratedTimestamps(Instance, PhysicalDevice);
+	std::vector<const char*> DeviceExtensions;
+	if (bCalibratedTimestamps)
+	{
+		DeviceExtensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+	}
+	vk::DeviceCreateInfo DeviceCreateInfo(vk::DeviceCreateFlags(),	// Flags
+										  DeviceQueueCreateInfos,	// Device Queue Create Info structs
+										  {},						// Layers
+										  DeviceExtensions);		// Extensions
+	// Optional features some kernels need, enabled whenever the device has them
+	const vk::PhysicalDeviceFeatures SupportedFeatures = PhysicalDevice.getFeatures();
+	DeviceFeatures.shaderFloat64 = SupportedFeatures.shaderFloat64;
+	DeviceFeatures.shaderInt64 = SupportedFeatures.shaderInt64;
+	bBufferInt64Atomics = SupportedFeatures.shaderInt64 &&
+		PhysicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceShaderAtomicInt64Features>()
+			.get<vk::PhysicalDeviceShaderAtomicInt64Features>().shaderBufferInt64Atomics;
+	vk::PhysicalDeviceShaderAtomicInt64Features AtomicInt64Features(bBufferInt64Atomics ? VK_TRUE : VK_FALSE, VK_FALSE);
+	vk::PhysicalDeviceHostQueryResetFeatures HostQueryResetFeatures(bHostQueryReset ? VK_TRUE : VK_FALSE);
+	HostQueryResetFeatures.pNext = &AtomicInt64Features;
+	vk::PhysicalDeviceTimelineSemaphoreFeatures TimelineFeatures(VK_TRUE);
+	TimelineFeatures.pNext = &HostQueryResetFeatures;
+	DeviceCreateInfo.pNext = &TimelineFeatures;
+	DeviceCreateInfo.pEnabledFeatures = &DeviceFeatures;
+	Device = PhysicalDevice.createDevice(DeviceCreateInfo);
+	if (Options.EnableProfiling)
+	{
+		Profiler = std::make_unique<GpuProfiler>(PhysicalDevice, Device, bHostQueryReset, bCalibratedTimestamps);
+	}
+
+	VmaAllocatorCreateInfo AllocatorInfo = {};
+	AllocatorInfo.vulkanApiVersion = ApiVersion;
+	AllocatorInfo.physicalDevice = PhysicalDevice;
+	AllocatorInfo.device = Device;
+	AllocatorInfo.instance = Instance;
+	if (vmaCreateAllocator(&AllocatorInfo, &Allocator) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create VMA allocator!");
+	}
+
+	std::vector<uint8_t> PipelineCacheData;
+	if (!Options.PipelineCacheDirectory.empty())
+	{
+		PipelineCacheStore = std::make_unique<PipelineCacheFile>(Options.PipelineCacheDirectory, DeviceProps);
+		PipelineCacheData = PipelineCacheStore->load();
+	}
+	vk::PipelineCacheCreateInfo PipelineCacheCreateInfo(vk::PipelineCacheCreateFlags(),	// Flags
+														PipelineCacheData.size(),		// Initial data size
+														PipelineCacheData.data());		// Initial data
+	PipelineCache = Device.createPipelineCache(PipelineCacheCreateInfo);
+
+	const std::array<vk::DescriptorPoolSize, 2> DescriptorPoolSizes = {
+		vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, Options.MaxDescriptorSets * 8),
+		vk::DescriptorPoolSize(vk::DescriptorType::eUniformBuffer, Options.MaxDescriptorSets)
+	};
+	vk::DescriptorPoolCreateInfo DescriptorPoolCreateInfo(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+														  Options.MaxDescriptorSets,
+														  DescriptorPoolSizes);
+	DescriptorPool = Device.createDescriptorPool(DescriptorPoolCreateInfo);
+
+	for (QueueState* Queue : { &Compute, &Transfer })
+	{
+		if (Queue == &Transfer && !bTransferQueue)
+		{
+			continue;
+		}
+		Queue->Queue = Device.getQueue(Queue->FamilyIndex, 0);
+		if (Profiler)
+		{
+			const vk::QueueFlags QueueFlags = PhysicalDevice.getQueueFamilyProperties()[Queue->FamilyIndex].queueFlags;
+			Queue->ProfileSlot = Profiler->addQueue(Queue->FamilyIndex, QueueFlags);
+		}
+
+		vk::CommandPoolCreateInfo CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, Queue->FamilyIndex);
+		Queue->CommandPool = Device.createCommandPool(CommandPoolCreateInfo);
+
+		vk::SemaphoreTypeCreateInfo SemaphoreTypeCreateInfo(vk::SemaphoreType::eTimeline, 0);
+		vk::SemaphoreCreateInfo SemaphoreCreateInfo;
+		SemaphoreCreateInfo.pNext = &SemaphoreTypeCreateInfo;
+		Queue->Timeline = Device.createSemaphore(SemaphoreCreateInfo);
+	}
+
+	// The staging rings are only ever touched by the queue that runs the copies
+	const uint32_t CopyQueueFamilyIndex = bTransferQueue ? Transfer.FamilyIndex : Compute.FamilyIndex;
+	UploadRing = std::make_unique<StagingRing>(Allocator, Options.StagingRingSize, VMA_MEMORY_USAGE_CPU_ONLY, CopyQueueFamilyIndex);
+	ReadbackRing = std::make_unique<StagingRing>(Allocator, Options.StagingRingSize, VMA_MEMORY_USAGE_GPU_TO_CPU, CopyQueueFamilyIndex);
+}
+
+ComputeContext::~ComputeContext()
+{
+	Device.waitIdle();
+	// Nobody waits for these anymore, drop them without copying downloads out
+	for (InFlightJob& InFlight : InFlightJobs)
+	{
+		releaseJob(InFlight.Prepared);
+	}
+	InFlightJobs.clear();
+
+	for (auto& KernelIt : Kernels)
+	{
+		destroyKernel(*KernelIt.second);
+	}
+	Kernels.clear();
+
+	try
+	{
+		savePipelineCache();
+	}
+	catch (const std::exception&)
+	{
+		// Losing the cache only costs compile time on the next run
+	}
+
+	for (QueueState* Queue : { &Compute, &Transfer })
+	{
+		Device.destroySemaphore(Queue->Timeline);
+		// Frees every command buffer allocated from it
+		Device.destroyCommandPool(Queue->CommandPool);
+	}
+	Device.destroyDescriptorPool(DescriptorPool);
+	Device.destroyPipelineCache(PipelineCache);
+	Profiler.reset();
+	UploadRing.reset();
+	ReadbackRing.reset();
+	// All buffers created through the context must have been destroyed by now
+	vmaDestroyAllocator(Allocator);
+	Device.destroy();
+	Instance.destroy();
+}
+
+ComputeBuffer ComputeContext::createBuffer(vk::DeviceSize Size, VmaMemoryUsage Usage, VmaAllocationCreateFlags Flags)
+{
+	vk::BufferCreateInfo BufferCreateInfo{
+		vk::BufferCreateFlags(),					// Flags
+		Size,										// Size
+		vk::BufferUsageFlagBits::eStorageBuffer |
+		vk::BufferUsageFlagBits::eTransferSrc |
+		vk::BufferUsageFlagBits::eTransferDst,		// Usage
+		vk::SharingMode::eExclusive,				// Sharing mode
+		1,											// Number of queue family indices
+		&Compute.FamilyIndex						// List of queue family indices
+	};
+	auto vkBufferCreateInfo = static_cast<VkBufferCreateInfo>(BufferCreateInfo);
+
+	VmaAllocationCreateInfo AllocationCreateInfo = {};
+	AllocationCreateInfo.usage = Usage;
+	AllocationCreateInfo.flags = Flags;
+
+	ComputeBuffer Result;
+	VkBuffer BufferRaw = VK_NULL_HANDLE;
+	VmaAllocationInfo AllocationInfo;
+	if (vmaCreateBuffer(Allocator, &vkBufferCreateInfo, &AllocationCreateInfo, &BufferRaw, &Result.Allocation, &AllocationInfo) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create buffer!");
+	}
+	Result.Buffer = BufferRaw;
+	Result.Size = Size;
+	Result.Mapped = static_cast<uint8_t*>(AllocationInfo.pMappedData);
+	return Result;
+}
+
+void ComputeContext::destroyBuffer(ComputeBuffer& Buffer)
+{
+	PendingAcquires.erase(std::remove_if(PendingAcquires.begin(), PendingAcquires.end(), [&Buffer](const PendingAcquire& Pending)
+	{
+		return Pending.Barrier.buffer == Buffer.Buffer;
+	}), PendingAcquires.end());
+	if (Buffer.Allocation)
+	{
+		vmaDestroyBuffer(Allocator, Buffer.Buffer, Buffer.Allocation);
+	}
+	Buffer = ComputeBuffer();
+}
+
+bool ComputeContext::isHostVisible(const ComputeBuffer& Buffer) const
+{
+	VmaAllocationInfo AllocationInfo;
+	vmaGetAllocationInfo(Allocator, Buffer.Allocation, &AllocationInfo);
+	VkMemoryPropertyFlags MemoryFlags = 0;
+	vmaGetMemoryTypeProperties(Allocator, AllocationInfo.memoryType, &MemoryFlags);
+	return (MemoryFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+}
+
+void ComputeContext::writeBuffer(const ComputeBuffer& Buffer, const void* Data, vk::DeviceSize Size, vk::DeviceSize Offset)
+{
+	if (!isHostVisible(Buffer))
+	{
+		ComputeJob Job;
+		Job.Uploads.push_back({ &Buffer, Data, Size, Offset });
+		submit(Job);
+		return;
+	}
+
+	if (Buffer.Mapped)
+	{
+		std::memcpy(Buffer.Mapped + Offset, Data, Size);
+		vmaFlushAllocation(Allocator, Buffer.Allocation, Offset, Size);
+		return;
+	}
+
+	uint8_t* Mapped = nullptr;
+	if (vmaMapMemory(Allocator, Buffer.Allocation, reinterpret_cast<void**>(&Mapped)) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to map buffer memory!");
+	}
+	std::memcpy(Mapped + Offset, Data, Size);
+	vmaFlushAllocation(Allocator, Buffer.Allocation, Offset, Size);
+	vmaUnmapMemory(Allocator, Buffer.Allocation);
+}
+
+void ComputeContext::readBuffer(const ComputeBuffer& Buffer, void* Data, vk::DeviceSize Size, vk::DeviceSize Offset)
+{
+	if (!isHostVisible(Buffer))
+	{
+		ComputeJob Job;
+		Job.Downloads.push_back({ &Buffer, Data, Size, Offset });
+		submit(Job);
+		return;
+	}
+
+	if (Buffer.Mapped)
+	{
+		vmaInvalidateAllocation(Allocator, Buffer.Allocation, Offset, Size);
+		std::memcpy(Data, Buffer.Mapped + Offset, Size);
+		return;
+	}
+
+	uint8_t* Mapped = nullptr;
+	if (vmaMapMemory(Allocator, Buffer.Allocation, reinterpret_cast<void**>(&Mapped)) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to map buffer memory!");
+	}
+	vmaInvalidateAllocation(Allocator, Buffer.Allocation, Offset, Size);
+	std::memcpy(Data, Mapped + Offset, Size);
+	vmaUnmapMemory(Allocator, Buffer.Allocation);
+}
+
+const ComputeKernel& ComputeContext::createKernel(const KernelDesc& Desc)
+{
+	if (const ComputeKernel* Existing = findKernel(Desc.Name))
+	{
+		return *Existing;
+	}
+
+	auto Kernel = std::make_unique<ComputeKernel>();
+	Kernel->Desc = Desc;
+	for (const vk::DescriptorSetLayoutBinding& Binding : Desc.Bindings)
+	{
+		Kernel->NumDescriptors += Binding.descriptorCount;
+	}
+
+	const std::vector<uint32_t> ShaderContents = readSpirvFile(Desc.SpirvPath);
+	vk::ShaderModuleCreateInfo ShaderModuleCreateInfo(vk::ShaderModuleCreateFlags(),						// Flags
+													  ShaderContents.size() * sizeof(uint32_t),			// Code size
+													  ShaderContents.data());							// Code
+	Kernel->ShaderModule = Device.createShaderModule(ShaderModuleCreateInfo);
+
+	vk::DescriptorSetLayoutCreateInfo DescriptorSetLayoutCreateInfo(vk::DescriptorSetLayoutCreateFlags(), Desc.Bindings);
+	Kernel->DescriptorSetLayout = Device.createDescriptorSetLayout(DescriptorSetLayoutCreateInfo);
+
+	const vk::PushConstantRange PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, Desc.PushConstantSize);
+	vk::PipelineLayoutCreateInfo PipelineLayoutCreateInfo(vk::PipelineLayoutCreateFlags(),
+														  1, &Kernel->DescriptorSetLayout,
+														  Desc.PushConstantSize > 0 ? 1 : 0, &PushConstantRange);
+	Kernel->PipelineLayout = Device.createPipelineLayout(PipelineLayoutCreateInfo);
+
+	const ComputeKernel& Result = *Kernel;
+	Kernels.emplace(Desc.Name, std::move(Kernel));
+	// Create the default variant up front so the common case never compiles at dispatch time
+	getPipeline(Result, Desc.DefaultGroupSize);
+	return Result;
+}
+
+vk::Pipeline ComputeContext::getPipeline(const ComputeKernel& Kernel, uint32_t GroupSize)
+{
+	auto PipelineIt = Kernel.Pipelines.find(GroupSize);
+	if (PipelineIt != Kernel.Pipelines.end())
+	{
+		return PipelineIt->second;
+	}
+
+	std::vector<vk::SpecializationMapEntry> MapEntries;
+	std::vector<uint32_t> SpecData;
+	if (Kernel.isGroupSizeTunable())
+	{
+		MapEntries.emplace_back(0, 0, sizeof(uint32_t));
+		SpecData.push_back(GroupSize);
+	}
+	for (const auto& SpecConstant : Kernel.Desc.SpecConstants)
+	{
+		MapEntries.emplace_back(SpecConstant.first, static_cast<uint32_t>(SpecData.size() * sizeof(uint32_t)), sizeof(uint32_t));
+		SpecData.push_back(SpecConstant.second);
+	}
+	vk::SpecializationInfo SpecializationInfo(static_cast<uint32_t>(MapEntries.size()), MapEntries.data(),
+											  SpecData.size() * sizeof(uint32_t), SpecData.data());
+
+	vk::PipelineShaderStageCreateInfo PipelineShaderCreateInfo(vk::PipelineShaderStageCreateFlags(),	// Flags
+															   vk::ShaderStageFlagBits::eCompute,		// Stage
+															   Kernel.ShaderModule,						// Shader Module
+															   Kernel.Desc.EntryPoint.c_str(),			// Shader Entry Point
+															   MapEntries.empty() ? nullptr : &SpecializationInfo);
+	vk::ComputePipelineCreateInfo ComputePipelineCreateInfo(vk::PipelineCreateFlags(),	// Flags
+															PipelineShaderCreateInfo,	// Shader Create Info struct
+															Kernel.PipelineLayout);		// Pipeline Layout
+	vk::Pipeline Pipeline = Device.createComputePipeline(PipelineCache, ComputePipelineCreateInfo).value;
+	Kernel.Pipelines.emplace(GroupSize, Pipeline);
+	bPipelineCacheDirty = true;
+	return Pipeline;
+}
+
+bool ComputeContext::savePipelineCache()
+{
+	if (!PipelineCacheStore || !bPipelineCacheDirty)
+	{
+		return false;
+	}
+	const std::vector<uint8_t> Data = Device.getPipelineCacheData(PipelineCache);
+	bPipelineCacheDirty = !PipelineCacheStore->save(Data);
+	return !bPipelineCacheDirty;
+}
+
+uint32_t ComputeContext::resolveGroupSize(const ComputeJob& Job) const
+{
+	const ComputeKernel& Kernel = *Job.Kernel;
+	if (!Kernel.isGroupSizeTunable())
+	{
+		return 0;
+	}
+	if (Job.GroupSize != 0)
+	{
+		return Job.GroupSize;
+	}
+	const uint32_t TunedSize = Job.ElementCount != 0 ? GroupSizeCache.find(Kernel.Desc.Name, Job.ElementCount) : 0;
+	return TunedSize != 0 ? TunedSize : Kernel.Desc.DefaultGroupSize;
+}
+
+const ComputeKernel* ComputeContext::findKernel(const std::string& Name) const
+{
+	auto KernelIt = Kernels.find(Name);
+	return KernelIt != Kernels.end() ? KernelIt->second.get() : nullptr;
+}
+
+void ComputeContext::destroyKernel(ComputeKernel& Kernel)
+{
+	for (auto& PipelineIt : Kernel.Pipelines)
+	{
+		Device.destroyPipeline(PipelineIt.second);
+	}
+	Kernel.Pipelines.clear();
+	Device.destroyPipelineLayout(Kernel.PipelineLayout);
+	Device.destroyDescriptorSetLayout(Kernel.DescriptorSetLayout);
+	Device.destroyShaderModule(Kernel.ShaderModule);
+}
+
+vk::DescriptorSet ComputeContext::allocateDescriptorSet(const ComputeJob& Job, vk::DeviceSize WindowOffset, vk::DeviceSize WindowRange)
+{
+	const ComputeKernel& Kernel = *Job.Kernel;
+	const std::vector<const ComputeBuffer*>& Buffers = Job.Buffers;
+	if (Buffers.size() != Kernel.NumDescriptors)
+	{
+		throw std::invalid_argument("kernel " + Kernel.Desc.Name + " expects " + std::to_string(Kernel.NumDescriptors) + " buffers");
+	}
+	if (!Job.BufferRanges.empty() && (Job.BufferRanges.size() != Buffers.size() || WindowRange != 0))
+	{
+		throw std::invalid_argument("BufferRanges needs one range per buffer and cannot be combined with ElementSize");
+	}
+
+	vk::DescriptorSetAllocateInfo DescriptorSetAllocInfo(DescriptorPool, 1, &Kernel.DescriptorSetLayout);
+	vk::DescriptorSet DescriptorSet;
+	while (!DescriptorSet)
+	{
+		try
+		{
+			DescriptorSet = Device.allocateDescriptorSets(DescriptorSetAllocInfo).front();
+		}
+		catch (const vk::OutOfPoolMemoryError&)
+		{
+			// The pool is shared by all jobs in flight, the oldest one gives its sets back when it finishes
+			if (InFlightJobs.empty())
+			{
+				throw;
+			}
+			waitForOldestJob();
+		}
+	}
+
+	std::vector<vk::DescriptorBufferInfo> BufferInfos;
+	BufferInfos.reserve(Buffers.size());
+	for (size_t Index = 0; Index < Buffers.size(); ++Index)
+	{
+		const ComputeBuffer* Buffer = Buffers[Index];
+		if (!Job.BufferRanges.empty())
+		{
+			const vk::DeviceSize Offset = Job.BufferRanges[Index].first;
+			const vk::DeviceSize Size = Job.BufferRanges[Index].second;
+			if (Offset >= Buffer->Size || Size > Buffer->Size - Offset)
+			{
+				throw std::invalid_argument("buffer range of kernel " + Kernel.Desc.Name + " is out of bounds");
+			}
+			BufferInfos.emplace_back(Buffer->Buffer, Offset, Size != 0 ? Size : Buffer->Size - Offset);
+		}
+		else if (WindowRange == 0)
+		{
+			BufferInfos.emplace_back(Buffer->Buffer, 0, Buffer->Size);
+		}
+		else
+		{
+			BufferInfos.emplace_back(Buffer->Buffer, WindowOffset, std::min(WindowRange, Buffer->Size - WindowOffset));
+		}
+	}
+
+	std::vector<vk::WriteDescriptorSet> WriteDescriptorSets;
+	uint32_t FirstInfo = 0;
+	for (const vk::DescriptorSetLayoutBinding& Binding : Kernel.Desc.Bindings)
+	{
+		WriteDescriptorSets.emplace_back(DescriptorSet, Binding.binding, 0, Binding.descriptorCount,
+										 Binding.descriptorType, nullptr, &BufferInfos[FirstInfo]);
+		FirstInfo += Binding.descriptorCount;
+	}
+	Device.updateDescriptorSets(WriteDescriptorSets, {});
+	return DescriptorSet;
+}
+
+ComputeContext::PreparedJob ComputeContext::prepareJob(const ComputeJob& Job)
+{
+	if (!Job.Kernel && Job.Uploads.empty() && Job.Downloads.empty())
+	{
+		throw std::invalid_argument("compute job without a kernel or transfers");
+	}
+	if (!Job.Kernel && !Job.Fills.empty())
+	{
+		throw std::invalid_argument("buffer fills are recorded with the dispatch, the job needs a kernel");
+	}
+
+	PreparedJob Prepared;
+	try
+	{
+		// Regions become reusable once the job that follows this preparation has completed
+		const uint64_t RetireValue = JobSerial + 1;
+		for (const BufferUpload& Upload : Job.Uploads)
+		{
+			const StagingRegion Region = acquireStaging(*UploadRing, Upload.Size, VMA_MEMORY_USAGE_CPU_ONLY, RetireValue, Prepared);
+			std::memcpy(Region.Data, Upload.Data, Upload.Size);
+			vmaFlushAllocation(Allocator, Region.Allocation, Region.Offset, Region.Size);
+		}
+		for (const BufferDownload& Download : Job.Downloads)
+		{
+			acquireStaging(*ReadbackRing, Download.Size, VMA_MEMORY_USAGE_GPU_TO_CPU, RetireValue, Prepared);
+		}
+		if (!Job.Kernel)
+		{
+			return Prepared;
+		}
+
+		Prepared.GroupSize = resolveGroupSize(Job);
+		if (Prepared.GroupSize != 0 && Job.ElementCount != 0)
+		{
+			Prepared.Slices = planDispatch(Job.ElementCount, Prepared.GroupSize, Job.ElementSize, DeviceProps.limits);
+			Prepared.bWindowed = Job.ElementSize != 0;
+		}
+		// The indirect command replaces the grid of exactly one dispatch
+		if (Job.IndirectBuffer && (Job.ElementSize != 0 || Prepared.Slices.size() > 1))
+		{
+			throw std::invalid_argument("indirect jobs are one dispatch, without ElementSize and with at most 2^31 elements");
+		}
+
+		if (Prepared.bWindowed)
+		{
+			for (const DispatchSlice& Slice : Prepared.Slices)
+			{
+				Prepared.DescriptorSets.push_back(allocateDescriptorSet(Job, Slice.FirstElement * Job.ElementSize,
+																		vk::DeviceSize(Slice.ElementCount) * Job.ElementSize));
+			}
+		}
+		else
+		{
+			Prepared.DescriptorSets.push_back(allocateDescriptorSet(Job, 0, 0));
+		}
+	}
+	catch (...)
+	{
+		releaseJob(Prepared);
+		throw;
+	}
+	return Prepared;
+}
+
+void ComputeContext::releaseJob(PreparedJob& Prepared)
+{
+	if (!Prepared.DescriptorSets.empty())
+	{
+		Device.freeDescriptorSets(DescriptorPool, Prepared.DescriptorSets);
+	}
+	Prepared.DescriptorSets.clear();
+	for (ComputeBuffer& Staging : Prepared.DedicatedStaging)
+	{
+		destroyBuffer(Staging);
+	}
+	Prepared.DedicatedStaging.clear();
+	Prepared.Staging.clear();
+	UploadRing->retire(CompletedJobSerial);
+	ReadbackRing->retire(CompletedJobSerial);
+}
+
+StagingRegion ComputeContext::acquireStaging(StagingRing& Ring, vk::DeviceSize Size, VmaMemoryUsage Usage, uint64_t RetireValue, PreparedJob& Prepared)
+{
+	StagingRegion Region;
+	bool bReserved = Ring.reserve(Size, Region);
+	// Older jobs still hold the ring, wait for them before giving up on it
+	while (!bReserved && Size <= Ring.getCapacity() && !InFlightJobs.empty())
+	{
+		waitForOldestJob();
+		bReserved = Ring.reserve(Size, Region);
+	}
+	if (bReserved)
+	{
+		Ring.commit(Region, RetireValue);
+	}
+	else
+	{
+		// Larger than what the ring has free, fall back to a one-off staging buffer
+		Prepared.DedicatedStaging.push_back(createBuffer(Size, Usage, VMA_ALLOCATION_CREATE_MAPPED_BIT));
+		const ComputeBuffer& Dedicated = Prepared.DedicatedStaging.back();
+		Region.Buffer = Dedicated.Buffer;
+		Region.Allocation = Dedicated.Allocation;
+		Region.Offset = 0;
+		Region.Size = Size;
+		Region.Data = Dedicated.Mapped;
+	}
+	Prepared.Staging.push_back(Region);
+	return Region;
+}
+
+void ComputeContext::completeJob(const std::vector<BufferDownload>& Downloads, const PreparedJob& Prepared)
+{
+	const size_t FirstDownload = Prepared.Staging.size() - Downloads.size();
+	for (size_t Index = 0; Index < Downloads.size(); ++Index)
+	{
+		const BufferDownload& Download = Downloads[Index];
+		const StagingRegion& Region = Prepared.Staging[FirstDownload + Index];
+		vmaInvalidateAllocation(Allocator, Region.Allocation, Region.Offset, Region.Size);
+		std::memcpy(Download.Data, Region.Data, Download.Size);
+	}
+}
+
+void ComputeContext::recordJob(vk::CommandBuffer Cmd, const ComputeJob& Job, const PreparedJob& Prepared)
+{
+	recordUploads(Cmd, Job, Prepared);
+	if (!Job.Uploads.empty())
+	{
+		const vk::MemoryBarrier UploadBarrier(vk::AccessFlagBits::eTransferWrite,
+											  vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferRead);
+		Cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+							vk::DependencyFlags(), UploadBarrier, {}, {});
+	}
+
+	if (Job.Kernel)
+	{
+		recordDispatch(Cmd, Job, Prepared);
+	}
+
+	if (!Job.Downloads.empty())
+	{
+		const vk::MemoryBarrier ComputeBarrier(vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead);
+		Cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer,
+							vk::DependencyFlags(), ComputeBarrier, {}, {});
+		recordDownloads(Cmd, Job, Prepared);
+	}
+}
+
+void ComputeContext::recordUploads(vk::CommandBuffer Cmd, const ComputeJob& Job, const PreparedJob& Prepared)
+{
+	if (Job.Uploads.empty())
+	{
+		return;
+	}
+	const uint32_t Scope = Profiler ? Profiler->beginScope(Cmd, ProfileCategory::Upload, "upload") : GpuProfiler::NoScope;
+	for (size_t Index = 0; Index < Job.Uploads.size(); ++Index)
+	{
+		const BufferUpload& Upload = Job.Uploads[Index];
+		const StagingRegion& Region = Prepared.Staging[Index];
+		Cmd.copyBuffer(Region.Buffer, Upload.Buffer->Buffer, vk::BufferCopy(Region.Offset, Upload.Offset, Upload.Size));
+	}
+	if (Profiler)
+	{
+		Profiler->endScope(Cmd, Scope);
+	}
+}
+
+void ComputeContext::recordDownloads(vk::CommandBuffer Cmd, const ComputeJob& Job, const PreparedJob& Prepared)
+{
+	const uint32_t Scope = Profiler ? Profiler->beginScope(Cmd, ProfileCategory::Download, "download") : GpuProfiler::NoScope;
+	for (size_t Index = 0; Index < Job.Downloads.size(); ++Index)
+	{
+		const BufferDownload& Download = Job.Downloads[Index];
+		const StagingRegion& Region = Prepared.Staging[Job.Uploads.size() + Index];
+		Cmd.copyBuffer(Download.Buffer->Buffer, Region.Buffer, vk::BufferCopy(Download.Offset, Region.Offset, Download.Size));
+	}
+	if (Profiler)
+	{
+		Profiler->endScope(Cmd, Scope);
+	}
+	const vk::MemoryBarrier HostBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead);
+	Cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost,
+						vk::DependencyFlags(), HostBarrier, {}, {});
+}
+
+void ComputeContext::recordDispatch(vk::CommandBuffer Cmd, const ComputeJob& Job, const PreparedJob& Prepared)
+{
+	const ComputeKernel& Kernel = *Job.Kernel;
+	if (!Job.Fills.empty())
+	{
+		// Earlier dispatches in the same command buffer (timeJob) may still use the filled ranges
+		const vk::MemoryBarrier BeforeFill(vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferWrite);
+		Cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer,
+							vk::DependencyFlags(), BeforeFill, {}, {});
+		for (const BufferFill& Fill : Job.Fills)
+		{
+			Cmd.fillBuffer(Fill.Buffer->Buffer, Fill.Offset, Fill.Size, Fill.Value);
+		}
+		const vk::MemoryBarrier AfterFill(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+		Cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader,
+							vk::DependencyFlags(), AfterFill, {}, {});
+	}
+	if (Job.IndirectBuffer)
+	{
+		// The command may come from a shader or a copy earlier in this command buffer
+		const vk::MemoryBarrier IndirectBarrier(vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite,
+												vk::AccessFlagBits::eIndirectCommandRead);
+		Cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+							vk::PipelineStageFlagBits::eDrawIndirect, vk::DependencyFlags(), IndirectBarrier, {}, {});
+	}
+	Cmd.bindPipeline(vk::PipelineBindPoint::eCompute, getPipeline(Kernel, Prepared.GroupSize));
+	if (Prepared.Slices.empty())
+	{
+		const uint32_t Scope = Profiler ? Profiler->beginScope(Cmd, ProfileCategory::Kernel, Kernel.Desc.Name) : GpuProfiler::NoScope;
+		Cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute,	// Bind point
+							   Kernel.PipelineLayout,				// Pipeline Layout
+							   0,									// First descriptor set
+							   { Prepared.DescriptorSets.front() },	// List of descriptor sets
+							   {});									// Dynamic offsets
+		if (!Job.PushConstants.empty())
+		{
+			Cmd.pushConstants(Kernel.PipelineLayout, vk::ShaderStageFlagBits::eCompute, 0,
+							  static_cast<uint32_t>(Job.PushConstants.size()), Job.PushConstants.data());
+		}
+		if (Job.IndirectBuffer)
+		{
+			Cmd.dispatchIndirect(Job.IndirectBuffer->Buffer, Job.IndirectOffset);
+		}
+		else
+		{
+			Cmd.dispatch(Job.GroupCount[0], Job.GroupCount[1], Job.GroupCount[2]);
+		}
+		if (Profiler)
+		{
+			Profiler->endScope(Cmd, Scope);
+		}
+		return;
+	}
+
+	// Elementwise kernels: DispatchParams first, then the job's own push constants
+	std::vector<uint8_t> PushConstants(sizeof(DispatchParams) + Job.PushConstants.size());
+	std::copy(Job.PushConstants.begin(), Job.PushConstants.end(), PushConstants.begin() + sizeof(DispatchParams));
+	// One scope for all slices, a windowed job is still one kernel launch to the caller
+	const uint32_t Scope = Profiler ? Profiler->beginScope(Cmd, ProfileCategory::Kernel, Kernel.Desc.Name) : GpuProfiler::NoScope;
+	for (size_t SliceIndex = 0; SliceIndex < Prepared.Slices.size(); ++SliceIndex)
+	{
+		const DispatchSlice& Slice = Prepared.Slices[SliceIndex];
+		if (SliceIndex == 0 || Prepared.bWindowed)
+		{
+			Cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, Kernel.PipelineLayout, 0,
+								   { Prepared.DescriptorSets[Prepared.bWindowed ? SliceIndex : 0] }, {});
+		}
+
+		DispatchParams Params;
+		Params.IndexOffset = Prepared.bWindowed ? 0 : static_cast<uint32_t>(Slice.FirstElement);
+		Params.ElementCount = Slice.ElementCount;
+		Params.GroupCountX = Slice.GroupCount[0];
+		Params.GroupCountY = Slice.GroupCount[1];
+		std::memcpy(PushConstants.data(), &Params, sizeof(Params));
+		Cmd.pushConstants(Kernel.PipelineLayout, vk::ShaderStageFlagBits::eCompute, 0,
+						  static_cast<uint32_t>(PushConstants.size()), PushConstants.data());
+		if (Job.IndirectBuffer)
+		{
+			Cmd.dispatchIndirect(Job.IndirectBuffer->Buffer, Job.IndirectOffset);
+		}
+		else
+		{
+			Cmd.dispatch(Slice.GroupCount[0], Slice.GroupCount[1], Slice.GroupCount[2]);
+		}
+	}
+	if (Profiler)
+	{
+		Profiler->endScope(Cmd, Scope);
+	}
+}
+
+void ComputeContext::submitSplitJob(const ComputeJob& Job, InFlightJob& InFlight, const std::vector<TimelineWait>& Waits)
+{
+	// Ownership transfer barriers come in pairs, the release on the queue giving a buffer range up
+	// and the matching acquire on the queue taking it over after a timeline wait
+	auto makeHandoff = [](const ComputeBuffer* Buffer, vk::DeviceSize Offset, vk::DeviceSize Size,
+						  uint32_t SrcFamily, uint32_t DstFamily, vk::AccessFlags SrcAccess, vk::AccessFlags DstAccess)
+	{
+		return vk::BufferMemoryBarrier(SrcAccess, DstAccess, SrcFamily, DstFamily, Buffer->Buffer, Offset, Size);
+	};
+	const vk::AccessFlags ComputeAccess = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite |
+										  vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite;
+	const vk::PipelineStageFlags ComputeStages = vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer;
+
+	std::vector<TimelineWait> ComputeWaits = Waits;
+	if (!Job.Uploads.empty())
+	{
+		InFlight.TransferValue = submitCommands(Transfer, Job, [&](vk::CommandBuffer Cmd)
+		{
+			recordUploads(Cmd, Job, InFlight.Prepared);
+			std::vector<vk::BufferMemoryBarrier> Releases;
+			for (const BufferUpload& Upload : Job.Uploads)
+			{
+				Releases.push_back(makeHandoff(Upload.Buffer, Upload.Offset, Upload.Size, Transfer.FamilyIndex, Compute.FamilyIndex,
+											   vk::AccessFlagBits::eTransferWrite, vk::AccessFlags()));
+			}
+			Cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe,
+								vk::DependencyFlags(), {}, Releases, {});
+		}, Waits, InFlight);
+		// The upload already waited for the dependencies
+		ComputeWaits = { { &Transfer, InFlight.TransferValue } };
+	}
+
+	InFlight.ComputeValue = submitCommands(Compute, Job, [&](vk::CommandBuffer Cmd)
+	{
+		if (!Job.Uploads.empty())
+		{
+			std::vector<vk::BufferMemoryBarrier> Acquires;
+			for (const BufferUpload& Upload : Job.Uploads)
+			{
+				Acquires.push_back(makeHandoff(Upload.Buffer, Upload.Offset, Upload.Size, Transfer.FamilyIndex, Compute.FamilyIndex,
+											   vk::AccessFlags(), ComputeAccess));
+			}
+			Cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, ComputeStages, vk::DependencyFlags(), {}, Acquires, {});
+		}
+		if (Job.Kernel)
+		{
+			recordDispatch(Cmd, Job, InFlight.Prepared);
+		}
+		if (!Job.Downloads.empty())
+		{
+			std::vector<vk::BufferMemoryBarrier> Releases;
+			for (const BufferDownload& Download : Job.Downloads)
+			{
+				Releases.push_back(makeHandoff(Download.Buffer, Download.Offset, Download.Size, Compute.FamilyIndex, Transfer.FamilyIndex,
+											   vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite, vk::AccessFlags()));
+			}
+			Cmd.pipelineBarrier(ComputeStages, vk::PipelineStageFlagBits::eBottomOfPipe, vk::DependencyFlags(), {}, Releases, {});
+		}
+	}, ComputeWaits, InFlight);
+
+	if (Job.Downloads.empty())
+	{
+		return;
+	}
+	std::vector<vk::BufferMemoryBarrier> ReturnAcquires;
+	InFlight.TransferValue = submitCommands(Transfer, Job, [&](vk::CommandBuffer Cmd)
+	{
+		std::vector<vk::BufferMemoryBarrier> Acquires;
+		std::vector<vk::BufferMemoryBarrier> Returns;
+		for (const BufferDownload& Download : Job.Downloads)
+		{
+			Acquires.push_back(makeHandoff(Download.Buffer, Download.Offset, Download.Size, Compute.FamilyIndex, Transfer.FamilyIndex,
+										   vk::AccessFlags(), vk::AccessFlagBits::eTransferRead));
+			Returns.push_back(makeHandoff(Download.Buffer, Download.Offset, Download.Size, Transfer.FamilyIndex, Compute.FamilyIndex,
+										  vk::AccessFlags(), vk::AccessFlags()));
+			ReturnAcquires.push_back(makeHandoff(Download.Buffer, Download.Offset, Download.Size, Transfer.FamilyIndex, Compute.FamilyIndex,
+												 vk::AccessFlags(), ComputeAccess));
+		}
+		Cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), {}, Acquires, {});
+		recordDownloads(Cmd, Job, InFlight.Prepared);
+		// Give the buffers back so that later compute work sees their contents
+		Cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, vk::DependencyFlags(), {}, Returns, {});
+	}, { { &Compute, InFlight.ComputeValue } }, InFlight);
+	for (const vk::BufferMemoryBarrier& Acquire : ReturnAcquires)
+	{
+		PendingAcquires.push_back({ Acquire, InFlight.TransferValue });
+	}
+}
+
+uint64_t ComputeContext::submitCommands(QueueState& Queue, const ComputeJob& Job, const std::function<void(vk::CommandBuffer)>& Record,
+										std::vector<TimelineWait> Waits, InFlightJob& InFlight)
+{
+	if (Queue.FreeCommandBuffers.empty())
+	{
+		vk::CommandBufferAllocateInfo CommandBufferAllocInfo(Queue.CommandPool,					// Command Pool
+															 vk::CommandBufferLevel::ePrimary,	// Level
+															 1);								// Num Command Buffers
+		Queue.FreeCommandBuffers.push_back(Device.allocateCommandBuffers(CommandBufferAllocInfo).front());
+	}
+	// Only taken out of the free list once submitted, begin() resets it if recording fails
+	vk::CommandBuffer Cmd = Queue.FreeCommandBuffers.back();
+
+	std::vector<vk::BufferMemoryBarrier> Acquires;
+	if (&Queue == &Compute)
+	{
+		takePendingAcquires(Job, Acquires, Waits);
+	}
+	std::vector<vk::Semaphore> WaitSemaphores;
+	std::vector<uint64_t> WaitValues;
+	for (const TimelineWait& Wait : Waits)
+	{
+		if (Wait.Value > Wait.Queue->CompletedValue)
+		{
+			WaitSemaphores.push_back(Wait.Queue->Timeline);
+			WaitValues.push_back(Wait.Value);
+		}
+	}
+	const std::vector<vk::PipelineStageFlags> WaitStages(WaitSemaphores.size(), vk::PipelineStageFlagBits::eAllCommands);
+
+	uint32_t ProfileSlab = GpuProfiler::NoSlab;
+	try
+	{
+		Cmd.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+		if (Profiler)
+		{
+			ProfileSlab = Profiler->beginCommands(Queue.ProfileSlot, Cmd);
+		}
+		if (!Acquires.empty())
+		{
+			Cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe,
+								vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eDrawIndirect,
+								vk::DependencyFlags(), {}, Acquires, {});
+		}
+		Record(Cmd);
+		Cmd.end();
+	}
+	catch (...)
+	{
+		if (Profiler)
+		{
+			Profiler->discard(ProfileSlab);
+		}
+		throw;
+	}
+	if (Profiler)
+	{
+		Profiler->endCommands();
+	}
+
+	const uint64_t SignalValue = Queue.TimelineValue + 1;
+	vk::TimelineSemaphoreSubmitInfo TimelineSubmitInfo(static_cast<uint32_t>(WaitValues.size()), WaitValues.data(),	// Wait values
+													   1, &SignalValue);												// Signal values
+	vk::SubmitInfo SubmitInfo(static_cast<uint32_t>(WaitSemaphores.size()),	// Num Wait Semaphores
+							  WaitSemaphores.data(),							// Wait Semaphores
+							  WaitStages.data(),								// Pipeline Stage Flags
+							  1,												// Num Command Buffers
+							  &Cmd,												// List of command buffers
+							  1,												// Num Signal Semaphores
+							  &Queue.Timeline);									// Signal Semaphores
+	SubmitInfo.pNext = &TimelineSubmitInfo;
+	try
+	{
+		if (Profiler)
+		{
+			Profiler->markSubmitted(ProfileSlab);
+		}
+		Queue.Queue.submit({ SubmitInfo }, nullptr);
+	}
+	catch (...)
+	{
+		if (Profiler)
+		{
+			Profiler->discard(ProfileSlab);
+		}
+		throw;
+	}
+
+	Queue.FreeCommandBuffers.pop_back();
+	Queue.TimelineValue = SignalValue;
+	InFlight.Cmds.push_back({ &Queue, Cmd, ProfileSlab });
+	return SignalValue;
+}
+
+void ComputeContext::takePendingAcquires(const ComputeJob& Job, std::vector<vk::BufferMemoryBarrier>& Acquires, std::vector<TimelineWait>& Waits)
+{
+	auto isUsedByJob = [&Job](vk::Buffer Buffer)
+	{
+		return std::any_of(Job.Buffers.begin(), Job.Buffers.end(), [Buffer](const ComputeBuffer* Used) { return Used->Buffer == Buffer; }) ||
+			(Job.IndirectBuffer && Job.IndirectBuffer->Buffer == Buffer) ||
+			std::any_of(Job.Uploads.begin(), Job.Uploads.end(), [Buffer](const BufferUpload& Upload) { return Upload.Buffer->Buffer == Buffer; }) ||
+			std::any_of(Job.Fills.begin(), Job.Fills.end(), [Buffer](const BufferFill& Fill) { return Fill.Buffer->Buffer == Buffer; }) ||
+			std::any_of(Job.Downloads.begin(), Job.Downloads.end(), [Buffer](const BufferDownload& Download) { return Download.Buffer->Buffer == Buffer; });
+	};
+	// Buffers the job does not touch stay with the transfer queue, so unrelated jobs do not wait for each other's downloads
+	auto PendingIt = std::partition(PendingAcquires.begin(), PendingAcquires.end(), [&isUsedByJob](const PendingAcquire& Pending)
+	{
+		return !isUsedByJob(Pending.Barrier.buffer);
+	});
+	for (auto TakenIt = PendingIt; TakenIt != PendingAcquires.end(); ++TakenIt)
+	{
+		Acquires.push_back(TakenIt->Barrier);
+		Waits.push_back({ &Transfer, TakenIt->TransferValue });
+	}
+	PendingAcquires.erase(PendingIt, PendingAcquires.end());
+}
+
+JobTicket ComputeContext::trackJob(InFlightJob&& InFlight)
+{
+	JobSerial = InFlight.Serial;
+	const JobTicket Ticket(this, InFlight.ComputeValue, InFlight.TransferValue);
+	InFlightJobs.push_back(std::move(InFlight));
+	return Ticket;
+}
+
+void ComputeContext::abandonJob(InFlightJob& InFlight)
+{
+	if (!InFlight.Cmds.empty())
+	{
+		// Part of the job is queued already, let it drain before recycling what it uses
+		Device.waitIdle();
+		updateCompletedValues();
+	}
+	recycleJob(InFlight);
+}
+
+void ComputeContext::recycleJob(InFlightJob& InFlight)
+{
+	for (const SubmittedCommands& Submitted : InFlight.Cmds)
+	{
+		if (Profiler)
+		{
+			// Every submitted command buffer of the job has completed by now
+			Profiler->resolve(Submitted.ProfileSlab);
+		}
+		Submitted.Queue->FreeCommandBuffers.push_back(Submitted.Cmd);
+	}
+	InFlight.Cmds.clear();
+	releaseJob(InFlight.Prepared);
+}
+
+bool ComputeContext::waitForJob(uint64_t ComputeValue, uint64_t TransferValue, uint64_t TimeoutNs)
+{
+	if (ComputeValue > Compute.TimelineValue || TransferValue > Transfer.TimelineValue)
+	{
+		throw std::invalid_argument("waiting for a timeline value that was never submitted");
+	}
+	std::vector<vk::Semaphore> Semaphores;
+	std::vector<uint64_t> Values;
+	for (const TimelineWait& Wait : { TimelineWait{ &Compute, ComputeValue }, TimelineWait{ &Transfer, TransferValue } })
+	{
+		if (Wait.Value > Wait.Queue->CompletedValue)
+		{
+			Semaphores.push_back(Wait.Queue->Timeline);
+			Values.push_back(Wait.Value);
+		}
+	}
+	if (!Semaphores.empty())
+	{
+		vk::SemaphoreWaitInfo WaitInfo(vk::SemaphoreWaitFlags(), static_cast<uint32_t>(Semaphores.size()), Semaphores.data(), Values.data());
+		const vk::Result WaitResult = Device.waitSemaphores(WaitInfo, TimeoutNs);
+		if (WaitResult == vk::Result::eTimeout)
+		{
+			return false;
+		}
+		// Later jobs may have finished as well
+		updateCompletedValues();
+	}
+	collectCompleted();
+	return true;
+}
+
+void ComputeContext::waitForOldestJob()
+{
+	const InFlightJob& Oldest = InFlightJobs.front();
+	waitForJob(Oldest.ComputeValue, Oldest.TransferValue, std::numeric_limits<uint64_t>::max());
+}
+
+void ComputeContext::updateCompletedValues()
+{
+	for (QueueState* Queue : { &Compute, &Transfer })
+	{
+		if (Queue->Timeline)
+		{
+			Queue->CompletedValue = Device.getSemaphoreCounterValue(Queue->Timeline);
+		}
+	}
+}
+
+void ComputeContext::collectCompleted()
+{
+	while (!InFlightJobs.empty())
+	{
+		InFlightJob& InFlight = InFlightJobs.front();
+		if (InFlight.ComputeValue > Compute.CompletedValue || InFlight.TransferValue > Transfer.CompletedValue)
+		{
+			break;
+		}
+		CompletedJobSerial = InFlight.Serial;
+		completeJob(InFlight.Downloads, InFlight.Prepared);
+		recycleJob(InFlight);
+		InFlightJobs.pop_front();
+	}
+}
+
+void ComputeContext::submit(const ComputeJob& Job)
+{
+	// Ordered after everything submitted before, like a queue wait idle between jobs used to be
+	std::vector<JobTicket> Dependencies;
+	if (!InFlightJobs.empty())
+	{
+		Dependencies.push_back(JobTicket(this, Compute.TimelineValue, Transfer.TimelineValue));
+	}
+	submitAsync(Job, Dependencies).wait();
+}
+
+JobTicket ComputeContext::submitAsync(const ComputeJob& Job, const std::vector<JobTicket>& Dependencies)
+{
+	std::vector<TimelineWait> Waits;
+	for (const JobTicket& Dependency : Dependencies)
+	{
+		if (Dependency.Context != this)
+		{
+			throw std::invalid_argument("job depends on a ticket of another context");
+		}
+		// Each queue signals its timeline in order, waiting for the latest value covers all earlier ones
+		Waits.push_back({ &Compute, Dependency.ComputeValue });
+		Waits.push_back({ &Transfer, Dependency.TransferValue });
+	}
+
+	// Bounds the command buffers, descriptor sets and staging memory held by jobs in flight
+	if (InFlightJobs.size() >= MaxJobsInFlight)
+	{
+		waitForOldestJob();
+	}
+	else
+	{
+		collectCompleted();
+	}
+
+	InFlightJob InFlight;
+	InFlight.Serial = JobSerial + 1;
+	InFlight.Prepared = prepareJob(Job);
+	InFlight.Downloads = Job.Downloads;
+	try
+	{
+		if (Transfer.Queue && (!Job.Uploads.empty() || !Job.Downloads.empty()))
+		{
+			submitSplitJob(Job, InFlight, Waits);
+		}
+		else
+		{
+			InFlight.ComputeValue = submitCommands(Compute, Job, [&](vk::CommandBuffer Cmd)
+			{
+				recordJob(Cmd, Job, InFlight.Prepared);
+			}, Waits, InFlight);
+		}
+	}
+	catch (...)
+	{
+		abandonJob(InFlight);
+		throw;
+	}
+	return trackJob(std::move(InFlight));
+}
+
+void ComputeContext::waitIdle()
+{
+	waitForJob(Compute.TimelineValue, Transfer.TimelineValue, std::numeric_limits<uint64_t>::max());
+}
+
+double ComputeContext::timeJob(const ComputeJob& Job, uint32_t Iterations)
+{
+	if (!Job.Kernel || Iterations == 0)
+	{
+		throw std::invalid_argument("timeJob needs a kernel and at least one iteration");
+	}
+	InFlightJob InFlight;
+	InFlight.Serial = JobSerial + 1;
+	InFlight.Prepared = prepareJob(Job);
+	const PreparedJob& Prepared = InFlight.Prepared;
+	ScopedQueryPool Queries{ Device, vk::QueryPool() };
+	if (TimestampValidBits > 0)
+	{
+		Queries.Pool = Device.createQueryPool(vk::QueryPoolCreateInfo(vk::QueryPoolCreateFlags(), vk::QueryType::eTimestamp, 2));
+	}
+	const vk::QueryPool QueryPool = Queries.Pool;
+	// Ordered after everything submitted before, like submit(), so that the timed dispatches neither
+	// overlap nor race with async jobs on the same buffers
+	std::vector<TimelineWait> Waits;
+	if (!InFlightJobs.empty())
+	{
+		Waits.push_back({ &Compute, Compute.TimelineValue });
+		Waits.push_back({ &Transfer, Transfer.TimelineValue });
+	}
+
+	const auto HostStart = std::chrono::steady_clock::now();
+	try
+	{
+		InFlight.ComputeValue = submitCommands(Compute, Job, [&](vk::CommandBuffer Cmd)
+		{
+			if (QueryPool)
+			{
+				Cmd.resetQueryPool(QueryPool, 0, 2);
+				Cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, QueryPool, 0);
+			}
+			const vk::MemoryBarrier Barrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+			for (uint32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				if (Iteration > 0)
+				{
+					// Serialize the dispatches, overlapping them would hide the per-dispatch cost
+					Cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+										vk::DependencyFlags(), Barrier, {}, {});
+				}
+				recordDispatch(Cmd, Job, Prepared);
+			}
+			if (QueryPool)
+			{
+				Cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, QueryPool, 1);
+			}
+		}, Waits, InFlight);
+	}
+	catch (...)
+	{
+		abandonJob(InFlight);
+		throw;
+	}
+	trackJob(std::move(InFlight)).wait();
+	const double HostTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - HostStart).count();
+
+	if (!QueryPool)
+	{
+		return HostTime / Iterations;
+	}
+	const std::vector<uint64_t> Timestamps = Device.getQueryPoolResults<uint64_t>(QueryPool, 0, 2, 2 * sizeof(uint64_t), sizeof(uint64_t),
+																				   vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait).value;
+	const uint64_t ValidMask = TimestampValidBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << TimestampValidBits) - 1;
+	const uint64_t Ticks = ((Timestamps[1] & ValidMask) - (Timestamps[0] & ValidMask)) & ValidMask;
+	return double(Ticks) * DeviceProps.limits.timestampPeriod / Iterations;
+}
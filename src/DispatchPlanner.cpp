@@ -0,0 +1,50 @@
+#include "DispatchPlanner.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+std::vector<DispatchSlice> planDispatch(uint64_t ElementCount, uint32_t GroupSize, uint32_t ElementSize, const vk::PhysicalDeviceLimits& Limits)
+{
+	if (GroupSize == 0)
+	{
+		throw std::invalid_argument("planDispatch needs a workgroup size");
+	}
+	if (ElementSize == 0 && ElementCount > UINT32_MAX)
+	{
+		throw std::invalid_argument("more than 2^32 elements need windowed slices, set the job's ElementSize");
+	}
+
+	// Powers of two keep every window offset a multiple of minStorageBufferOffsetAlignment
+	uint64_t MaxSliceElements = uint64_t(1) << 31;
+	if (ElementSize != 0)
+	{
+		const uint64_t RangeElements = Limits.maxStorageBufferRange / ElementSize;
+		while (MaxSliceElements > RangeElements && MaxSliceElements > 1)
+		{
+			MaxSliceElements >>= 1;
+		}
+	}
+	// Saturated, only needs to be compared against at most 2^31 groups
+	const uint64_t MaxGroupCount = std::min(uint64_t(Limits.maxComputeWorkGroupCount[0]) * Limits.maxComputeWorkGroupCount[1],
+											uint64_t(1) << 32) * Limits.maxComputeWorkGroupCount[2];
+	while (MaxSliceElements > GroupSize && (MaxSliceElements + GroupSize - 1) / GroupSize > MaxGroupCount)
+	{
+		MaxSliceElements >>= 1;
+	}
+
+	std::vector<DispatchSlice> Slices;
+	for (uint64_t FirstElement = 0; FirstElement < ElementCount; FirstElement += MaxSliceElements)
+	{
+		DispatchSlice Slice;
+		Slice.FirstElement = FirstElement;
+		Slice.ElementCount = static_cast<uint32_t>(std::min(MaxSliceElements, ElementCount - FirstElement));
+
+		const uint64_t NumGroups = (uint64_t(Slice.ElementCount) + GroupSize - 1) / GroupSize;
+		const uint64_t GroupsX = std::min<uint64_t>(NumGroups, Limits.maxComputeWorkGroupCount[0]);
+		const uint64_t GroupsY = std::min<uint64_t>((NumGroups + GroupsX - 1) / GroupsX, Limits.maxComputeWorkGroupCount[1]);
+		const uint64_t GroupsZ = (NumGroups + GroupsX * GroupsY - 1) / (GroupsX * GroupsY);
+		Slice.GroupCount = { static_cast<uint32_t>(GroupsX), static_cast<uint32_t>(GroupsY), static_cast<uint32_t>(GroupsZ) };
+		Slices.push_back(Slice);
+	}
+	return Slices;
+}
@@ -0,0 +1,205 @@
+#include "FourierTransformer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "Kernels.h"
+
+namespace
+{
+	// Points one shared-memory workgroup aims for, small transforms are batched up to it
+	constexpr uint32_t SharedPointsPerGroup = 1024;
+
+	template <typename T>
+	void setPushConstants(ComputeJob& Job, const T& Values)
+	{
+		Job.PushConstants.resize(sizeof(Values));
+		std::memcpy(Job.PushConstants.data(), &Values, sizeof(Values));
+	}
+
+	// Radices of the global passes in the order fft.glsl's radixOf picks them. An even count leaves
+	// the result back in the data, so a radix 4 is split in two or a copy (radix 1) is appended
+	std::vector<uint32_t> planRadices(uint32_t N)
+	{
+		std::vector<uint32_t> Radices;
+		for (uint32_t Remaining = N; Remaining > 1;)
+		{
+			const uint32_t Radix = Remaining % 4 == 0 ? 4 : Remaining % 2 == 0 ? 2 : Remaining % 3 == 0 ? 3 : 5;
+			Radices.push_back(Radix);
+			Remaining /= Radix;
+		}
+		if (Radices.size() % 2 != 0)
+		{
+			const auto Four = std::find(Radices.begin(), Radices.end(), 4u);
+			if (Four != Radices.end())
+			{
+				*Four = 2;
+				Radices.insert(Four, 2);
+			}
+			else
+			{
+				Radices.push_back(1);
+			}
+		}
+		return Radices;
+	}
+}
+
+FourierTransformer::FourierTransformer(ComputeContext& InContext)
+	: Context(InContext)
+{
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	Threads = std::min({ 256u, Limits.maxComputeWorkGroupInvocations, Limits.maxComputeWorkGroupSize[0] });
+}
+
+FourierTransformer::~FourierTransformer()
+{
+	Context.waitIdle();
+	for (auto& Entry : Twiddles)
+	{
+		Context.destroyBuffer(Entry.second);
+	}
+}
+
+bool FourierTransformer::isSupportedSize(uint32_t N)
+{
+	if (N == 0)
+	{
+		return false;
+	}
+	for (uint32_t Factor : { 2u, 3u, 5u })
+	{
+		while (N % Factor == 0)
+		{
+			N /= Factor;
+		}
+	}
+	return N == 1;
+}
+
+uint32_t FourierTransformer::getMaxSharedSize() const
+{
+	// Two copies of the signal, 8 bytes per point
+	return Context.getDeviceProperties().limits.maxComputeSharedMemorySize / (2 * 2 * sizeof(float));
+}
+
+const ComputeBuffer& FourierTransformer::getTwiddles(uint32_t N)
+{
+	const auto Found = Twiddles.find(N);
+	if (Found != Twiddles.end())
+	{
+		return Found->second;
+	}
+	const double Pi = 3.14159265358979323846;
+	std::vector<float> Table(size_t(N) * 2);
+	for (uint32_t M = 0; M < N; ++M)
+	{
+		const double Angle = -2.0 * Pi * M / N;
+		Table[2 * M] = float(std::cos(Angle));
+		Table[2 * M + 1] = float(std::sin(Angle));
+	}
+	ComputeBuffer Buffer = Context.createBuffer(Table.size() * sizeof(float));
+	Context.writeBuffer(Buffer, Table.data(), Table.size() * sizeof(float));
+	return Twiddles.emplace(N, Buffer).first->second;
+}
+
+void FourierTransformer::transform(const ComputeBuffer& Data, const ComputeBuffer* Scratch, const FftParams& Params)
+{
+	transformAsync(Data, Scratch, Params).wait();
+}
+
+JobTicket FourierTransformer::transformAsync(const ComputeBuffer& Data, const ComputeBuffer* Scratch, const FftParams& Params,
+											 const std::vector<JobTicket>& Dependencies)
+{
+	if (!isSupportedSize(Params.SizeX) || !isSupportedSize(Params.SizeY) || Params.Batch == 0)
+	{
+		throw std::invalid_argument("FFT sizes are products of 2, 3 and 5 with a non-zero batch");
+	}
+	const uint64_t NumPoints = uint64_t(Params.SizeX) * Params.SizeY * Params.Batch;
+	const vk::DeviceSize Size = NumPoints * 2 * sizeof(float);
+	if (Size > Context.getDeviceProperties().limits.maxStorageBufferRange)
+	{
+		throw std::invalid_argument("FFT data exceeds maxStorageBufferRange");
+	}
+	const uint32_t MaxShared = getMaxSharedSize();
+	const bool bNeedsScratch = Params.SizeX > MaxShared || Params.SizeY > MaxShared;
+	if (Data.Size < Size || (bNeedsScratch && (!Scratch || Scratch->Size < Size)))
+	{
+		throw std::invalid_argument("FFT buffers are smaller than the data, or the scratch buffer is missing");
+	}
+
+	// Rows are contiguous signals. Columns of the SizeX * SizeY planes are SizeX points apart
+	const AxisLayout Rows = { Params.SizeX, Params.SizeY * Params.Batch, 1, 1, 0, Params.SizeX };
+	JobTicket Ticket = transformAxis(Data, Scratch, Rows, Params, Dependencies);
+	if (Params.SizeY > 1)
+	{
+		const AxisLayout Columns = { Params.SizeY, Params.SizeX * Params.Batch, Params.SizeX, Params.SizeX, 1, Params.SizeX * Params.SizeY };
+		Ticket = transformAxis(Data, Scratch, Columns, Params, { Ticket });
+	}
+	return Ticket;
+}
+
+JobTicket FourierTransformer::transformAxis(const ComputeBuffer& Data, const ComputeBuffer* Scratch, const AxisLayout& Axis,
+											const FftParams& Params, const std::vector<JobTicket>& Dependencies)
+{
+	const bool bInverse = Params.Direction == FftDirection::Inverse;
+	float Scale = 1.0f;
+	if (Params.Normalization == FftNormalization::Orthonormal)
+	{
+		Scale = float(1.0 / std::sqrt(double(Axis.N)));
+	}
+	else if (Params.Normalization == FftNormalization::Backward && bInverse)
+	{
+		Scale = 1.0f / Axis.N;
+	}
+	const ComputeBuffer& TwiddleBuffer = getTwiddles(Axis.N);
+
+	if (Axis.N <= getMaxSharedSize())
+	{
+		// 共享内存路径: 每个工作组整段读入若干个信号, 所有 pass 都在共享内存里完成
+		const uint32_t Signals = std::max(1u, std::min(SharedPointsPerGroup, getMaxSharedSize()) / Axis.N);
+		const uint32_t NumGroups = (Axis.NumSignals + Signals - 1) / Signals;
+		const uint32_t MaxGroupsX = Context.getDeviceProperties().limits.maxComputeWorkGroupCount[0];
+		ComputeJob Job;
+		Job.Kernel = &Context.createKernel(kernels::fftShared(Axis.N, Signals, bInverse, Threads));
+		Job.Buffers = { &Data, &TwiddleBuffer };
+		Job.GroupCount = { std::min(NumGroups, MaxGroupsX), (NumGroups + MaxGroupsX - 1) / MaxGroupsX, 1 };
+		const struct
+		{
+			uint32_t NumSignals, ElementStride, InnerCount, InnerStride, OuterStride;
+			float Scale;
+		} PushConstants = { Axis.NumSignals, Axis.ElementStride, Axis.InnerCount, Axis.InnerStride, Axis.OuterStride, Scale };
+		setPushConstants(Job, PushConstants);
+		return Context.submitAsync(Job, Dependencies);
+	}
+
+	// Global path, the passes alternate between Data and Scratch and end in Data
+	const ComputeKernel& Pass = Context.createKernel(kernels::fftPass(bInverse));
+	const std::vector<uint32_t> Radices = planRadices(Axis.N);
+	const ComputeBuffer* Buffers[2] = { &Data, Scratch };
+	std::vector<JobTicket> Waits = Dependencies;
+	JobTicket Ticket;
+	uint32_t Ns = 1;
+	for (size_t Index = 0; Index < Radices.size(); ++Index)
+	{
+		const uint32_t Radix = Radices[Index];
+		ComputeJob Job;
+		Job.Kernel = &Pass;
+		Job.Buffers = { Buffers[Index % 2], Buffers[(Index + 1) % 2], &TwiddleBuffer };
+		Job.ElementCount = uint64_t(Axis.NumSignals) * (Axis.N / Radix);
+		Job.GroupSize = Threads;
+		const struct
+		{
+			uint32_t N, Radix, Ns, ElementStride, InnerCount, InnerStride, OuterStride;
+			float Scale;
+		} PushConstants = { Axis.N, Radix, Ns, Axis.ElementStride, Axis.InnerCount, Axis.InnerStride, Axis.OuterStride,
+							Index + 1 == Radices.size() ? Scale : 1.0f };
+		setPushConstants(Job, PushConstants);
+		Ticket = Context.submitAsync(Job, Waits);
+		Waits = { Ticket };
+		Ns *= Radix;
+	}
+	return Ticket;
+}
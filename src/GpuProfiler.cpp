@@ -0,0 +1,268 @@
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+
+namespace
+{
+	constexpr uint32_t SlabsPerQueue = 32;
+	// One start query and a begin/end pair per scope
+	constexpr uint32_t QueriesPerSlab = 64;
+	const char* CalibratedTimestampsName = "VK_EXT_calibrated_timestamps";
+
+	void printStats(std::ostream& Out, const std::string& Name, const GpuTimingStats& Stats)
+	{
+		Out << "  " << std::left << std::setw(24) << Name << std::right
+			<< " count " << std::setw(8) << Stats.Count
+			<< "  mean " << std::setw(10) << Stats.getMeanNs() / 1000.0 << " us"
+			<< "  min " << std::setw(10) << Stats.MinNs / 1000.0 << " us"
+			<< "  max " << std::setw(10) << Stats.MaxNs / 1000.0 << " us\n";
+	}
+}
+
+void GpuTimingStats::add(double Ns)
+{
+	MinNs = Count == 0 ? Ns : std::min(MinNs, Ns);
+	MaxNs = Count == 0 ? Ns : std::max(MaxNs, Ns);
+	TotalNs += Ns;
+	++Count;
+}
+
+bool GpuProfiler::supportsCalibratedTimestamps(vk::Instance Instance, vk::PhysicalDevice PhysicalDevice)
+{
+	const std::vector<vk::ExtensionProperties> Extensions = PhysicalDevice.enumerateDeviceExtensionProperties();
+	const bool bHasExtension = std::any_of(Extensions.begin(), Extensions.end(), [](const vk::ExtensionProperties& Extension)
+	{
+		return std::strcmp(Extension.extensionName.data(), CalibratedTimestampsName) == 0;
+	});
+	auto GetTimeDomains = reinterpret_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(
+		Instance.getProcAddr("vkGetPhysicalDeviceCalibrateableTimeDomainsEXT"));
+	if (!bHasExtension || !GetTimeDomains)
+	{
+		return false;
+	}
+
+	uint32_t NumDomains = 0;
+	GetTimeDomains(PhysicalDevice, &NumDomains, nullptr);
+	std::vector<VkTimeDomainEXT> Domains(NumDomains);
+	GetTimeDomains(PhysicalDevice, &NumDomains, Domains.data());
+	return std::find(Domains.begin(), Domains.end(), VK_TIME_DOMAIN_DEVICE_EXT) != Domains.end();
+}
+
+GpuProfiler::GpuProfiler(vk::PhysicalDevice InPhysicalDevice, vk::Device InDevice, bool bInHostQueryReset, bool bCalibratedTimestamps)
+	: PhysicalDevice(InPhysicalDevice)
+	, Device(InDevice)
+	, TimestampPeriod(InPhysicalDevice.getProperties().limits.timestampPeriod)
+	, bHostQueryReset(bInHostQueryReset)
+{
+	if (bCalibratedTimestamps)
+	{
+		GetCalibratedTimestamps = reinterpret_cast<PFN_vkGetCalibratedTimestampsEXT>(Device.getProcAddr("vkGetCalibratedTimestampsEXT"));
+	}
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	for (QueueSlot& Queue : Queues)
+	{
+		Device.destroyQueryPool(Queue.QueryPool);
+	}
+}
+
+uint32_t GpuProfiler::addQueue(uint32_t FamilyIndex, vk::QueueFlags QueueFlags)
+{
+	const uint32_t SlotIndex = static_cast<uint32_t>(Queues.size());
+	Queues.emplace_back();
+	Slabs.resize(Slabs.size() + SlabsPerQueue);
+	QueueSlot& Queue = Queues.back();
+
+	const uint32_t ValidBits = PhysicalDevice.getQueueFamilyProperties()[FamilyIndex].timestampValidBits;
+	Queue.bHostReset = bHostQueryReset;
+	const bool bCanReset = Queue.bHostReset || (QueueFlags & (vk::QueueFlagBits::eCompute | vk::QueueFlagBits::eGraphics));
+	if (ValidBits == 0 || !bCanReset)
+	{
+		// Not profiled, beginCommands hands out no slabs for this queue
+		return SlotIndex;
+	}
+	Queue.ValidMask = ValidBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << ValidBits) - 1;
+	Queue.QueryPool = Device.createQueryPool(vk::QueryPoolCreateInfo(vk::QueryPoolCreateFlags(), vk::QueryType::eTimestamp,
+																	 SlabsPerQueue * QueriesPerSlab));
+	for (uint32_t Index = 0; Index < SlabsPerQueue; ++Index)
+	{
+		const uint32_t SlabIndex = SlotIndex * SlabsPerQueue + Index;
+		Slabs[SlabIndex].QueueSlot = SlotIndex;
+		Slabs[SlabIndex].FirstQuery = Index * QueriesPerSlab;
+		Queue.FreeSlabs.push_back(SlabIndex);
+	}
+	return SlotIndex;
+}
+
+uint32_t GpuProfiler::beginCommands(uint32_t QueueSlotIndex, vk::CommandBuffer Cmd)
+{
+	QueueSlot& Queue = Queues[QueueSlotIndex];
+	if (!Queue.QueryPool || Queue.FreeSlabs.empty())
+	{
+		return NoSlab;
+	}
+	const uint32_t SlabIndex = Queue.FreeSlabs.back();
+	Queue.FreeSlabs.pop_back();
+
+	Slab& Active = Slabs[SlabIndex];
+	Active.Scopes.clear();
+	Active.NumQueries = 1;
+	Active.bHasSubmitTime = false;
+	// The slab's previous command buffer completed before the slab was freed
+	if (Queue.bHostReset)
+	{
+		Device.resetQueryPool(Queue.QueryPool, Active.FirstQuery, QueriesPerSlab);
+	}
+	else
+	{
+		Cmd.resetQueryPool(Queue.QueryPool, Active.FirstQuery, QueriesPerSlab);
+	}
+	Cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, Queue.QueryPool, Active.FirstQuery);
+	ActiveSlab = SlabIndex;
+	return SlabIndex;
+}
+
+uint32_t GpuProfiler::beginScope(vk::CommandBuffer Cmd, ProfileCategory Category, const std::string& Name)
+{
+	if (ActiveSlab == NoSlab)
+	{
+		return NoScope;
+	}
+	Slab& Active = Slabs[ActiveSlab];
+	if (Active.NumQueries + 2 > QueriesPerSlab)
+	{
+		++DroppedScopes;
+		return NoScope;
+	}
+	const uint32_t Query = Active.FirstQuery + Active.NumQueries;
+	Active.NumQueries += 2;
+	Active.Scopes.push_back({ Category, Name, Query });
+	Cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, Queues[Active.QueueSlot].QueryPool, Query);
+	return static_cast<uint32_t>(Active.Scopes.size() - 1);
+}
+
+void GpuProfiler::endScope(vk::CommandBuffer Cmd, uint32_t ScopeIndex)
+{
+	if (ActiveSlab == NoSlab || ScopeIndex == NoScope)
+	{
+		return;
+	}
+	const Slab& Active = Slabs[ActiveSlab];
+	Cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, Queues[Active.QueueSlot].QueryPool, Active.Scopes[ScopeIndex].Query + 1);
+}
+
+void GpuProfiler::endCommands()
+{
+	ActiveSlab = NoSlab;
+}
+
+void GpuProfiler::markSubmitted(uint32_t SlabIndex)
+{
+	if (SlabIndex == NoSlab || !GetCalibratedTimestamps)
+	{
+		return;
+	}
+	VkCalibratedTimestampInfoEXT TimestampInfo = {};
+	TimestampInfo.sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+	TimestampInfo.timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+	uint64_t Timestamp = 0;
+	uint64_t MaxDeviation = 0;
+	Slab& Submitted = Slabs[SlabIndex];
+	Submitted.bHasSubmitTime = GetCalibratedTimestamps(Device, 1, &TimestampInfo, &Timestamp, &MaxDeviation) == VK_SUCCESS;
+	Submitted.SubmitTime = Timestamp;
+}
+
+double GpuProfiler::ticksToNs(const QueueSlot& Queue, uint64_t Begin, uint64_t End) const
+{
+	return double((End - Begin) & Queue.ValidMask) * TimestampPeriod;
+}
+
+void GpuProfiler::resolve(uint32_t SlabIndex)
+{
+	if (SlabIndex == NoSlab)
+	{
+		return;
+	}
+	const Slab& Completed = Slabs[SlabIndex];
+	const QueueSlot& Queue = Queues[Completed.QueueSlot];
+	const std::vector<uint64_t> Timestamps = Device.getQueryPoolResults<uint64_t>(Queue.QueryPool, Completed.FirstQuery, Completed.NumQueries,
+																				   Completed.NumQueries * sizeof(uint64_t), sizeof(uint64_t),
+																				   vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait).value;
+	for (const Scope& Timed : Completed.Scopes)
+	{
+		const uint32_t Index = Timed.Query - Completed.FirstQuery;
+		const double Ns = ticksToNs(Queue, Timestamps[Index], Timestamps[Index + 1]);
+		switch (Timed.Category)
+		{
+		case ProfileCategory::Kernel: KernelStats[Timed.Name].add(Ns); break;
+		case ProfileCategory::Upload: UploadStats.add(Ns); break;
+		case ProfileCategory::Download: DownloadStats.add(Ns); break;
+		}
+	}
+	if (Completed.bHasSubmitTime)
+	{
+		const uint64_t Ticks = (Timestamps[0] - Completed.SubmitTime) & Queue.ValidMask;
+		// A start before the submit can only be jitter between the two clocks, skip it
+		if (Ticks <= Queue.ValidMask / 2)
+		{
+			QueueLatencyStats.add(double(Ticks) * TimestampPeriod);
+		}
+	}
+	freeSlab(SlabIndex);
+}
+
+void GpuProfiler::discard(uint32_t SlabIndex)
+{
+	if (SlabIndex != NoSlab)
+	{
+		freeSlab(SlabIndex);
+	}
+}
+
+void GpuProfiler::freeSlab(uint32_t SlabIndex)
+{
+	if (ActiveSlab == SlabIndex)
+	{
+		ActiveSlab = NoSlab;
+	}
+	Queues[Slabs[SlabIndex].QueueSlot].FreeSlabs.push_back(SlabIndex);
+}
+
+void GpuProfiler::resetStats()
+{
+	KernelStats.clear();
+	UploadStats = GpuTimingStats();
+	DownloadStats = GpuTimingStats();
+	QueueLatencyStats = GpuTimingStats();
+	DroppedScopes = 0;
+}
+
+void GpuProfiler::report(std::ostream& Out) const
+{
+	Out << "GPU time per kernel:\n";
+	for (const auto& Kernel : KernelStats)
+	{
+		printStats(Out, Kernel.first, Kernel.second);
+	}
+	Out << "GPU time per copy batch:\n";
+	printStats(Out, "upload", UploadStats);
+	printStats(Out, "download", DownloadStats);
+	if (GetCalibratedTimestamps)
+	{
+		Out << "Queue latency, submit to start:\n";
+		printStats(Out, "latency", QueueLatencyStats);
+	}
+	else
+	{
+		Out << "Queue latency: unavailable without " << CalibratedTimestampsName << "\n";
+	}
+	if (DroppedScopes > 0)
+	{
+		Out << "Dropped scopes: " << DroppedScopes << "\n";
+	}
+	Out << std::flush;
+}
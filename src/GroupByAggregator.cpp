@@ -0,0 +1,203 @@
+#include "GroupByAggregator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+	// Workgroups stride over the rows beyond this, so that every shared table takes many rows
+	constexpr uint32_t MaxWorkgroups = 1024;
+	// Upper bound of the shared groups per workgroup, more only lengthen the merge
+	constexpr uint32_t MaxSharedSlots = 2048;
+	// Mirrors the STATUS_ constants of shaders/group_by.comp
+	constexpr uint32_t StatusWords = 3;
+
+	void setGroupByPushConstants(ComputeJob& Job, uint32_t NumRows, uint32_t NumSlots, uint32_t MaxGroups)
+	{
+		const uint32_t Values[] = { NumRows, NumSlots, MaxGroups };
+		Job.PushConstants.resize(sizeof(Values));
+		std::memcpy(Job.PushConstants.data(), Values, sizeof(Values));
+	}
+
+	double valueOf(uint32_t Bits, kernels::ElementType Type)
+	{
+		if (Type == kernels::ElementType::Float)
+		{
+			float Value;
+			std::memcpy(&Value, &Bits, sizeof(Value));
+			return Value;
+		}
+		return Type == kernels::ElementType::Int ? double(static_cast<int32_t>(Bits)) : double(Bits);
+	}
+}
+
+GroupByAggregator::GroupByAggregator(ComputeContext& InContext, uint32_t InMaxGroups)
+	: Context(InContext)
+	, MaxGroups(InMaxGroups)
+{
+	if (MaxGroups == 0 || MaxGroups > UINT32_MAX / 2)
+	{
+		throw std::invalid_argument("group-bys take 1 to 2^31 - 1 groups");
+	}
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	// Half full at most, probes stay short
+	NumSlots = 2 * MaxGroups;
+	if (vk::DeviceSize(NumSlots) * (1 + kernels::GroupByMaxColumns) * sizeof(uint32_t) > Limits.maxStorageBufferRange)
+	{
+		throw std::invalid_argument("group-by table exceeds maxStorageBufferRange");
+	}
+	GroupSize = std::min({ 256u, Limits.maxComputeWorkGroupInvocations, Limits.maxComputeWorkGroupSize[0] });
+	TableKeys = Context.createBuffer(vk::DeviceSize(NumSlots) * sizeof(uint32_t));
+	TableWords = Context.createBuffer(vk::DeviceSize(NumSlots) * (1 + kernels::GroupByMaxColumns) * sizeof(uint32_t));
+	Status = Context.createBuffer(StatusWords * sizeof(uint32_t));
+}
+
+GroupByAggregator::~GroupByAggregator()
+{
+	Context.waitIdle();
+	Context.destroyBuffer(TableKeys);
+	Context.destroyBuffer(TableWords);
+	Context.destroyBuffer(Status);
+	Context.destroyBuffer(Rows);
+}
+
+uint32_t GroupByAggregator::getSharedSlots(uint32_t NumColumns) const
+{
+	// A key, a count and a state per column, next to the two words of the output pass
+	const uint32_t SharedSize = Context.getDeviceProperties().limits.maxComputeSharedMemorySize;
+	return std::min(MaxSharedSlots, (SharedSize - 2 * sizeof(uint32_t)) / ((2 + NumColumns) * sizeof(uint32_t)));
+}
+
+void GroupByAggregator::ensureBuffer(ComputeBuffer& Buffer, vk::DeviceSize Size)
+{
+	if (Buffer.Size >= Size)
+	{
+		return;
+	}
+	if (LastJob.isValid())
+	{
+		LastJob.wait();
+	}
+	Context.destroyBuffer(Buffer);
+	Buffer = Context.createBuffer(Size);
+}
+
+JobTicket GroupByAggregator::aggregateAsync(const ComputeBuffer& Keys, uint32_t NumRows, const std::vector<AggregateColumn>& Columns,
+											const ComputeBuffer& Output, const GroupByOptions& Options, const std::vector<JobTicket>& Dependencies)
+{
+	const uint32_t NumColumns = static_cast<uint32_t>(Columns.size());
+	if (NumRows == 0 || NumColumns == 0 || NumColumns > kernels::GroupByMaxColumns)
+	{
+		throw std::invalid_argument("group-bys take at least one row and 1 to GroupByMaxColumns columns");
+	}
+	if (Keys.Size < vk::DeviceSize(NumRows) * sizeof(uint32_t) ||
+		Output.Size < vk::DeviceSize(MaxGroups) * (2 + NumColumns) * sizeof(uint32_t))
+	{
+		throw std::invalid_argument("group-by buffers are smaller than their rows");
+	}
+	std::vector<kernels::AggregateOp> Ops;
+	std::vector<kernels::ElementType> Types;
+	for (const AggregateColumn& Column : Columns)
+	{
+		if (Column.Op != kernels::AggregateOp::Count && (!Column.Values || Column.Values->Size < vk::DeviceSize(NumRows) * sizeof(uint32_t)))
+		{
+			throw std::invalid_argument("group-by columns need a value per row");
+		}
+		Ops.push_back(Column.Op);
+		// Counts do not depend on the type, one pipeline for all of them
+		Types.push_back(Column.Op == kernels::AggregateOp::Count ? kernels::ElementType::Uint : Column.Type);
+	}
+
+	const uint32_t SharedSlots = getSharedSlots(NumColumns);
+	const bool bShared = Options.Strategy == GroupByStrategy::Shared ||
+		(Options.Strategy == GroupByStrategy::Auto && Options.ExpectedGroups <= SharedSlots / 2);
+
+	std::vector<JobTicket> Waits = Dependencies;
+	if (LastJob.isValid())
+	{
+		Waits.push_back(LastJob);
+	}
+	ComputeJob Job;
+	Job.Kernel = &Context.createKernel(kernels::groupBy(kernels::GroupByMode::Aggregate, Ops, Types, bShared ? SharedSlots : 0));
+	Job.Buffers = { &Keys, &TableKeys, &TableWords, &Status, &Output };
+	for (uint32_t Column = 0; Column < kernels::GroupByMaxColumns; ++Column)
+	{
+		Job.Buffers.push_back(Column < NumColumns && Columns[Column].Values ? Columns[Column].Values : &Keys);
+	}
+	const uint32_t NumWorkgroups = std::min(MaxWorkgroups, (NumRows + GroupSize - 1) / GroupSize);
+	Job.ElementCount = uint64_t(NumWorkgroups) * GroupSize;
+	Job.GroupSize = GroupSize;
+	setGroupByPushConstants(Job, NumRows, NumSlots, MaxGroups);
+	// A fresh table: empty keys, zero counts and every column state at its identity
+	const vk::DeviceSize RegionSize = vk::DeviceSize(NumSlots) * sizeof(uint32_t);
+	Job.Fills = { { &TableKeys, 0xffffffffu, VK_WHOLE_SIZE, 0 }, { &TableWords, 0, RegionSize, 0 }, { &Status, 0, VK_WHOLE_SIZE, 0 } };
+	for (uint32_t Column = 0; Column < NumColumns; ++Column)
+	{
+		const uint32_t Identity = Ops[Column] == kernels::AggregateOp::Min ? 0xffffffffu : 0;
+		Job.Fills.push_back({ &TableWords, Identity, RegionSize, (1 + Column) * RegionSize });
+	}
+	const JobTicket Aggregated = Context.submitAsync(Job, Waits);
+
+	ComputeJob OutputJob = Job;
+	OutputJob.Kernel = &Context.createKernel(kernels::groupBy(kernels::GroupByMode::Output, Ops, Types, 0));
+	OutputJob.ElementCount = NumSlots;
+	OutputJob.GroupSize = 0;
+	OutputJob.Fills.clear();
+	LastJob = Context.submitAsync(OutputJob, { Aggregated });
+	return LastJob;
+}
+
+uint32_t GroupByAggregator::getGroupCount()
+{
+	if (!LastJob.isValid())
+	{
+		return 0;
+	}
+	LastJob.wait();
+	uint32_t Words[StatusWords];
+	Context.readBuffer(Status, Words, sizeof(Words));
+	if (Words[1] != 0)
+	{
+		throw std::runtime_error(std::to_string(Words[1]) + " rows were not grouped, the table is full or their key is 0xffffffff");
+	}
+	if (Words[0] > MaxGroups)
+	{
+		throw std::runtime_error("group-by found " + std::to_string(Words[0]) + " groups, more than MaxGroups");
+	}
+	return Words[0];
+}
+
+GroupByResult GroupByAggregator::aggregate(const ComputeBuffer& Keys, uint32_t NumRows, const std::vector<AggregateColumn>& Columns,
+										   const GroupByOptions& Options)
+{
+	const size_t RowWords = 2 + Columns.size();
+	ensureBuffer(Rows, vk::DeviceSize(MaxGroups) * RowWords * sizeof(uint32_t));
+	aggregateAsync(Keys, NumRows, Columns, Rows, Options);
+	const uint32_t NumGroups = getGroupCount();
+
+	std::vector<uint32_t> Words(NumGroups * RowWords);
+	if (NumGroups != 0)
+	{
+		Context.readBuffer(Rows, Words.data(), Words.size() * sizeof(uint32_t));
+	}
+	GroupByResult Result;
+	Result.Keys.resize(NumGroups);
+	Result.Counts.resize(NumGroups);
+	Result.Aggregates.assign(Columns.size(), std::vector<double>(NumGroups));
+	for (uint32_t Group = 0; Group < NumGroups; ++Group)
+	{
+		const uint32_t* Row = &Words[Group * RowWords];
+		Result.Keys[Group] = Row[0];
+		Result.Counts[Group] = Row[1];
+		for (size_t Column = 0; Column < Columns.size(); ++Column)
+		{
+			const kernels::AggregateOp Op = Columns[Column].Op;
+			const kernels::ElementType Type = Op == kernels::AggregateOp::Count ? kernels::ElementType::Uint
+				: (Op == kernels::AggregateOp::Avg ? kernels::ElementType::Float : Columns[Column].Type);
+			Result.Aggregates[Column][Group] = valueOf(Row[2 + Column], Type);
+		}
+	}
+	return Result;
+}
@@ -0,0 +1,246 @@
+#include "HashTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+	// Mirrors the STATUS_ constants of shaders/hash_table.glsl
+	constexpr uint32_t StatusWords = 5;
+	constexpr vk::DeviceSize RetrievedOffset = 3 * sizeof(uint32_t);
+	constexpr vk::DeviceSize MatchesOffset = 4 * sizeof(uint32_t);
+
+	void setHashPushConstants(ComputeJob& Job, uint32_t NumKeys, uint32_t NumSlots, uint32_t OutputCapacity)
+	{
+		const uint32_t Values[] = { NumKeys, NumSlots, OutputCapacity };
+		Job.PushConstants.resize(sizeof(Values));
+		std::memcpy(Job.PushConstants.data(), Values, sizeof(Values));
+	}
+}
+
+HashTable::HashTable(ComputeContext& InContext, uint32_t Capacity, const HashTableOptions& InOptions)
+	: Context(InContext)
+	, Options(InOptions)
+	, Scan(InContext)
+{
+	if (!isSupported(Context, Options.KeyType))
+	{
+		throw std::runtime_error("64-bit hash table keys need shaderInt64 and shaderBufferInt64Atomics");
+	}
+	if (Capacity == 0 || !(Options.MaxLoadFactor > 0.0f && Options.MaxLoadFactor <= 1.0f))
+	{
+		throw std::invalid_argument("hash tables take a non-zero capacity and a load factor in (0, 1]");
+	}
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	KeySize = Options.KeyType == kernels::HashKeyType::Uint64 ? sizeof(uint64_t) : sizeof(uint32_t);
+	// One slot stays empty so that probes for missing keys end
+	const double Slots = std::max(std::ceil(double(Capacity) / Options.MaxLoadFactor), double(Capacity) + 1);
+	if (Slots > UINT32_MAX || Slots * KeySize > Limits.maxStorageBufferRange)
+	{
+		throw std::invalid_argument("hash table slots exceed 2^32 - 1 or maxStorageBufferRange");
+	}
+	NumSlots = static_cast<uint32_t>(Slots);
+	GroupSize = std::min({ 256u, Limits.maxComputeWorkGroupInvocations, Limits.maxComputeWorkGroupSize[0] });
+	TableKeys = Context.createBuffer(vk::DeviceSize(NumSlots) * KeySize);
+	TableValues = Context.createBuffer(vk::DeviceSize(NumSlots) * sizeof(uint32_t));
+	Status = Context.createBuffer(StatusWords * sizeof(uint32_t));
+}
+
+HashTable::~HashTable()
+{
+	Context.waitIdle();
+	Context.destroyBuffer(TableKeys);
+	Context.destroyBuffer(TableValues);
+	Context.destroyBuffer(Status);
+	Context.destroyBuffer(Counts);
+}
+
+bool HashTable::isSupported(const ComputeContext& Context, kernels::HashKeyType KeyType)
+{
+	return KeyType == kernels::HashKeyType::Uint32 || Context.hasBufferInt64Atomics();
+}
+
+void HashTable::clear()
+{
+	bClearPending = true;
+}
+
+void HashTable::checkKeys(const ComputeBuffer& Keys, uint32_t NumKeys) const
+{
+	if (NumKeys == 0)
+	{
+		throw std::invalid_argument("hash table operations take at least one key");
+	}
+	if (Keys.Size < vk::DeviceSize(NumKeys) * KeySize)
+	{
+		throw std::invalid_argument("hash table key buffer is smaller than its keys");
+	}
+}
+
+void HashTable::ensureCounts(vk::DeviceSize Size)
+{
+	if (Counts.Size >= Size)
+	{
+		return;
+	}
+	if (LastJob.isValid())
+	{
+		LastJob.wait();
+	}
+	Context.destroyBuffer(Counts);
+	Counts = Context.createBuffer(Size);
+}
+
+ComputeJob HashTable::makeJob(kernels::HashTableMode Mode, const ComputeBuffer& Keys, const ComputeBuffer* Values, uint32_t NumKeys,
+							  uint32_t OutputCapacity)
+{
+	const bool bValues = Mode == kernels::HashTableMode::Insert && Values != nullptr;
+	ComputeJob Job;
+	Job.Kernel = &Context.createKernel(kernels::hashTable(Mode, Options.KeyType, Options.bUnique, bValues));
+	Job.Buffers = { &TableKeys, &TableValues, &Keys, Values ? Values : &TableValues, &TableValues, &TableValues, &Status };
+	Job.ElementCount = NumKeys;
+	Job.GroupSize = GroupSize;
+	setHashPushConstants(Job, NumKeys, NumSlots, OutputCapacity);
+	return Job;
+}
+
+JobTicket HashTable::submit(ComputeJob& Job, const std::vector<JobTicket>& Dependencies)
+{
+	if (bClearPending)
+	{
+		Job.Fills.push_back({ &TableKeys, 0xffffffffu, VK_WHOLE_SIZE, 0 });
+		Job.Fills.push_back({ &TableValues, 0xffffffffu, VK_WHOLE_SIZE, 0 });
+		Job.Fills.push_back({ &Status, 0, VK_WHOLE_SIZE, 0 });
+		bClearPending = false;
+	}
+	std::vector<JobTicket> Waits = Dependencies;
+	if (LastJob.isValid())
+	{
+		Waits.push_back(LastJob);
+	}
+	LastJob = Context.submitAsync(Job, Waits);
+	return LastJob;
+}
+
+void HashTable::insert(const ComputeBuffer& Keys, uint32_t NumKeys, const ComputeBuffer* Values)
+{
+	const uint32_t FailedBefore = getStats().FailedInserts;
+	insertAsync(Keys, NumKeys, Values).wait();
+	const uint32_t Failed = getStats().FailedInserts - FailedBefore;
+	if (Failed != 0)
+	{
+		throw std::runtime_error(std::to_string(Failed) + " keys were not inserted, the hash table is full or they are marker keys");
+	}
+}
+
+JobTicket HashTable::insertAsync(const ComputeBuffer& Keys, uint32_t NumKeys, const ComputeBuffer* Values,
+								 const std::vector<JobTicket>& Dependencies)
+{
+	checkKeys(Keys, NumKeys);
+	if (Values && Values->Size < vk::DeviceSize(NumKeys) * sizeof(uint32_t))
+	{
+		throw std::invalid_argument("hash table value buffer is smaller than its keys");
+	}
+	ComputeJob Job = makeJob(kernels::HashTableMode::Insert, Keys, Values, NumKeys);
+	return submit(Job, Dependencies);
+}
+
+void HashTable::find(const ComputeBuffer& Keys, uint32_t NumKeys, const ComputeBuffer& Values)
+{
+	findAsync(Keys, NumKeys, Values).wait();
+}
+
+JobTicket HashTable::findAsync(const ComputeBuffer& Keys, uint32_t NumKeys, const ComputeBuffer& Values, const std::vector<JobTicket>& Dependencies)
+{
+	checkKeys(Keys, NumKeys);
+	if (Values.Size < vk::DeviceSize(NumKeys) * sizeof(uint32_t))
+	{
+		throw std::invalid_argument("hash table value buffer is smaller than its keys");
+	}
+	ComputeJob Job = makeJob(kernels::HashTableMode::Find, Keys, &Values, NumKeys);
+	return submit(Job, Dependencies);
+}
+
+void HashTable::erase(const ComputeBuffer& Keys, uint32_t NumKeys)
+{
+	eraseAsync(Keys, NumKeys).wait();
+}
+
+JobTicket HashTable::eraseAsync(const ComputeBuffer& Keys, uint32_t NumKeys, const std::vector<JobTicket>& Dependencies)
+{
+	checkKeys(Keys, NumKeys);
+	ComputeJob Job = makeJob(kernels::HashTableMode::Erase, Keys, nullptr, NumKeys);
+	return submit(Job, Dependencies);
+}
+
+uint32_t HashTable::retrieve(const ComputeBuffer& Keys, const ComputeBuffer& Values, uint32_t Capacity)
+{
+	retrieveAsync(Keys, Values, Capacity).wait();
+	return getStats().Retrieved;
+}
+
+JobTicket HashTable::retrieveAsync(const ComputeBuffer& Keys, const ComputeBuffer& Values, uint32_t Capacity,
+								   const std::vector<JobTicket>& Dependencies)
+{
+	if (Keys.Size < vk::DeviceSize(Capacity) * KeySize || Values.Size < vk::DeviceSize(Capacity) * sizeof(uint32_t))
+	{
+		throw std::invalid_argument("retrieve output buffers are smaller than their capacity");
+	}
+	ComputeJob Job = makeJob(kernels::HashTableMode::Retrieve, Keys, &Values, NumSlots, Capacity);
+	Job.Fills.push_back({ &Status, 0, sizeof(uint32_t), RetrievedOffset });
+	return submit(Job, Dependencies);
+}
+
+uint32_t HashTable::join(const ComputeBuffer& ProbeKeys, uint32_t NumProbeKeys, const ComputeBuffer& ProbeIndices,
+						 const ComputeBuffer& BuildValues, uint32_t Capacity)
+{
+	joinAsync(ProbeKeys, NumProbeKeys, ProbeIndices, BuildValues, Capacity).wait();
+	return getStats().JoinMatches;
+}
+
+JobTicket HashTable::joinAsync(const ComputeBuffer& ProbeKeys, uint32_t NumProbeKeys, const ComputeBuffer& ProbeIndices,
+							   const ComputeBuffer& BuildValues, uint32_t Capacity, const std::vector<JobTicket>& Dependencies)
+{
+	checkKeys(ProbeKeys, NumProbeKeys);
+	if (ProbeIndices.Size < vk::DeviceSize(Capacity) * sizeof(uint32_t) || BuildValues.Size < vk::DeviceSize(Capacity) * sizeof(uint32_t))
+	{
+		throw std::invalid_argument("join output buffers are smaller than their capacity");
+	}
+	ensureCounts(vk::DeviceSize(NumProbeKeys) * sizeof(uint32_t));
+
+	ComputeJob CountJob = makeJob(kernels::HashTableMode::JoinCount, ProbeKeys, &Counts, NumProbeKeys);
+	CountJob.Fills.push_back({ &Status, 0, sizeof(uint32_t), MatchesOffset });
+	const JobTicket Counted = submit(CountJob, Dependencies);
+	ScanOptions Exclusive;
+	Exclusive.bExclusive = true;
+	const JobTicket Scanned = Scan.scanAsync(Counts, Counts, NumProbeKeys, Exclusive, { Counted });
+
+	ComputeJob WriteJob = makeJob(kernels::HashTableMode::JoinWrite, ProbeKeys, &Counts, NumProbeKeys, Capacity);
+	WriteJob.Buffers[4] = &ProbeIndices;
+	WriteJob.Buffers[5] = &BuildValues;
+	return submit(WriteJob, { Scanned });
+}
+
+HashTableStats HashTable::getStats()
+{
+	if (LastJob.isValid())
+	{
+		LastJob.wait();
+	}
+	HashTableStats Stats;
+	if (bClearPending)
+	{
+		return Stats;
+	}
+	uint32_t Words[StatusWords];
+	Context.readBuffer(Status, Words, sizeof(Words));
+	Stats.Size = Words[0];
+	Stats.UsedSlots = Words[1];
+	Stats.FailedInserts = Words[2];
+	Stats.Retrieved = Words[3];
+	Stats.JoinMatches = Words[4];
+	return Stats;
+}
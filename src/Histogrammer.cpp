@@ -0,0 +1,124 @@
+#include "Histogrammer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace
+{
+	// Workgroups stride over the elements. A privatized workgroup ends by adding every non-zero shared
+	// bin to the global bins, so the cap bounds that flush to MaxGroups * BinCount atomics
+	constexpr uint32_t MaxGroups = 1024;
+	// Shared bin counts are rounded up to this, so that nearby bin counts share a pipeline
+	constexpr uint32_t SharedBinGranularity = 256;
+
+	template <typename T>
+	struct HistogramTypeOf;
+	template <>
+	struct HistogramTypeOf<uint32_t> { static constexpr kernels::HistogramType Value = kernels::HistogramType::Uint32; };
+	template <>
+	struct HistogramTypeOf<int32_t> { static constexpr kernels::HistogramType Value = kernels::HistogramType::Int32; };
+	template <>
+	struct HistogramTypeOf<float> { static constexpr kernels::HistogramType Value = kernels::HistogramType::Float32; };
+
+	template <typename T>
+	uint32_t bitsOf(T Value)
+	{
+		uint32_t Bits;
+		std::memcpy(&Bits, &Value, sizeof(Bits));
+		return Bits;
+	}
+
+	// Integer bins are ceil((Max - Min + 1) / BinCount) wide, which cannot overflow as (Max - Min) / BinCount + 1
+	template <typename T>
+	uint32_t binWidthOf(T Min, T Max, uint32_t BinCount)
+	{
+		return (bitsOf(Max) - bitsOf(Min)) / BinCount + 1;
+	}
+	template <>
+	uint32_t binWidthOf<float>(float, float, uint32_t)
+	{
+		return 0;
+	}
+}
+
+Histogrammer::Histogrammer(ComputeContext& InContext)
+	: Context(InContext)
+{
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	GroupSize = std::min({ 256u, Limits.maxComputeWorkGroupInvocations, Limits.maxComputeWorkGroupSize[0] });
+	MaxSharedBins = Limits.maxComputeSharedMemorySize / sizeof(uint32_t) / SharedBinGranularity * SharedBinGranularity;
+}
+
+JobTicket Histogrammer::histogramRaw(const ComputeBuffer& Input, uint64_t NumElements, kernels::HistogramType Type, uint32_t MinBits,
+									 uint32_t MaxBits, uint32_t BinWidth, uint32_t BinCount, const ComputeBuffer& Bins,
+									 HistogramStrategy Strategy, const std::vector<JobTicket>& Dependencies)
+{
+	if (NumElements == 0 || NumElements > UINT32_MAX)
+	{
+		throw std::invalid_argument("histograms take 1 to 2^32 - 1 elements");
+	}
+	if (BinCount == 0)
+	{
+		throw std::invalid_argument("histograms need at least one bin");
+	}
+	if (Input.Size < NumElements * sizeof(uint32_t) || Bins.Size < vk::DeviceSize(BinCount) * sizeof(uint32_t))
+	{
+		throw std::invalid_argument("histogram buffers are smaller than their elements or bins");
+	}
+	const bool bFits = BinCount <= MaxSharedBins;
+	if (Strategy == HistogramStrategy::SharedMemory && !bFits)
+	{
+		throw std::invalid_argument("histogram bins do not fit maxComputeSharedMemorySize");
+	}
+	const bool bPrivatized = Strategy == HistogramStrategy::SharedMemory || (Strategy == HistogramStrategy::Auto && bFits);
+	const uint32_t SharedBins = (BinCount + SharedBinGranularity - 1) / SharedBinGranularity * SharedBinGranularity;
+
+	const uint32_t NumGroups = static_cast<uint32_t>(std::min<uint64_t>(MaxGroups, (NumElements + GroupSize - 1) / GroupSize));
+	ComputeJob Job;
+	Job.Kernel = &Context.createKernel(kernels::histogram(Type, bPrivatized, SharedBins));
+	Job.Buffers = { &Input, &Bins };
+	Job.ElementCount = uint64_t(NumGroups) * GroupSize;
+	Job.GroupSize = GroupSize;
+	Job.Fills = { { &Bins, 0, vk::DeviceSize(BinCount) * sizeof(uint32_t), 0 } };
+	const uint32_t Values[] = { static_cast<uint32_t>(NumElements), BinCount, MinBits, MaxBits, BinWidth };
+	Job.PushConstants.resize(sizeof(Values));
+	std::memcpy(Job.PushConstants.data(), Values, sizeof(Values));
+	return Context.submitAsync(Job, Dependencies);
+}
+
+template <typename T>
+JobTicket Histogrammer::histogramAsync(const ComputeBuffer& Input, uint64_t NumElements, T Min, T Max, uint32_t BinCount,
+									   const ComputeBuffer& Bins, HistogramStrategy Strategy, const std::vector<JobTicket>& Dependencies)
+{
+	// Floats need a range to divide by, finite in T since the shader divides by it in T. Integer
+	// ranges may hold a single key
+	if (std::is_floating_point<T>::value ? !(Min < Max) || !std::isfinite(Max - Min) : Max < Min)
+	{
+		throw std::invalid_argument("histogram range is empty");
+	}
+	return histogramRaw(Input, NumElements, HistogramTypeOf<T>::Value, bitsOf(Min), bitsOf(Max), binWidthOf(Min, Max, BinCount),
+						BinCount, Bins, Strategy, Dependencies);
+}
+
+template <typename T>
+void Histogrammer::histogram(const ComputeBuffer& Input, uint64_t NumElements, T Min, T Max, uint32_t BinCount, const ComputeBuffer& Bins,
+							 HistogramStrategy Strategy)
+{
+	histogramAsync(Input, NumElements, Min, Max, BinCount, Bins, Strategy).wait();
+}
+
+template JobTicket Histogrammer::histogramAsync<uint32_t>(const ComputeBuffer&, uint64_t, uint32_t, uint32_t, uint32_t, const ComputeBuffer&,
+														  HistogramStrategy, const std::vector<JobTicket>&);
+template JobTicket Histogrammer::histogramAsync<int32_t>(const ComputeBuffer&, uint64_t, int32_t, int32_t, uint32_t, const ComputeBuffer&,
+														 HistogramStrategy, const std::vector<JobTicket>&);
+template JobTicket Histogrammer::histogramAsync<float>(const ComputeBuffer&, uint64_t, float, float, uint32_t, const ComputeBuffer&,
+													   HistogramStrategy, const std::vector<JobTicket>&);
+template void Histogrammer::histogram<uint32_t>(const ComputeBuffer&, uint64_t, uint32_t, uint32_t, uint32_t, const ComputeBuffer&,
+												HistogramStrategy);
+template void Histogrammer::histogram<int32_t>(const ComputeBuffer&, uint64_t, int32_t, int32_t, uint32_t, const ComputeBuffer&,
+											   HistogramStrategy);
+template void Histogrammer::histogram<float>(const ComputeBuffer&, uint64_t, float, float, uint32_t, const ComputeBuffer&,
+											 HistogramStrategy);
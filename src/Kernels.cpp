@@ -0,0 +1,424 @@
+#include "Kernels.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace kernels
+{
+	KernelDesc add()
+	{
+		KernelDesc Desc;
+		Desc.Name = "Add";
+		Desc.SpirvPath = "shaders/compute.spv";
+		Desc.Bindings = {
+			{0, vk::DescriptorType::eStorageBuffer, 3, vk::ShaderStageFlagBits::eCompute}
+		};
+		Desc.PushConstantSize = sizeof(DispatchParams);
+		Desc.DefaultGroupSize = 64;
+		return Desc;
+	}
+
+	KernelDesc square()
+	{
+		KernelDesc Desc;
+		Desc.Name = "Square";
+		Desc.SpirvPath = "shaders/Square.spv";
+		Desc.Bindings = {
+			{0, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute},
+			{1, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute}
+		};
+		Desc.PushConstantSize = sizeof(DispatchParams);
+		Desc.DefaultGroupSize = 64;
+		return Desc;
+	}
+
+	KernelDesc elementwiseVec4(ElementwiseOp Op, ElementType Type)
+	{
+		static const char* const OpNames[] = { "Add", "Sub", "Mul", "Square", "Fma", "Min", "Max" };
+		static const char* const TypeNames[] = { "u32", "i32", "f32" };
+		KernelDesc Desc;
+		Desc.Name = std::string("Vec4.") + OpNames[static_cast<uint32_t>(Op)] + "." + TypeNames[static_cast<uint32_t>(Type)];
+		Desc.SpirvPath = "shaders/elementwise_vec4.spv";
+		Desc.Bindings = {
+			{0, vk::DescriptorType::eStorageBuffer, 3, vk::ShaderStageFlagBits::eCompute}
+		};
+		Desc.PushConstantSize = sizeof(DispatchParams) + sizeof(uint32_t);
+		Desc.SpecConstants = { {1, static_cast<uint32_t>(Op)}, {2, static_cast<uint32_t>(Type)}, {3, Vec4VectorsPerThread} };
+		Desc.DefaultGroupSize = 64;
+		return Desc;
+	}
+
+	KernelDesc reduce(ReduceOp Op, ReduceType Type, uint32_t Stage)
+	{
+		static const char* const OpNames[] = { "Sum", "Min", "Max", "ArgMin", "ArgMax" };
+		static const char* const TypeNames[] = { "u32", "i32", "f32", "f64" };
+		const char* TypeName = TypeNames[static_cast<uint32_t>(Type)];
+		KernelDesc Desc;
+		Desc.Name = std::string("Reduce.") + OpNames[static_cast<uint32_t>(Op)] + "." + TypeName + "." + std::to_string(Stage);
+		Desc.SpirvPath = std::string("shaders/reduce_") + TypeName + ".spv";
+		Desc.Bindings = {
+			{0, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute},
+			{1, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute}
+		};
+		// DispatchParams, NumElements, FirstIndex, OutputOffset
+		Desc.PushConstantSize = sizeof(DispatchParams) + 3 * sizeof(uint32_t);
+		Desc.SpecConstants = { {1, static_cast<uint32_t>(Op)}, {2, Stage} };
+		Desc.DefaultGroupSize = 256;
+		return Desc;
+	}
+
+	KernelDesc scan(ScanMode Mode, bool bExclusive, bool bSegmented)
+	{
+		static const char* const ModeNames[] = { "SinglePass", "ReduceTiles", "ScanTiles", "ScanWithCarry" };
+		KernelDesc Desc;
+		Desc.Name = std::string("Scan.") + ModeNames[static_cast<uint32_t>(Mode)] + (bExclusive ? ".Exclusive" : ".Inclusive") +
+					(bSegmented ? ".Segmented" : "");
+		Desc.SpirvPath = "shaders/scan.spv";
+		for (uint32_t Binding = 0; Binding < 4; ++Binding)
+		{
+			Desc.Bindings.emplace_back(Binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		}
+		// DispatchParams, NumElements, NumTiles
+		Desc.PushConstantSize = sizeof(DispatchParams) + 2 * sizeof(uint32_t);
+		Desc.SpecConstants = { {1, static_cast<uint32_t>(Mode)}, {2, bExclusive ? 1u : 0u}, {3, bSegmented ? 1u : 0u},
+							   {4, ScanItemsPerThread} };
+		Desc.DefaultGroupSize = 256;
+		return Desc;
+	}
+
+	KernelDesc radixSort(RadixSortMode Mode, uint32_t KeyWords, bool bValues, uint32_t SubgroupSlots)
+	{
+		static const char* const ModeNames[] = { "Histogram", "Upsweep", "ScatterLookBack", "ScatterScanned" };
+		KernelDesc Desc;
+		Desc.Name = std::string("RadixSort.") + ModeNames[static_cast<uint32_t>(Mode)] + (KeyWords == 2 ? ".u64" : ".u32") +
+					(bValues ? ".Pairs" : "") + "." + std::to_string(SubgroupSlots);
+		Desc.SpirvPath = "shaders/radix_sort.spv";
+		for (uint32_t Binding = 0; Binding < 6; ++Binding)
+		{
+			Desc.Bindings.emplace_back(Binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		}
+		// DispatchParams, NumKeys, NumTiles, Pass
+		Desc.PushConstantSize = sizeof(DispatchParams) + 3 * sizeof(uint32_t);
+		Desc.SpecConstants = { {1, static_cast<uint32_t>(Mode)}, {2, KeyWords}, {3, bValues ? 1u : 0u},
+							   {4, RadixItemsPerThread}, {5, SubgroupSlots} };
+		Desc.DefaultGroupSize = 256;
+		return Desc;
+	}
+
+	KernelDesc segmentedSort(ElementType KeyType, bool bValues, uint32_t Capacity, uint32_t Threads)
+	{
+		static const char* const TypeNames[] = { "u32", "i32", "f32" };
+		KernelDesc Desc;
+		Desc.Name = std::string("SegmentedSort.") + TypeNames[static_cast<uint32_t>(KeyType)] + (bValues ? ".Pairs." : ".") +
+					std::to_string(Capacity) + "." + std::to_string(Threads);
+		Desc.SpirvPath = "shaders/segmented_sort.spv";
+		for (uint32_t Binding = 0; Binding < 5; ++Binding)
+		{
+			Desc.Bindings.emplace_back(Binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		}
+		// NumSegments
+		Desc.PushConstantSize = sizeof(uint32_t);
+		// One workgroup per segment sized for the shared capacity, the size is not tuned
+		Desc.SpecConstants = { {0, Threads}, {1, static_cast<uint32_t>(KeyType)}, {2, bValues ? 1u : 0u}, {3, Capacity},
+							   {4, bValues ? Capacity : 1u} };
+		return Desc;
+	}
+
+	KernelDesc merge(ElementType KeyType, bool bValues)
+	{
+		static const char* const TypeNames[] = { "u32", "i32", "f32" };
+		KernelDesc Desc;
+		Desc.Name = std::string("Merge.") + TypeNames[static_cast<uint32_t>(KeyType)] + (bValues ? ".Pairs" : "");
+		Desc.SpirvPath = "shaders/merge.spv";
+		for (uint32_t Binding = 0; Binding < 6; ++Binding)
+		{
+			Desc.Bindings.emplace_back(Binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		}
+		// DispatchParams, NumA, NumB
+		Desc.PushConstantSize = sizeof(DispatchParams) + 2 * sizeof(uint32_t);
+		Desc.SpecConstants = { {1, static_cast<uint32_t>(KeyType)}, {2, bValues ? 1u : 0u}, {3, MergeItemsPerThread} };
+		Desc.DefaultGroupSize = 256;
+		return Desc;
+	}
+
+	KernelDesc transpose(uint32_t ElementWords, uint32_t Tile, uint32_t Threads)
+	{
+		KernelDesc Desc;
+		Desc.Name = "Transpose." + std::to_string(ElementWords * sizeof(uint32_t)) + "B." + std::to_string(Tile) + "." + std::to_string(Threads);
+		Desc.SpirvPath = "shaders/transpose.spv";
+		for (uint32_t Binding = 0; Binding < 2; ++Binding)
+		{
+			Desc.Bindings.emplace_back(Binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		}
+		// Rows, Cols
+		Desc.PushConstantSize = 2 * sizeof(uint32_t);
+		// One workgroup per tile, the size is not tuned
+		Desc.SpecConstants = { {0, Threads}, {1, ElementWords}, {2, Tile} };
+		return Desc;
+	}
+
+	KernelDesc layoutConvert(bool bAosToSoa, uint32_t StrideWords, uint32_t TileRecords, uint32_t Threads)
+	{
+		KernelDesc Desc;
+		Desc.Name = std::string(bAosToSoa ? "AosToSoa." : "SoaToAos.") + std::to_string(StrideWords) + "." + std::to_string(TileRecords) + "." +
+					std::to_string(Threads);
+		Desc.SpirvPath = "shaders/layout_convert.spv";
+		for (uint32_t Binding = 0; Binding < 3; ++Binding)
+		{
+			Desc.Bindings.emplace_back(Binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		}
+		// NumRecords, NumFields
+		Desc.PushConstantSize = 2 * sizeof(uint32_t);
+		// Odd record pitch in shared memory, so that a field of consecutive records spreads over the banks
+		Desc.SpecConstants = { {0, Threads}, {1, bAosToSoa ? 1u : 0u}, {2, StrideWords}, {3, StrideWords | 1u}, {4, TileRecords} };
+		return Desc;
+	}
+
+	KernelDesc topK(TopKMode Mode, ElementType Type, bool bLargest, bool bSortKeys)
+	{
+		static const char* const ModeNames[] = { "Histogram", "Select", "Compact", "Restore" };
+		static const char* const TypeNames[] = { "u32", "i32", "f32" };
+		KernelDesc Desc;
+		Desc.Name = std::string("TopK.") + ModeNames[static_cast<uint32_t>(Mode)] + "." + TypeNames[static_cast<uint32_t>(Type)] +
+					(bLargest ? ".Largest" : ".Smallest") + (bSortKeys ? ".SortKeys" : "");
+		Desc.SpirvPath = "shaders/top_k.spv";
+		for (uint32_t Binding = 0; Binding < 4; ++Binding)
+		{
+			Desc.Bindings.emplace_back(Binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		}
+		// DispatchParams, NumElements, FirstIndex, Pass, K
+		Desc.PushConstantSize = sizeof(DispatchParams) + 4 * sizeof(uint32_t);
+		Desc.SpecConstants = { {1, static_cast<uint32_t>(Type)}, {2, static_cast<uint32_t>(Mode)}, {3, bLargest ? 1u : 0u},
+							   {4, bSortKeys ? 1u : 0u}, {5, TopKItemsPerThread} };
+		Desc.DefaultGroupSize = 256;
+		return Desc;
+	}
+
+	KernelDesc hashTable(HashTableMode Mode, HashKeyType KeyType, bool bUnique, bool bValues)
+	{
+		static const char* const ModeNames[] = { "Insert", "Find", "Erase", "Retrieve", "JoinCount", "JoinWrite" };
+		static const char* const TypeNames[] = { "u32", "u64" };
+		const char* TypeName = TypeNames[static_cast<uint32_t>(KeyType)];
+		KernelDesc Desc;
+		Desc.Name = std::string("HashTable.") + ModeNames[static_cast<uint32_t>(Mode)] + "." + TypeName + (bUnique ? ".Unique" : ".Multi") +
+					(bValues ? ".Values" : "");
+		Desc.SpirvPath = std::string("shaders/hash_table_") + TypeName + ".spv";
+		for (uint32_t Binding = 0; Binding < 7; ++Binding)
+		{
+			Desc.Bindings.emplace_back(Binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		}
+		// DispatchParams, NumKeys, NumSlots, OutputCapacity
+		Desc.PushConstantSize = sizeof(DispatchParams) + 3 * sizeof(uint32_t);
+		Desc.SpecConstants = { {1, static_cast<uint32_t>(Mode)}, {2, bUnique ? 1u : 0u}, {3, bValues ? 1u : 0u} };
+		Desc.DefaultGroupSize = 256;
+		return Desc;
+	}
+
+	KernelDesc groupBy(GroupByMode Mode, const std::vector<AggregateOp>& Ops, const std::vector<ElementType>& Types, uint32_t SharedSlots)
+	{
+		static const char* const OpNames[] = { "Sum", "Count", "Min", "Max", "Avg" };
+		static const char* const TypeNames[] = { "u32", "i32", "f32" };
+		KernelDesc Desc;
+		Desc.Name = std::string("GroupBy.") + (Mode == GroupByMode::Aggregate ? "Aggregate" : "Output") +
+					(SharedSlots != 0 ? ".Shared." + std::to_string(SharedSlots) : std::string(".Global"));
+		uint32_t ColumnOps = 0;
+		uint32_t ColumnTypes = 0;
+		for (size_t Column = 0; Column < Ops.size(); ++Column)
+		{
+			Desc.Name += std::string(".") + OpNames[static_cast<uint32_t>(Ops[Column])] + "-" + TypeNames[static_cast<uint32_t>(Types[Column])];
+			ColumnOps |= static_cast<uint32_t>(Ops[Column]) << (3 * Column);
+			ColumnTypes |= static_cast<uint32_t>(Types[Column]) << (2 * Column);
+		}
+		Desc.SpirvPath = "shaders/group_by.spv";
+		for (uint32_t Binding = 0; Binding < 5; ++Binding)
+		{
+			Desc.Bindings.emplace_back(Binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		}
+		Desc.Bindings.emplace_back(5, vk::DescriptorType::eStorageBuffer, GroupByMaxColumns, vk::ShaderStageFlagBits::eCompute);
+		// DispatchParams, NumRows, NumSlots, MaxGroups
+		Desc.PushConstantSize = sizeof(DispatchParams) + 3 * sizeof(uint32_t);
+		// Without shared groups the arrays shrink to one word
+		const uint32_t Slots = std::max(SharedSlots, 1u);
+		Desc.SpecConstants = { {1, static_cast<uint32_t>(Mode)}, {2, SharedSlots != 0 ? 1u : 0u},
+							   {3, static_cast<uint32_t>(Ops.size())}, {4, ColumnOps}, {5, ColumnTypes}, {6, Slots},
+							   {7, Slots * (1 + static_cast<uint32_t>(Ops.size()))} };
+		Desc.DefaultGroupSize = 256;
+		return Desc;
+	}
+
+	KernelDesc histogram(HistogramType Type, bool bPrivatized, uint32_t SharedBins)
+	{
+		static const char* const TypeNames[] = { "u32", "i32", "f32" };
+		KernelDesc Desc;
+		Desc.Name = std::string("Histogram.") + TypeNames[static_cast<uint32_t>(Type)] +
+					(bPrivatized ? ".Shared." + std::to_string(SharedBins) : std::string(".Global"));
+		Desc.SpirvPath = "shaders/histogram.spv";
+		Desc.Bindings = {
+			{0, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute},
+			{1, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute}
+		};
+		// DispatchParams, NumElements, BinCount, Min, Max, BinWidth
+		Desc.PushConstantSize = sizeof(DispatchParams) + 5 * sizeof(uint32_t);
+		Desc.SpecConstants = { {1, static_cast<uint32_t>(Type)}, {2, bPrivatized ? 1u : 0u}, {3, bPrivatized ? SharedBins : 1u} };
+		Desc.DefaultGroupSize = 256;
+		return Desc;
+	}
+
+	KernelDesc compact(CompactMode Mode, CompactPredicate Predicate, CompareOp Compare, ElementType Type, uint32_t SubgroupSlots,
+					   bool bCountFromArgs)
+	{
+		static const char* const ModeNames[] = { "Unordered", "CountTiles", "ScatterScanned" };
+		static const char* const PredicateNames[] = { "Compare", "Range", "NonZero", "Bitmask" };
+		static const char* const CompareNames[] = { "Equal", "NotEqual", "Less", "LessEqual", "Greater", "GreaterEqual" };
+		static const char* const TypeNames[] = { "u32", "i32", "f32" };
+		KernelDesc Desc;
+		Desc.Name = std::string("Compact.") + ModeNames[static_cast<uint32_t>(Mode)] + "." + PredicateNames[static_cast<uint32_t>(Predicate)] +
+					(Predicate == CompactPredicate::Compare ? std::string(".") + CompareNames[static_cast<uint32_t>(Compare)] : std::string()) +
+					"." + TypeNames[static_cast<uint32_t>(Type)] + "." + std::to_string(SubgroupSlots) + (bCountFromArgs ? ".Indirect" : "");
+		Desc.SpirvPath = "shaders/compact.spv";
+		for (uint32_t Binding = 0; Binding < 5; ++Binding)
+		{
+			Desc.Bindings.emplace_back(Binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		}
+		// DispatchParams, NumElements, NumTiles, A, B, ElementsPerGroup
+		Desc.PushConstantSize = sizeof(DispatchParams) + 5 * sizeof(uint32_t);
+		Desc.SpecConstants = { {1, static_cast<uint32_t>(Mode)}, {2, static_cast<uint32_t>(Predicate)}, {3, static_cast<uint32_t>(Compare)},
+							   {4, static_cast<uint32_t>(Type)}, {5, CompactItemsPerThread}, {6, SubgroupSlots}, {7, bCountFromArgs ? 1u : 0u} };
+		Desc.DefaultGroupSize = 256;
+		return Desc;
+	}
+
+	KernelDesc gemm(const GemmTile& Tile, bool bTransposeA, bool bTransposeB, bool bHalf)
+	{
+		KernelDesc Desc;
+		Desc.Name = std::string(bHalf ? "Hgemm." : "Sgemm.") + (bTransposeA ? "T" : "N") + (bTransposeB ? "T" : "N") + "." +
+					std::to_string(Tile.M) + "x" + std::to_string(Tile.N) + "x" + std::to_string(Tile.K) + "." +
+					std::to_string(Tile.ThreadM) + "x" + std::to_string(Tile.ThreadN);
+		Desc.SpirvPath = "shaders/gemm.spv";
+		for (uint32_t Binding = 0; Binding < 3; ++Binding)
+		{
+			Desc.Bindings.emplace_back(Binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		}
+		// M, N, K, LdA, LdB, LdC, Alpha, Beta
+		Desc.PushConstantSize = 8 * sizeof(uint32_t);
+		// The workgroup size follows the tile, so it is a plain spec constant and not tuned
+		Desc.SpecConstants = { {0, Tile.getThreads()}, {1, Tile.M}, {2, Tile.N}, {3, Tile.K}, {4, Tile.ThreadM}, {5, Tile.ThreadN},
+							   {6, bTransposeA ? 1u : 0u}, {7, bTransposeB ? 1u : 0u}, {8, bHalf ? 1u : 0u} };
+		return Desc;
+	}
+
+	KernelDesc spmv(SpmvMode Mode)
+	{
+		static const char* const ModeNames[] = { "CsrScalar", "CsrVector", "Sell" };
+		KernelDesc Desc;
+		Desc.Name = std::string("Spmv.") + ModeNames[static_cast<uint32_t>(Mode)];
+		Desc.SpirvPath = "shaders/spmv.spv";
+		for (uint32_t Binding = 0; Binding < 6; ++Binding)
+		{
+			Desc.Bindings.emplace_back(Binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		}
+		// DispatchParams, Rows, SliceHeight
+		Desc.PushConstantSize = sizeof(DispatchParams) + 2 * sizeof(uint32_t);
+		Desc.SpecConstants = { {1, static_cast<uint32_t>(Mode)} };
+		Desc.DefaultGroupSize = 256;
+		return Desc;
+	}
+
+	KernelDesc sellConvert(SellConvertMode Mode)
+	{
+		static const char* const ModeNames[] = { "Keys", "Widths", "Fill" };
+		KernelDesc Desc;
+		Desc.Name = std::string("SellConvert.") + ModeNames[static_cast<uint32_t>(Mode)];
+		Desc.SpirvPath = "shaders/sell_convert.spv";
+		for (uint32_t Binding = 0; Binding < 8; ++Binding)
+		{
+			Desc.Bindings.emplace_back(Binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		}
+		// DispatchParams, Rows, Sigma, SliceHeight, NumSlices
+		Desc.PushConstantSize = sizeof(DispatchParams) + 4 * sizeof(uint32_t);
+		Desc.SpecConstants = { {1, static_cast<uint32_t>(Mode)} };
+		Desc.DefaultGroupSize = 256;
+		return Desc;
+	}
+
+	uint32_t getStencilCoefficientCount(uint32_t Dims, StencilShape Shape, uint32_t Radius)
+	{
+		if (Shape == StencilShape::Star)
+		{
+			return 1 + 2 * Dims * Radius;
+		}
+		uint32_t Count = 1;
+		for (uint32_t Axis = 0; Axis < Dims; ++Axis)
+		{
+			Count *= 2 * Radius + 1;
+		}
+		return Count;
+	}
+
+	KernelDesc stencil(uint32_t Dims, StencilShape Shape, uint32_t Radius, StencilBoundary Boundary, const StencilTile& Tile, uint32_t Threads)
+	{
+		static const char* const ShapeNames[] = { "Star", "Box" };
+		static const char* const BoundaryNames[] = { "Clamp", "Wrap", "Constant" };
+		KernelDesc Desc;
+		Desc.Name = "Stencil" + std::to_string(Dims) + "D." + ShapeNames[static_cast<uint32_t>(Shape)] + std::to_string(Radius) + "." +
+					BoundaryNames[static_cast<uint32_t>(Boundary)] + "." + std::to_string(Tile.X) + "x" + std::to_string(Tile.Y) + "x" +
+					std::to_string(Tile.Z) + ".T" + std::to_string(Tile.TemporalSteps) + "." + std::to_string(Threads);
+		Desc.SpirvPath = "shaders/stencil.spv";
+		for (uint32_t Binding = 0; Binding < 3; ++Binding)
+		{
+			Desc.Bindings.emplace_back(Binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		}
+		// SizeX, SizeY, SizeZ, Steps, BoundaryValue
+		Desc.PushConstantSize = 5 * sizeof(uint32_t);
+		// One workgroup per tile, the size is not tuned
+		Desc.SpecConstants = { {0, Threads}, {1, Dims}, {2, static_cast<uint32_t>(Shape)}, {3, Radius}, {4, static_cast<uint32_t>(Boundary)},
+							   {5, Tile.X}, {6, Tile.Y}, {7, Tile.Z}, {8, Tile.TemporalSteps} };
+		return Desc;
+	}
+
+	KernelDesc fftShared(uint32_t N, uint32_t Signals, bool bInverse, uint32_t Threads)
+	{
+		KernelDesc Desc;
+		Desc.Name = std::string("FftShared.") + (bInverse ? "Inverse." : "Forward.") + std::to_string(N) + "x" + std::to_string(Signals) + "." +
+					std::to_string(Threads);
+		Desc.SpirvPath = "shaders/fft_shared.spv";
+		for (uint32_t Binding = 0; Binding < 2; ++Binding)
+		{
+			Desc.Bindings.emplace_back(Binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		}
+		// NumSignals, ElementStride, InnerCount, InnerStride, OuterStride, Scale
+		Desc.PushConstantSize = 6 * sizeof(uint32_t);
+		// The shared arrays follow N, so the workgroup size is fixed per kernel
+		Desc.SpecConstants = { {0, Threads}, {1, bInverse ? 1u : 0u}, {2, N}, {3, Signals} };
+		return Desc;
+	}
+
+	KernelDesc fftPass(bool bInverse)
+	{
+		KernelDesc Desc;
+		Desc.Name = std::string("FftPass.") + (bInverse ? "Inverse" : "Forward");
+		Desc.SpirvPath = "shaders/fft_pass.spv";
+		for (uint32_t Binding = 0; Binding < 3; ++Binding)
+		{
+			Desc.Bindings.emplace_back(Binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+		}
+		// DispatchParams, N, Radix, Ns, ElementStride, InnerCount, InnerStride, OuterStride, Scale
+		Desc.PushConstantSize = sizeof(DispatchParams) + 8 * sizeof(uint32_t);
+		Desc.SpecConstants = { {1, bInverse ? 1u : 0u} };
+		Desc.DefaultGroupSize = 256;
+		return Desc;
+	}
+
+	void setVec4ElementCount(ComputeJob& Job, uint32_t NumElements)
+	{
+		// The tail vector needs an invocation too, hence / 4 + 1
+		const uint64_t NumVectors = NumElements / 4 + (NumElements % 4 != 0 ? 1 : 0);
+		// At least one invocation, an ElementCount of 0 would dispatch Job.GroupCount unplanned
+		Job.ElementCount = std::max<uint64_t>((NumVectors + Vec4VectorsPerThread - 1) / Vec4VectorsPerThread, 1);
+		// Vectors are interleaved across the workgroup, so slices must not be bound as windows
+		Job.ElementSize = 0;
+		Job.PushConstants.resize(sizeof(uint32_t));
+		std::memcpy(Job.PushConstants.data(), &NumElements, sizeof(uint32_t));
+	}
+}
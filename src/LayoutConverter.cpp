@@ -0,0 +1,252 @@
+#include "LayoutConverter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "Kernels.h"
+
+namespace
+{
+	// Records one layout conversion workgroup aims for, fewer when they do not fit shared memory
+	constexpr uint32_t MaxTileRecords = 256;
+
+	template <typename T>
+	void setPushConstants(ComputeJob& Job, const T& Values)
+	{
+		Job.PushConstants.resize(sizeof(Values));
+		std::memcpy(Job.PushConstants.data(), &Values, sizeof(Values));
+	}
+
+	// Size in bytes of the fields when they are equally sized (4, 8 or 16 bytes) and fill the record
+	// in order, which makes the records a matrix with one field per column. 0 otherwise
+	uint32_t uniformFieldSize(const RecordLayout& Layout)
+	{
+		const uint32_t Size = Layout.Fields.front().Size;
+		if ((Size != 4 && Size != 8 && Size != 16) || Layout.Stride != Size * Layout.Fields.size())
+		{
+			return 0;
+		}
+		for (size_t Field = 0; Field < Layout.Fields.size(); ++Field)
+		{
+			if (Layout.Fields[Field].Size != Size || Layout.Fields[Field].Offset != Field * Size)
+			{
+				return 0;
+			}
+		}
+		return Size;
+	}
+}
+
+vk::DeviceSize RecordLayout::getSoaOffset(size_t Field, uint64_t NumRecords) const
+{
+	vk::DeviceSize Offset = 0;
+	for (size_t Before = 0; Before < Field; ++Before)
+	{
+		Offset += NumRecords * Fields[Before].Size;
+	}
+	return Offset;
+}
+
+vk::DeviceSize RecordLayout::getSoaSize(uint64_t NumRecords) const
+{
+	return getSoaOffset(Fields.size(), NumRecords);
+}
+
+LayoutConverter::LayoutConverter(ComputeContext& InContext)
+	: Context(InContext)
+{
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	Threads = std::min({ 256u, Limits.maxComputeWorkGroupInvocations, Limits.maxComputeWorkGroupSize[0] });
+}
+
+LayoutConverter::~LayoutConverter()
+{
+	Context.waitIdle();
+	for (auto& Entry : FieldTables)
+	{
+		Context.destroyBuffer(Entry.second);
+	}
+}
+
+uint32_t LayoutConverter::getMaxStride() const
+{
+	// The stride is padded to an odd word count in shared memory
+	const uint32_t SharedWords = Context.getDeviceProperties().limits.maxComputeSharedMemorySize / sizeof(uint32_t);
+	return (SharedWords % 2 == 0 ? SharedWords - 1 : SharedWords) * sizeof(uint32_t);
+}
+
+uint32_t LayoutConverter::getTransposeTile(uint32_t ElementWords) const
+{
+	const uint32_t SharedSize = Context.getDeviceProperties().limits.maxComputeSharedMemorySize;
+	uint32_t Tile = 32;
+	while (Tile > 8 && ElementWords * Tile * (Tile + 1) * sizeof(uint32_t) > SharedSize)
+	{
+		Tile /= 2;
+	}
+	return Tile;
+}
+
+void LayoutConverter::transpose(const ComputeBuffer& In, const ComputeBuffer& Out, uint32_t Rows, uint32_t Cols, uint32_t ElementSize,
+								uint32_t Batch)
+{
+	transposeAsync(In, Out, Rows, Cols, ElementSize, Batch).wait();
+}
+
+JobTicket LayoutConverter::transposeAsync(const ComputeBuffer& In, const ComputeBuffer& Out, uint32_t Rows, uint32_t Cols,
+										  uint32_t ElementSize, uint32_t Batch, const std::vector<JobTicket>& Dependencies)
+{
+	if (ElementSize != 4 && ElementSize != 8 && ElementSize != 16)
+	{
+		throw std::invalid_argument("transposes take 4, 8 or 16 byte elements");
+	}
+	if (Rows == 0 || Cols == 0 || Batch == 0)
+	{
+		throw std::invalid_argument("transposes take non-empty matrices");
+	}
+	const vk::DeviceSize Size = vk::DeviceSize(Rows) * Cols * Batch * ElementSize;
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	if (Size > Limits.maxStorageBufferRange)
+	{
+		throw std::invalid_argument("transposed matrices exceed maxStorageBufferRange");
+	}
+	if (In.Size < Size || Out.Size < Size)
+	{
+		throw std::invalid_argument("transpose buffers are smaller than their matrices");
+	}
+	const uint32_t ElementWords = ElementSize / sizeof(uint32_t);
+	const uint32_t Tile = getTransposeTile(ElementWords);
+	const uint32_t GroupsX = (Cols + Tile - 1) / Tile;
+	const uint32_t GroupsY = (Rows + Tile - 1) / Tile;
+	if (GroupsX > Limits.maxComputeWorkGroupCount[0] || GroupsY > Limits.maxComputeWorkGroupCount[1] ||
+		Batch > Limits.maxComputeWorkGroupCount[2])
+	{
+		throw std::invalid_argument("transpose tiles exceed maxComputeWorkGroupCount");
+	}
+
+	ComputeJob Job;
+	Job.Kernel = &Context.createKernel(kernels::transpose(ElementWords, Tile, Threads / Tile * Tile));
+	Job.Buffers = { &In, &Out };
+	Job.GroupCount = { GroupsX, GroupsY, Batch };
+	const uint32_t PushConstants[] = { Rows, Cols };
+	setPushConstants(Job, PushConstants);
+	return Context.submitAsync(Job, Dependencies);
+}
+
+const ComputeBuffer& LayoutConverter::getFieldTable(const RecordLayout& Layout)
+{
+	const uint32_t StrideWords = Layout.Stride / sizeof(uint32_t);
+	const uint32_t NumFields = static_cast<uint32_t>(Layout.Fields.size());
+	std::vector<uint32_t> Table(NumFields * 3 + StrideWords, ~0u);
+	uint32_t ArrayStart = 0;
+	for (uint32_t Field = 0; Field < NumFields; ++Field)
+	{
+		const uint32_t Offset = Layout.Fields[Field].Offset / sizeof(uint32_t);
+		const uint32_t Words = Layout.Fields[Field].Size / sizeof(uint32_t);
+		Table[Field * 3] = Offset;
+		Table[Field * 3 + 1] = Words;
+		Table[Field * 3 + 2] = ArrayStart;
+		ArrayStart += Words;
+		for (uint32_t Word = Offset; Word < Offset + Words; ++Word)
+		{
+			if (Table[NumFields * 3 + Word] != ~0u)
+			{
+				throw std::invalid_argument("record fields overlap");
+			}
+			Table[NumFields * 3 + Word] = Field;
+		}
+	}
+
+	const auto Found = FieldTables.find(Table);
+	if (Found != FieldTables.end())
+	{
+		return Found->second;
+	}
+	ComputeBuffer Buffer = Context.createBuffer(Table.size() * sizeof(uint32_t));
+	Context.writeBuffer(Buffer, Table.data(), Table.size() * sizeof(uint32_t));
+	return FieldTables.emplace(std::move(Table), Buffer).first->second;
+}
+
+void LayoutConverter::aosToSoa(const ComputeBuffer& Aos, const ComputeBuffer& Soa, uint64_t NumRecords, const RecordLayout& Layout)
+{
+	aosToSoaAsync(Aos, Soa, NumRecords, Layout).wait();
+}
+
+JobTicket LayoutConverter::aosToSoaAsync(const ComputeBuffer& Aos, const ComputeBuffer& Soa, uint64_t NumRecords, const RecordLayout& Layout,
+										 const std::vector<JobTicket>& Dependencies)
+{
+	return convert(true, Aos, Soa, NumRecords, Layout, Dependencies);
+}
+
+void LayoutConverter::soaToAos(const ComputeBuffer& Soa, const ComputeBuffer& Aos, uint64_t NumRecords, const RecordLayout& Layout)
+{
+	soaToAosAsync(Soa, Aos, NumRecords, Layout).wait();
+}
+
+JobTicket LayoutConverter::soaToAosAsync(const ComputeBuffer& Soa, const ComputeBuffer& Aos, uint64_t NumRecords, const RecordLayout& Layout,
+										 const std::vector<JobTicket>& Dependencies)
+{
+	return convert(false, Soa, Aos, NumRecords, Layout, Dependencies);
+}
+
+JobTicket LayoutConverter::convert(bool bAosToSoa, const ComputeBuffer& In, const ComputeBuffer& Out, uint64_t NumRecords,
+								   const RecordLayout& Layout, const std::vector<JobTicket>& Dependencies)
+{
+	if (NumRecords == 0 || NumRecords > UINT32_MAX || Layout.Fields.empty())
+	{
+		throw std::invalid_argument("layout conversions take 1 to 2^32 - 1 records with at least one field");
+	}
+	if (Layout.Stride == 0 || Layout.Stride % sizeof(uint32_t) != 0 || Layout.Stride > getMaxStride())
+	{
+		throw std::invalid_argument("record strides are non-zero multiples of 4 up to getMaxStride()");
+	}
+	for (const RecordField& Field : Layout.Fields)
+	{
+		if (Field.Size == 0 || Field.Offset % sizeof(uint32_t) != 0 || Field.Size % sizeof(uint32_t) != 0 ||
+			uint64_t(Field.Offset) + Field.Size > Layout.Stride)
+		{
+			throw std::invalid_argument("record fields are non-empty, 4 byte aligned and inside the record");
+		}
+	}
+	const vk::DeviceSize AosSize = NumRecords * Layout.Stride;
+	const vk::DeviceSize SoaSize = Layout.getSoaSize(NumRecords);
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	if (AosSize > Limits.maxStorageBufferRange)
+	{
+		throw std::invalid_argument("records exceed maxStorageBufferRange");
+	}
+	if (In.Size < (bAosToSoa ? AosSize : SoaSize) || Out.Size < (bAosToSoa ? SoaSize : AosSize))
+	{
+		throw std::invalid_argument("layout conversion buffers are smaller than their records");
+	}
+
+	// Equally sized fields filling the record: the records are a NumRecords x Fields matrix
+	const uint32_t FieldSize = uniformFieldSize(Layout);
+	if (FieldSize != 0)
+	{
+		const uint32_t Tile = getTransposeTile(FieldSize / sizeof(uint32_t));
+		const uint32_t NumFields = static_cast<uint32_t>(Layout.Fields.size());
+		const uint32_t Records = static_cast<uint32_t>(NumRecords);
+		const uint32_t RecordGroups = (Records + Tile - 1) / Tile;
+		// Tall matrices may need more tile rows than a dispatch has, the generic path folds its grid
+		if (RecordGroups <= (bAosToSoa ? Limits.maxComputeWorkGroupCount[1] : Limits.maxComputeWorkGroupCount[0]))
+		{
+			return bAosToSoa ? transposeAsync(In, Out, Records, NumFields, FieldSize, 1, Dependencies)
+							 : transposeAsync(In, Out, NumFields, Records, FieldSize, 1, Dependencies);
+		}
+	}
+
+	const uint32_t StrideWords = Layout.Stride / sizeof(uint32_t);
+	const uint32_t SharedWords = Limits.maxComputeSharedMemorySize / sizeof(uint32_t);
+	const uint32_t TileRecords = std::min(MaxTileRecords, SharedWords / (StrideWords | 1u));
+	const uint32_t NumGroups = static_cast<uint32_t>((NumRecords + TileRecords - 1) / TileRecords);
+	const uint32_t MaxGroupsX = Limits.maxComputeWorkGroupCount[0];
+	const ComputeBuffer& FieldTable = getFieldTable(Layout);
+	ComputeJob Job;
+	Job.Kernel = &Context.createKernel(kernels::layoutConvert(bAosToSoa, StrideWords, TileRecords, Threads));
+	Job.Buffers = { &In, &Out, &FieldTable };
+	Job.GroupCount = { std::min(NumGroups, MaxGroupsX), (NumGroups + MaxGroupsX - 1) / MaxGroupsX, 1 };
+	const uint32_t PushConstants[] = { static_cast<uint32_t>(NumRecords), static_cast<uint32_t>(Layout.Fields.size()) };
+	setPushConstants(Job, PushConstants);
+	return Context.submitAsync(Job, Dependencies);
+}
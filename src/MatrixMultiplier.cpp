@@ -0,0 +1,138 @@
+#include "MatrixMultiplier.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	// From 8x8 register blocks of 256 invocations for desktop GPUs down to 64 invocations with little
+	// shared memory for mobile GPUs and lavapipe
+	const kernels::GemmTile CandidateTiles[] = {
+		{ 128, 128, 8, 8, 8 },
+		{ 64, 64, 16, 4, 4 },
+		{ 64, 32, 16, 4, 2 },
+		{ 32, 32, 16, 4, 4 },
+		{ 16, 16, 16, 2, 2 }
+	};
+	// Fewer workgroups than this leave a large GPU partly idle, a smaller tile is picked then
+	constexpr uint64_t MinGroups = 64;
+
+	// Elements a stored Rows x Cols matrix with leading dimension Ld spans
+	uint64_t spanOf(uint32_t Rows, uint32_t Cols, uint32_t Ld)
+	{
+		return Rows == 0 || Cols == 0 ? 0 : uint64_t(Rows - 1) * Ld + Cols;
+	}
+}
+
+MatrixMultiplier::MatrixMultiplier(ComputeContext& InContext)
+	: Context(InContext)
+{
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	for (const kernels::GemmTile& Tile : CandidateTiles)
+	{
+		if (Tile.getThreads() <= Limits.maxComputeWorkGroupInvocations && Tile.getThreads() <= Limits.maxComputeWorkGroupSize[0] &&
+			Tile.getSharedSize() <= Limits.maxComputeSharedMemorySize)
+		{
+			Tiles.push_back(Tile);
+		}
+	}
+	if (Tiles.empty())
+	{
+		throw std::runtime_error("no gemm tile fits the workgroup and shared memory limits");
+	}
+}
+
+const kernels::GemmTile& MatrixMultiplier::chooseTile(uint32_t M, uint32_t N) const
+{
+	for (const kernels::GemmTile& Tile : Tiles)
+	{
+		const uint64_t Groups = uint64_t((M + Tile.M - 1) / Tile.M) * ((N + Tile.N - 1) / Tile.N);
+		if (Groups >= MinGroups)
+		{
+			return Tile;
+		}
+	}
+	return Tiles.back();
+}
+
+void MatrixMultiplier::multiply(const ComputeBuffer& A, const ComputeBuffer& B, const ComputeBuffer& C, const GemmParams& Params)
+{
+	multiplyAsync(A, B, C, Params).wait();
+}
+
+JobTicket MatrixMultiplier::multiplyAsync(const ComputeBuffer& A, const ComputeBuffer& B, const ComputeBuffer& C, const GemmParams& Params,
+										  const std::vector<JobTicket>& Dependencies)
+{
+	if (Params.M == 0 || Params.N == 0 || Params.K == 0)
+	{
+		throw std::invalid_argument("gemm dimensions must not be zero");
+	}
+	// A column-major C is the row-major C^T = op(B)^T * op(A)^T, and a column-major operand is its
+	// row-major transpose, so swapping the operands keeps both transpose flags
+	const bool bColumnMajor = Params.Layout == MatrixLayout::ColumnMajor;
+	const ComputeBuffer& First = bColumnMajor ? B : A;
+	const ComputeBuffer& Second = bColumnMajor ? A : B;
+	const uint32_t M = bColumnMajor ? Params.N : Params.M;
+	const uint32_t N = bColumnMajor ? Params.M : Params.N;
+	const uint32_t K = Params.K;
+	const bool bTransposeFirst = bColumnMajor ? Params.bTransposeB : Params.bTransposeA;
+	const bool bTransposeSecond = bColumnMajor ? Params.bTransposeA : Params.bTransposeB;
+	const uint32_t LdFirst = bColumnMajor ? Params.LdB : Params.LdA;
+	const uint32_t LdSecond = bColumnMajor ? Params.LdA : Params.LdB;
+
+	// Stored shapes in the row-major frame: First is M x K (K x M transposed), Second K x N (N x K)
+	const uint32_t FirstRows = bTransposeFirst ? K : M;
+	const uint32_t FirstCols = bTransposeFirst ? M : K;
+	const uint32_t SecondRows = bTransposeSecond ? N : K;
+	const uint32_t SecondCols = bTransposeSecond ? K : N;
+	const uint32_t LdA = LdFirst != 0 ? LdFirst : FirstCols;
+	const uint32_t LdB = LdSecond != 0 ? LdSecond : SecondCols;
+	const uint32_t LdC = Params.LdC != 0 ? Params.LdC : N;
+	if (LdA < FirstCols || LdB < SecondCols || LdC < N)
+	{
+		throw std::invalid_argument("gemm leading dimensions are smaller than the stored rows");
+	}
+	const bool bHalf = Params.Precision == GemmPrecision::Float16;
+	const uint32_t InputSize = bHalf ? sizeof(uint16_t) : sizeof(float);
+	// Halves are read as whole uint words
+	auto bytesOf = [&](uint64_t Elements) { return (Elements * InputSize + 3) / 4 * 4; };
+	if (First.Size < bytesOf(spanOf(FirstRows, FirstCols, LdA)) || Second.Size < bytesOf(spanOf(SecondRows, SecondCols, LdB)) ||
+		C.Size < spanOf(M, N, LdC) * sizeof(float))
+	{
+		throw std::invalid_argument("gemm buffers are smaller than their matrices");
+	}
+
+	kernels::GemmTile Tile = Params.Tile;
+	if (Tile.M == 0)
+	{
+		Tile = chooseTile(M, N);
+	}
+	else if (Tile.ThreadM == 0 || Tile.ThreadN == 0 || Tile.M % Tile.ThreadM != 0 || Tile.N % Tile.ThreadN != 0 || Tile.K == 0)
+	{
+		throw std::invalid_argument("gemm tiles must be whole multiples of the register blocks");
+	}
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	if (Tile.getThreads() > Limits.maxComputeWorkGroupInvocations || Tile.getThreads() > Limits.maxComputeWorkGroupSize[0] ||
+		Tile.getSharedSize() > Limits.maxComputeSharedMemorySize)
+	{
+		throw std::runtime_error("gemm tile exceeds the workgroup or shared memory limits");
+	}
+	const uint32_t GroupsX = (N + Tile.N - 1) / Tile.N;
+	const uint32_t GroupsY = (M + Tile.M - 1) / Tile.M;
+	if (GroupsX > Limits.maxComputeWorkGroupCount[0] || GroupsY > Limits.maxComputeWorkGroupCount[1])
+	{
+		throw std::runtime_error("gemm result needs more workgroups than maxComputeWorkGroupCount");
+	}
+
+	ComputeJob Job;
+	Job.Kernel = &Context.createKernel(kernels::gemm(Tile, bTransposeFirst, bTransposeSecond, bHalf));
+	Job.Buffers = { &First, &Second, &C };
+	Job.GroupCount = { GroupsX, GroupsY, 1 };
+	const uint32_t Dims[] = { M, N, K, LdA, LdB, LdC };
+	const float Scales[] = { Params.Alpha, Params.Beta };
+	Job.PushConstants.resize(sizeof(Dims) + sizeof(Scales));
+	std::memcpy(Job.PushConstants.data(), Dims, sizeof(Dims));
+	std::memcpy(Job.PushConstants.data() + sizeof(Dims), Scales, sizeof(Scales));
+	return Context.submitAsync(Job, Dependencies);
+}
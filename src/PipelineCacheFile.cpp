@@ -0,0 +1,142 @@
+#include "PipelineCacheFile.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+
+namespace
+{
+	constexpr uint32_t FileMagic = 0x43505643; // "CVPC"
+	constexpr uint32_t FileFormatVersion = 1;
+
+	struct FileHeader
+	{
+		uint32_t Magic;
+		uint32_t FormatVersion;
+		uint32_t VendorID;
+		uint32_t DeviceID;
+		uint32_t DriverVersion;
+		uint32_t Reserved;
+		uint8_t PipelineCacheUUID[VK_UUID_SIZE];
+		uint64_t DataSize;
+		uint64_t Checksum;
+	};
+
+	// FNV-1a, enough to catch truncated or partially overwritten files
+	uint64_t checksum(const std::vector<uint8_t>& Data)
+	{
+		uint64_t Hash = 14695981039346656037ull;
+		for (uint8_t Byte : Data)
+		{
+			Hash = (Hash ^ Byte) * 1099511628211ull;
+		}
+		return Hash;
+	}
+}
+
+PipelineCacheFile::PipelineCacheFile(const std::string& Directory, const vk::PhysicalDeviceProperties& DeviceProps)
+	: VendorID(DeviceProps.vendorID)
+	, DeviceID(DeviceProps.deviceID)
+	, DriverVersion(DeviceProps.driverVersion)
+{
+	std::copy(DeviceProps.pipelineCacheUUID.begin(), DeviceProps.pipelineCacheUUID.end(), PipelineCacheUUID.begin());
+
+	std::ostringstream FileName;
+	FileName << std::hex << "pipelines_" << VendorID << "_" << DeviceID << "_" << DriverVersion << "_";
+	for (uint8_t Byte : PipelineCacheUUID)
+	{
+		FileName << std::setw(2) << std::setfill('0') << uint32_t(Byte);
+	}
+	FileName << ".bin";
+	FilePath = (std::filesystem::path(Directory) / FileName.str()).string();
+}
+
+bool PipelineCacheFile::isValidBlob(const std::vector<uint8_t>& Data) const
+{
+	// VkPipelineCacheHeaderVersionOne, written by the driver at the start of every blob
+	if (Data.size() < 16 + VK_UUID_SIZE)
+	{
+		return false;
+	}
+	uint32_t Fields[4];
+	std::memcpy(Fields, Data.data(), sizeof(Fields));
+	const uint32_t HeaderSize = Fields[0];
+	const uint32_t HeaderVersion = Fields[1];
+	return HeaderSize >= 16 + VK_UUID_SIZE && HeaderSize <= Data.size() &&
+		HeaderVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		Fields[2] == VendorID && Fields[3] == DeviceID &&
+		std::memcmp(Data.data() + 16, PipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+}
+
+std::vector<uint8_t> PipelineCacheFile::load() const
+{
+	std::ifstream CacheFile{ FilePath, std::ios::binary };
+	FileHeader Header;
+	if (!CacheFile.read(reinterpret_cast<char*>(&Header), sizeof(Header)))
+	{
+		return {};
+	}
+	if (Header.Magic != FileMagic || Header.FormatVersion != FileFormatVersion ||
+		Header.VendorID != VendorID || Header.DeviceID != DeviceID || Header.DriverVersion != DriverVersion ||
+		std::memcmp(Header.PipelineCacheUUID, PipelineCacheUUID.data(), VK_UUID_SIZE) != 0 ||
+		Header.DataSize == 0 || Header.DataSize > (uint64_t(1) << 31))
+	{
+		return {};
+	}
+
+	std::vector<uint8_t> Data(static_cast<size_t>(Header.DataSize));
+	if (!CacheFile.read(reinterpret_cast<char*>(Data.data()), Data.size()) ||
+		checksum(Data) != Header.Checksum || !isValidBlob(Data))
+	{
+		return {};
+	}
+	return Data;
+}
+
+bool PipelineCacheFile::save(const std::vector<uint8_t>& Data) const
+{
+	if (!isValidBlob(Data))
+	{
+		return false;
+	}
+
+	FileHeader Header = {};
+	Header.Magic = FileMagic;
+	Header.FormatVersion = FileFormatVersion;
+	Header.VendorID = VendorID;
+	Header.DeviceID = DeviceID;
+	Header.DriverVersion = DriverVersion;
+	std::memcpy(Header.PipelineCacheUUID, PipelineCacheUUID.data(), VK_UUID_SIZE);
+	Header.DataSize = Data.size();
+	Header.Checksum = checksum(Data);
+
+	const std::filesystem::path CachePath{ FilePath };
+	const std::filesystem::path TempPath{ FilePath + ".tmp" };
+	std::error_code Error;
+	if (CachePath.has_parent_path())
+	{
+		std::filesystem::create_directories(CachePath.parent_path(), Error);
+	}
+	{
+		std::ofstream TempFile{ TempPath, std::ios::binary | std::ios::trunc };
+		TempFile.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+		TempFile.write(reinterpret_cast<const char*>(Data.data()), Data.size());
+		TempFile.flush();
+		if (!TempFile)
+		{
+			TempFile.close();
+			std::filesystem::remove(TempPath, Error);
+			return false;
+		}
+	}
+	std::filesystem::rename(TempPath, CachePath, Error);
+	if (Error)
+	{
+		std::filesystem::remove(TempPath, Error);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,183 @@
+#include "RadixSorter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "Kernels.h"
+
+namespace
+{
+	constexpr uint32_t Radix = 256;
+	// Counts of the look-back share their word with two state bits
+	constexpr uint64_t MaxSinglePassKeys = (uint64_t(1) << 30) - 1;
+	// Smallest subgroup the driver may pick for a compute pipeline without subgroup size control
+	constexpr uint32_t MinSubgroupSize = 8;
+
+	void setRadixPushConstants(ComputeJob& Job, uint32_t NumKeys, uint32_t NumTiles, uint32_t Pass)
+	{
+		const uint32_t Values[] = { NumKeys, NumTiles, Pass };
+		Job.PushConstants.resize(sizeof(Values));
+		std::memcpy(Job.PushConstants.data(), Values, sizeof(Values));
+	}
+}
+
+RadixSorter::RadixSorter(ComputeContext& InContext)
+	: Context(InContext)
+	, Scan(InContext)
+{
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	const uint32_t SmallestSubgroup = std::max(std::min(Context.getSubgroupProperties().subgroupSize, MinSubgroupSize), 1u);
+	// Per subgroup digit counters, two 256 entry digit tables and the tile index
+	for (GroupSize = 256; GroupSize >= 128; GroupSize /= 2)
+	{
+		// At least 8 slots, the uint64 histograms reuse the counters
+		SubgroupSlots = std::max(GroupSize / SmallestSubgroup, 8u);
+		const uint32_t SharedSize = (SubgroupSlots * Radix + 2 * Radix + 1) * sizeof(uint32_t);
+		if (SharedSize <= Limits.maxComputeSharedMemorySize && GroupSize <= Limits.maxComputeWorkGroupInvocations &&
+			GroupSize <= Limits.maxComputeWorkGroupSize[0])
+		{
+			break;
+		}
+	}
+	// The digit scan in the shader needs at least Radix / 2 invocations
+	if (GroupSize < 128)
+	{
+		throw std::runtime_error("radix sort needs 128 invocations and their digit counters in shared memory");
+	}
+}
+
+RadixSorter::~RadixSorter()
+{
+	Context.waitIdle();
+	Context.destroyBuffer(KeysTemp);
+	Context.destroyBuffer(ValuesTemp);
+	Context.destroyBuffer(Histogram);
+	Context.destroyBuffer(Status);
+}
+
+bool RadixSorter::isSupported(const ComputeContext& Context)
+{
+	const vk::PhysicalDeviceSubgroupProperties& Subgroup = Context.getSubgroupProperties();
+	const vk::SubgroupFeatureFlags Needed = vk::SubgroupFeatureFlagBits::eBasic | vk::SubgroupFeatureFlagBits::eBallot;
+	// Ballots are 128 bits, the ranking needs the whole subgroup in one
+	return (Subgroup.supportedStages & vk::ShaderStageFlagBits::eCompute) && (Subgroup.supportedOperations & Needed) == Needed &&
+		Subgroup.subgroupSize <= 128;
+}
+
+void RadixSorter::ensureBuffer(ComputeBuffer& Buffer, vk::DeviceSize Size)
+{
+	if (Buffer.Size >= Size)
+	{
+		return;
+	}
+	if (LastJob.isValid())
+	{
+		LastJob.wait();
+	}
+	Context.destroyBuffer(Buffer);
+	Buffer = Context.createBuffer(Size);
+}
+
+void RadixSorter::sort(const ComputeBuffer& Keys, uint64_t NumKeys, RadixKeyType KeyType, const ComputeBuffer* Values, ScanAlgorithm Algorithm)
+{
+	sortAsync(Keys, NumKeys, KeyType, Values, Algorithm).wait();
+}
+
+JobTicket RadixSorter::sortAsync(const ComputeBuffer& Keys, uint64_t NumKeys, RadixKeyType KeyType, const ComputeBuffer* Values,
+								 ScanAlgorithm Algorithm, const std::vector<JobTicket>& Dependencies)
+{
+	const uint32_t KeyWords = KeyType == RadixKeyType::Uint64 ? 2 : 1;
+	if (NumKeys == 0 || NumKeys > UINT32_MAX)
+	{
+		throw std::invalid_argument("radix sort takes 1 to 2^32 - 1 keys");
+	}
+	if (Keys.Size < NumKeys * KeyWords * sizeof(uint32_t) || (Values && Values->Size < NumKeys * sizeof(uint32_t)))
+	{
+		throw std::invalid_argument("radix sort buffers are smaller than their keys");
+	}
+	if (!isSupported(Context))
+	{
+		throw std::runtime_error("radix sort needs subgroup ballots of at most 128 invocations in compute shaders");
+	}
+	if (Algorithm == ScanAlgorithm::Auto)
+	{
+		const bool bSinglePass = Scanner::hasForwardProgress(Context.getDeviceProperties()) && NumKeys <= MaxSinglePassKeys;
+		Algorithm = bSinglePass ? ScanAlgorithm::SinglePass : ScanAlgorithm::ReduceThenScan;
+	}
+	if (Algorithm == ScanAlgorithm::SinglePass && NumKeys > MaxSinglePassKeys)
+	{
+		throw std::invalid_argument("the single-pass radix sort takes at most 2^30 - 1 keys");
+	}
+	const bool bSinglePass = Algorithm == ScanAlgorithm::SinglePass;
+
+	const uint32_t TileSize = GroupSize * kernels::RadixItemsPerThread;
+	const uint32_t NumTiles = static_cast<uint32_t>((NumKeys + TileSize - 1) / TileSize);
+	const uint32_t NumPasses = 4 * KeyWords;
+	const vk::DeviceSize StatusWords = bSinglePass ? 1 + vk::DeviceSize(NumTiles) * Radix : vk::DeviceSize(NumTiles) * Radix;
+	ensureBuffer(KeysTemp, NumKeys * KeyWords * sizeof(uint32_t));
+	if (Values)
+	{
+		ensureBuffer(ValuesTemp, NumKeys * sizeof(uint32_t));
+	}
+	ensureBuffer(Histogram, 8 * Radix * sizeof(uint32_t));
+	ensureBuffer(Status, StatusWords * sizeof(uint32_t));
+
+	auto makeJob = [&](kernels::RadixSortMode Mode, uint32_t Pass, const ComputeBuffer& KeysIn, const ComputeBuffer& KeysOut,
+					   const ComputeBuffer* ValuesIn, const ComputeBuffer* ValuesOut)
+	{
+		ComputeJob Job;
+		Job.Kernel = &Context.createKernel(kernels::radixSort(Mode, KeyWords, Values != nullptr, SubgroupSlots));
+		Job.Buffers = { &KeysIn, &KeysOut, Values ? ValuesIn : &KeysIn, Values ? ValuesOut : &KeysOut, &Histogram, &Status };
+		Job.ElementCount = uint64_t(NumTiles) * GroupSize;
+		Job.GroupSize = GroupSize;
+		setRadixPushConstants(Job, static_cast<uint32_t>(NumKeys), NumTiles, Pass);
+		return Job;
+	};
+
+	// The first job waits for the caller's producers and for the previous sort, later ones chain on it
+	std::vector<JobTicket> Waits = Dependencies;
+	if (LastJob.isValid())
+	{
+		Waits.push_back(LastJob);
+	}
+	JobTicket Previous;
+	if (bSinglePass)
+	{
+		// Onesweep: the digit counts of every pass in one read of the keys
+		ComputeJob Job = makeJob(kernels::RadixSortMode::Histogram, 0, Keys, KeysTemp, Values, &ValuesTemp);
+		Job.Fills = { { &Histogram, 0, NumPasses * Radix * sizeof(uint32_t), 0 } };
+		Previous = Context.submitAsync(Job, Waits);
+	}
+	// Passes alternate between the caller's buffers and the temporaries, an even count ends in the caller's
+	for (uint32_t Pass = 0; Pass < NumPasses; ++Pass)
+	{
+		const bool bFromCaller = Pass % 2 == 0;
+		const ComputeBuffer& KeysIn = bFromCaller ? Keys : KeysTemp;
+		const ComputeBuffer& KeysOut = bFromCaller ? KeysTemp : Keys;
+		const ComputeBuffer* ValuesIn = bFromCaller ? Values : &ValuesTemp;
+		const ComputeBuffer* ValuesOut = bFromCaller ? &ValuesTemp : Values;
+		const std::vector<JobTicket> PassWaits = Previous.isValid() ? std::vector<JobTicket>{ Previous } : Waits;
+
+		if (bSinglePass)
+		{
+			ComputeJob Job = makeJob(kernels::RadixSortMode::ScatterLookBack, Pass, KeysIn, KeysOut, ValuesIn, ValuesOut);
+			// Tile counter and look-back states start at zero on every pass
+			Job.Fills = { { &Status, 0, StatusWords * sizeof(uint32_t), 0 } };
+			Previous = Context.submitAsync(Job, PassWaits);
+			continue;
+		}
+
+		// 回退路径: 每个 tile 的数位计数按数位优先排列, 排他前缀和直接得到每个 tile 的全局起点
+		const JobTicket Counted = Context.submitAsync(makeJob(kernels::RadixSortMode::Upsweep, Pass, KeysIn, KeysOut, ValuesIn, ValuesOut),
+													  PassWaits);
+		ScanOptions ScanOpts;
+		ScanOpts.bExclusive = true;
+		const JobTicket Scanned = Scan.scanAsync(Status, Status, StatusWords, ScanOpts, { Counted });
+		Previous = Context.submitAsync(makeJob(kernels::RadixSortMode::ScatterScanned, Pass, KeysIn, KeysOut, ValuesIn, ValuesOut),
+									   { Scanned });
+	}
+	LastJob = Previous;
+	return LastJob;
+}
@@ -0,0 +1,148 @@
+#include "Reducer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	// Partials one window reduces to. A single workgroup reduces the partials of every window in the
+	// final pass, so the cap keeps that to a few loads per invocation and window
+	constexpr uint32_t MaxGroupsPerWindow = 1024;
+
+	template <typename T>
+	struct ReduceTypeOf;
+	template <>
+	struct ReduceTypeOf<uint32_t> { static constexpr kernels::ReduceType Value = kernels::ReduceType::Uint32; };
+	template <>
+	struct ReduceTypeOf<int32_t> { static constexpr kernels::ReduceType Value = kernels::ReduceType::Int32; };
+	template <>
+	struct ReduceTypeOf<float> { static constexpr kernels::ReduceType Value = kernels::ReduceType::Float32; };
+	template <>
+	struct ReduceTypeOf<double> { static constexpr kernels::ReduceType Value = kernels::ReduceType::Float64; };
+
+	// Mirrors Partial in shaders/reduce.glsl, std430 pads it to the alignment of T
+	template <typename T>
+	struct Partial
+	{
+		T Value;
+		uint32_t Index;
+	};
+
+	void setReducePushConstants(ComputeJob& Job, uint32_t NumElements, uint32_t FirstIndex, uint32_t OutputOffset)
+	{
+		const uint32_t Values[] = { NumElements, FirstIndex, OutputOffset };
+		Job.PushConstants.resize(sizeof(Values));
+		std::memcpy(Job.PushConstants.data(), Values, sizeof(Values));
+	}
+}
+
+Reducer::Reducer(ComputeContext& InContext)
+	: Context(InContext)
+{
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	GroupSize = std::min({ 256u, Limits.maxComputeWorkGroupInvocations, Limits.maxComputeWorkGroupSize[0] });
+	ResultBuffer = Context.createBuffer(sizeof(Partial<double>));
+}
+
+Reducer::~Reducer()
+{
+	Context.waitIdle();
+	Context.destroyBuffer(Partials);
+	Context.destroyBuffer(ResultBuffer);
+}
+
+bool Reducer::isSupported(const ComputeContext& Context, kernels::ReduceType Type)
+{
+	const vk::PhysicalDeviceSubgroupProperties& Subgroup = Context.getSubgroupProperties();
+	const vk::SubgroupFeatureFlags Needed = vk::SubgroupFeatureFlagBits::eBasic | vk::SubgroupFeatureFlagBits::eArithmetic;
+	if (!(Subgroup.supportedStages & vk::ShaderStageFlagBits::eCompute) || (Subgroup.supportedOperations & Needed) != Needed)
+	{
+		return false;
+	}
+	return Type != kernels::ReduceType::Float64 || Context.getDeviceFeatures().shaderFloat64;
+}
+
+void Reducer::ensurePartials(vk::DeviceSize Size)
+{
+	if (Partials.Size >= Size)
+	{
+		return;
+	}
+	// Earlier reductions have completed, submit() waits for the final pass
+	Context.destroyBuffer(Partials);
+	Partials = Context.createBuffer(Size);
+}
+
+void Reducer::reduceRaw(const ComputeBuffer& Buffer, uint64_t NumElements, kernels::ReduceOp Op, kernels::ReduceType Type,
+						uint32_t ElementSize, void* Result, uint32_t ResultSize, const std::vector<JobTicket>& Dependencies)
+{
+	if (NumElements == 0 || NumElements > UINT32_MAX)
+	{
+		throw std::invalid_argument("reductions take 1 to 2^32 - 1 elements");
+	}
+	if (Buffer.Size < NumElements * ElementSize)
+	{
+		throw std::invalid_argument("reduced buffer is smaller than its elements");
+	}
+	if (!isSupported(Context, Type))
+	{
+		throw std::runtime_error("device lacks subgroup arithmetic or shaderFloat64 for this reduction");
+	}
+	const ComputeKernel& ReduceElements = Context.createKernel(kernels::reduce(Op, Type, 0));
+	const ComputeKernel& ReducePartials = Context.createKernel(kernels::reduce(Op, Type, 1));
+
+	// Power of two windows keep every window offset a multiple of minStorageBufferOffsetAlignment
+	vk::DeviceSize WindowSize = vk::DeviceSize(1) << 31;
+	while (WindowSize > Context.getDeviceProperties().limits.maxStorageBufferRange)
+	{
+		WindowSize >>= 1;
+	}
+	const uint64_t WindowElements = WindowSize / ElementSize;
+	const uint64_t NumWindows = (NumElements + WindowElements - 1) / WindowElements;
+	ensurePartials(NumWindows * MaxGroupsPerWindow * ResultSize);
+
+	// 第一遍: 每个窗口的每个工作组归约出一个部分结果, 窗口之间互不依赖
+	uint32_t NumPartials = 0;
+	for (uint64_t FirstElement = 0; FirstElement < NumElements; FirstElement += WindowElements)
+	{
+		const uint64_t Count = std::min(WindowElements, NumElements - FirstElement);
+		const uint32_t NumGroups = static_cast<uint32_t>(std::min<uint64_t>(MaxGroupsPerWindow, (Count + GroupSize - 1) / GroupSize));
+		ComputeJob Job;
+		Job.Kernel = &ReduceElements;
+		Job.Buffers = { &Buffer, &Partials };
+		Job.BufferRanges = { { FirstElement * ElementSize, Count * ElementSize }, { 0, 0 } };
+		Job.ElementCount = uint64_t(NumGroups) * GroupSize;
+		Job.GroupSize = GroupSize;
+		setReducePushConstants(Job, static_cast<uint32_t>(Count), static_cast<uint32_t>(FirstElement), NumPartials);
+		Context.submitAsync(Job, Dependencies);
+		NumPartials += NumGroups;
+	}
+
+	// 第二遍: 一个工作组归约所有部分结果, 只读回这一个结果
+	ComputeJob Final;
+	Final.Kernel = &ReducePartials;
+	Final.Buffers = { &Partials, &ResultBuffer };
+	Final.ElementCount = GroupSize;
+	Final.GroupSize = GroupSize;
+	setReducePushConstants(Final, NumPartials, 0, 0);
+	Final.Downloads = { { &ResultBuffer, Result, ResultSize } };
+	Context.submit(Final);
+}
+
+template <typename T>
+ReduceResult<T> Reducer::reduce(const ComputeBuffer& Buffer, uint64_t NumElements, kernels::ReduceOp Op,
+								const std::vector<JobTicket>& Dependencies)
+{
+	Partial<T> Final;
+	reduceRaw(Buffer, NumElements, Op, ReduceTypeOf<T>::Value, sizeof(T), &Final, sizeof(Final), Dependencies);
+	ReduceResult<T> Result;
+	Result.Value = Final.Value;
+	Result.Index = Final.Index;
+	return Result;
+}
+
+template ReduceResult<uint32_t> Reducer::reduce<uint32_t>(const ComputeBuffer&, uint64_t, kernels::ReduceOp, const std::vector<JobTicket>&);
+template ReduceResult<int32_t> Reducer::reduce<int32_t>(const ComputeBuffer&, uint64_t, kernels::ReduceOp, const std::vector<JobTicket>&);
+template ReduceResult<float> Reducer::reduce<float>(const ComputeBuffer&, uint64_t, kernels::ReduceOp, const std::vector<JobTicket>&);
+template ReduceResult<double> Reducer::reduce<double>(const ComputeBuffer&, uint64_t, kernels::ReduceOp, const std::vector<JobTicket>&);
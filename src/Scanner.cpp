@@ -0,0 +1,123 @@
+#include "Scanner.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "Kernels.h"
+
+namespace
+{
+	void setScanPushConstants(ComputeJob& Job, uint32_t NumElements, uint32_t NumTiles)
+	{
+		const uint32_t Values[] = { NumElements, NumTiles };
+		Job.PushConstants.resize(sizeof(Values));
+		std::memcpy(Job.PushConstants.data(), Values, sizeof(Values));
+	}
+}
+
+Scanner::Scanner(ComputeContext& InContext)
+	: Context(InContext)
+{
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	GroupSize = std::min({ 256u, Limits.maxComputeWorkGroupInvocations, Limits.maxComputeWorkGroupSize[0] });
+	// Tile, per-invocation sums and heads, three broadcast words
+	while (GroupSize > 32 && (GroupSize * kernels::ScanItemsPerThread + 2 * GroupSize + 3) * sizeof(uint32_t) > Limits.maxComputeSharedMemorySize)
+	{
+		GroupSize /= 2;
+	}
+}
+
+Scanner::~Scanner()
+{
+	Context.waitIdle();
+	Context.destroyBuffer(Status);
+}
+
+bool Scanner::hasForwardProgress(const vk::PhysicalDeviceProperties& DeviceProps)
+{
+	// AMD, NVIDIA and Intel GPUs keep a started workgroup resident until it finishes. Tiled mobile
+	// GPUs, translation layers and software rasterizers make no such promise
+	const bool bKnownVendor = DeviceProps.vendorID == 0x1002 || DeviceProps.vendorID == 0x10DE || DeviceProps.vendorID == 0x8086;
+	return bKnownVendor && DeviceProps.deviceType != vk::PhysicalDeviceType::eCpu;
+}
+
+uint32_t Scanner::getTileSize() const
+{
+	return GroupSize * kernels::ScanItemsPerThread;
+}
+
+void Scanner::ensureStatus(vk::DeviceSize Size)
+{
+	if (Status.Size >= Size)
+	{
+		return;
+	}
+	if (LastScan.isValid())
+	{
+		LastScan.wait();
+	}
+	Context.destroyBuffer(Status);
+	Status = Context.createBuffer(Size);
+}
+
+void Scanner::scan(const ComputeBuffer& Input, const ComputeBuffer& Output, uint64_t NumElements, const ScanOptions& Options)
+{
+	scanAsync(Input, Output, NumElements, Options).wait();
+}
+
+JobTicket Scanner::scanAsync(const ComputeBuffer& Input, const ComputeBuffer& Output, uint64_t NumElements,
+							 const ScanOptions& Options, const std::vector<JobTicket>& Dependencies)
+{
+	if (NumElements == 0 || NumElements > UINT32_MAX)
+	{
+		throw std::invalid_argument("scans take 1 to 2^32 - 1 elements");
+	}
+	const vk::DeviceSize Size = NumElements * sizeof(uint32_t);
+	if (Input.Size < Size || Output.Size < Size || (Options.HeadFlags && Options.HeadFlags->Size < Size))
+	{
+		throw std::invalid_argument("scan buffers are smaller than their elements");
+	}
+
+	const bool bSegmented = Options.HeadFlags != nullptr;
+	const uint32_t TileSize = getTileSize();
+	const uint32_t NumTiles = static_cast<uint32_t>((NumElements + TileSize - 1) / TileSize);
+	ensureStatus((1 + 3 * vk::DeviceSize(NumTiles)) * sizeof(uint32_t));
+
+	std::vector<JobTicket> Waits = Dependencies;
+	if (LastScan.isValid())
+	{
+		Waits.push_back(LastScan);
+	}
+	const ComputeBuffer* HeadFlags = bSegmented ? Options.HeadFlags : &Input;
+	auto makeJob = [&](kernels::ScanMode Mode, uint64_t NumGroups)
+	{
+		ComputeJob Job;
+		Job.Kernel = &Context.createKernel(kernels::scan(Mode, Options.bExclusive, bSegmented));
+		Job.Buffers = { &Input, &Output, HeadFlags, &Status };
+		Job.ElementCount = NumGroups * GroupSize;
+		Job.GroupSize = GroupSize;
+		setScanPushConstants(Job, static_cast<uint32_t>(NumElements), NumTiles);
+		return Job;
+	};
+
+	ScanAlgorithm Algorithm = Options.Algorithm;
+	if (Algorithm == ScanAlgorithm::Auto)
+	{
+		Algorithm = hasForwardProgress(Context.getDeviceProperties()) ? ScanAlgorithm::SinglePass : ScanAlgorithm::ReduceThenScan;
+	}
+	if (Algorithm == ScanAlgorithm::SinglePass)
+	{
+		ComputeJob Job = makeJob(kernels::ScanMode::SinglePass, NumTiles);
+		// Tile counter and states start at zero on every scan
+		Job.Fills = { { &Status, 0, (1 + 3 * vk::DeviceSize(NumTiles)) * sizeof(uint32_t), 0 } };
+		LastScan = Context.submitAsync(Job, Waits);
+		return LastScan;
+	}
+
+	// Reduce-then-scan, each pass waits for the one before it
+	const JobTicket Reduced = Context.submitAsync(makeJob(kernels::ScanMode::ReduceTiles, NumTiles), Waits);
+	const JobTicket Scanned = Context.submitAsync(makeJob(kernels::ScanMode::ScanTiles, 1), { Reduced });
+	LastScan = Context.submitAsync(makeJob(kernels::ScanMode::ScanWithCarry, NumTiles), { Scanned });
+	return LastScan;
+}
@@ -0,0 +1,170 @@
+#include "SegmentedSorter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	// Largest shared network, enough for the arrays this is meant for while two of its arrays still fit
+	// most devices' shared memory
+	constexpr uint32_t MaxSharedSegment = 4096;
+	// Smallest network, a multiple of the shader's MERGE_ITEMS
+	constexpr uint32_t MinSharedSegment = 64;
+	// Merge offsets are uints and the run widths of the fallback double up to the segment length
+	constexpr uint64_t MaxKeys = (uint64_t(1) << 31) - 1;
+
+	uint32_t nextPowerOfTwo(uint32_t Value)
+	{
+		uint32_t Power = 1;
+		while (Power < Value)
+		{
+			Power *= 2;
+		}
+		return Power;
+	}
+}
+
+SegmentedSorter::SegmentedSorter(ComputeContext& InContext)
+	: Context(InContext)
+{
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	SortThreads = std::min({ 256u, Limits.maxComputeWorkGroupInvocations, Limits.maxComputeWorkGroupSize[0] });
+	// Keys and their indices in shared memory
+	for (MaxCapacity = MaxSharedSegment; MaxCapacity > MinSharedSegment; MaxCapacity /= 2)
+	{
+		if (2 * MaxCapacity * sizeof(uint32_t) <= Limits.maxComputeSharedMemorySize)
+		{
+			break;
+		}
+	}
+	// The staged keys and the merge order of a tile, and the two splits
+	for (MergeGroupSize = SortThreads; MergeGroupSize > 32; MergeGroupSize /= 2)
+	{
+		if ((2 * MergeGroupSize * kernels::MergeItemsPerThread + 2) * sizeof(uint32_t) <= Limits.maxComputeSharedMemorySize)
+		{
+			break;
+		}
+	}
+}
+
+SegmentedSorter::~SegmentedSorter()
+{
+	Context.waitIdle();
+	Context.destroyBuffer(KeysTemp);
+	Context.destroyBuffer(ValuesTemp);
+}
+
+void SegmentedSorter::ensureBuffer(ComputeBuffer& Buffer, vk::DeviceSize Size)
+{
+	if (Buffer.Size >= Size)
+	{
+		return;
+	}
+	if (LastTempJob.isValid())
+	{
+		LastTempJob.wait();
+	}
+	Context.destroyBuffer(Buffer);
+	Buffer = Context.createBuffer(Size);
+}
+
+void SegmentedSorter::sort(const ComputeBuffer& Keys, uint64_t NumKeys, const ComputeBuffer& Offsets, uint32_t NumSegments,
+						   const ComputeBuffer* Values, const SegmentedSortOptions& Options)
+{
+	sortAsync(Keys, NumKeys, Offsets, NumSegments, Values, Options).wait();
+}
+
+JobTicket SegmentedSorter::sortAsync(const ComputeBuffer& Keys, uint64_t NumKeys, const ComputeBuffer& Offsets, uint32_t NumSegments,
+									 const ComputeBuffer* Values, const SegmentedSortOptions& Options,
+									 const std::vector<JobTicket>& Dependencies)
+{
+	if (NumKeys == 0 || NumKeys > MaxKeys || NumSegments == 0)
+	{
+		throw std::invalid_argument("segmented sorts take 1 to 2^31 - 1 keys in at least one segment");
+	}
+	const vk::DeviceSize KeysSize = NumKeys * sizeof(uint32_t);
+	if (Keys.Size < KeysSize || (Values && Values->Size < KeysSize) || Offsets.Size < (vk::DeviceSize(NumSegments) + 1) * sizeof(uint32_t))
+	{
+		throw std::invalid_argument("segmented sort buffers are smaller than their keys or offsets");
+	}
+
+	// A known short bound sorts in a network just big enough, one workgroup of half its size
+	const bool bBounded = Options.MaxSegmentLength != 0 && Options.MaxSegmentLength <= MaxCapacity;
+	const uint32_t Capacity = bBounded ? std::max(nextPowerOfTwo(Options.MaxSegmentLength), MinSharedSegment) : MaxCapacity;
+	const uint32_t Threads = std::min(SortThreads, Capacity / 2);
+	// The offsets lie within NumKeys, so no segment can outgrow the network unless NumKeys does. A
+	// segment longer than the bound then takes the long-segment path instead of overrunning it
+	const bool bTemporaries = NumKeys > Capacity;
+
+	std::vector<JobTicket> Waits = Dependencies;
+	const ComputeBuffer* KeysScratch = &Keys;
+	const ComputeBuffer* ValuesScratch = &Keys;
+	if (bTemporaries)
+	{
+		ensureBuffer(KeysTemp, KeysSize);
+		KeysScratch = &KeysTemp;
+		if (Values)
+		{
+			ensureBuffer(ValuesTemp, KeysSize);
+			ValuesScratch = &ValuesTemp;
+		}
+		if (LastTempJob.isValid())
+		{
+			Waits.push_back(LastTempJob);
+		}
+	}
+
+	const uint32_t MaxGroupsX = Context.getDeviceProperties().limits.maxComputeWorkGroupCount[0];
+	ComputeJob Job;
+	Job.Kernel = &Context.createKernel(kernels::segmentedSort(Options.KeyType, Values != nullptr, Capacity, Threads));
+	Job.Buffers = { &Keys, Values ? Values : &Keys, &Offsets, KeysScratch, ValuesScratch };
+	Job.GroupCount = { std::min(NumSegments, MaxGroupsX), (NumSegments + MaxGroupsX - 1) / MaxGroupsX, 1 };
+	Job.PushConstants.resize(sizeof(uint32_t));
+	std::memcpy(Job.PushConstants.data(), &NumSegments, sizeof(uint32_t));
+	const JobTicket Ticket = Context.submitAsync(Job, Waits);
+	if (bTemporaries)
+	{
+		LastTempJob = Ticket;
+	}
+	return Ticket;
+}
+
+void SegmentedSorter::merge(const SortedRun& A, const SortedRun& B, const ComputeBuffer& KeysOut, const ComputeBuffer* ValuesOut,
+							kernels::ElementType KeyType)
+{
+	mergeAsync(A, B, KeysOut, ValuesOut, KeyType).wait();
+}
+
+JobTicket SegmentedSorter::mergeAsync(const SortedRun& A, const SortedRun& B, const ComputeBuffer& KeysOut, const ComputeBuffer* ValuesOut,
+									  kernels::ElementType KeyType, const std::vector<JobTicket>& Dependencies)
+{
+	const uint64_t Total = A.Count + B.Count;
+	if (!A.Keys || !B.Keys || Total == 0 || Total > UINT32_MAX)
+	{
+		throw std::invalid_argument("merges take two key runs of 1 to 2^32 - 1 keys together");
+	}
+	const bool bValues = ValuesOut != nullptr;
+	if ((A.Values != nullptr) != bValues || (B.Values != nullptr) != bValues)
+	{
+		throw std::invalid_argument("either both merged runs and the output have values or none of them");
+	}
+	if (A.Keys->Size < A.Count * sizeof(uint32_t) || B.Keys->Size < B.Count * sizeof(uint32_t) || KeysOut.Size < Total * sizeof(uint32_t) ||
+		(bValues && (A.Values->Size < A.Count * sizeof(uint32_t) || B.Values->Size < B.Count * sizeof(uint32_t) ||
+					 ValuesOut->Size < Total * sizeof(uint32_t))))
+	{
+		throw std::invalid_argument("merge buffers are smaller than their runs");
+	}
+
+	const uint32_t TileSize = getMergeTileSize();
+	const uint64_t NumTiles = (Total + TileSize - 1) / TileSize;
+	ComputeJob Job;
+	Job.Kernel = &Context.createKernel(kernels::merge(KeyType, bValues));
+	Job.Buffers = { A.Keys, B.Keys, bValues ? A.Values : A.Keys, bValues ? B.Values : B.Keys, &KeysOut, bValues ? ValuesOut : &KeysOut };
+	Job.ElementCount = NumTiles * MergeGroupSize;
+	Job.GroupSize = MergeGroupSize;
+	const uint32_t Counts[] = { static_cast<uint32_t>(A.Count), static_cast<uint32_t>(B.Count) };
+	Job.PushConstants.resize(sizeof(Counts));
+	std::memcpy(Job.PushConstants.data(), Counts, sizeof(Counts));
+	return Context.submitAsync(Job, Dependencies);
+}
@@ -0,0 +1,161 @@
+#include "SparseMatrix.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+	std::string toLower(std::string Text)
+	{
+		std::transform(Text.begin(), Text.end(), Text.begin(), [](unsigned char Char) { return static_cast<char>(std::tolower(Char)); });
+		return Text;
+	}
+}
+
+CsrMatrix loadMatrixMarket(const std::string& FileName)
+{
+	std::ifstream File(FileName);
+	if (!File.is_open())
+	{
+		throw std::runtime_error("failed to open " + FileName);
+	}
+	std::string Line;
+	std::getline(File, Line);
+	std::istringstream Banner(toLower(Line));
+	std::string Tag, Object, Format, Field, Symmetry;
+	Banner >> Tag >> Object >> Format >> Field >> Symmetry;
+	if (Tag != "%%matrixmarket" || Object != "matrix")
+	{
+		throw std::runtime_error(FileName + " is not a Matrix Market matrix");
+	}
+	if (Format != "coordinate")
+	{
+		throw std::runtime_error(FileName + ": only sparse coordinate matrices are supported");
+	}
+	const bool bPattern = Field == "pattern";
+	if (!bPattern && Field != "real" && Field != "integer")
+	{
+		throw std::runtime_error(FileName + ": unsupported field " + Field);
+	}
+	const bool bSymmetric = Symmetry == "symmetric";
+	const bool bSkew = Symmetry == "skew-symmetric";
+	if (!bSymmetric && !bSkew && Symmetry != "general")
+	{
+		throw std::runtime_error(FileName + ": unsupported symmetry " + Symmetry);
+	}
+
+	// Comments until the size line
+	while (std::getline(File, Line) && (Line.empty() || Line[0] == '%'))
+	{
+	}
+	uint64_t Rows = 0, Cols = 0, Entries = 0;
+	std::istringstream Size(Line);
+	if (!(Size >> Rows >> Cols >> Entries) || Rows == 0 || Cols == 0 || Rows >= UINT32_MAX || Cols > UINT32_MAX)
+	{
+		throw std::runtime_error(FileName + ": bad size line");
+	}
+
+	// 先读成坐标形式, 再按行计数排序成 CSR
+	std::vector<uint32_t> EntryRows, EntryCols;
+	std::vector<float> EntryValues;
+	const uint64_t Reserve = (bSymmetric || bSkew) ? 2 * Entries : Entries;
+	EntryRows.reserve(Reserve);
+	EntryCols.reserve(Reserve);
+	EntryValues.reserve(Reserve);
+	for (uint64_t Entry = 0; Entry < Entries; ++Entry)
+	{
+		if (!std::getline(File, Line))
+		{
+			throw std::runtime_error(FileName + ": fewer entries than the size line says");
+		}
+		const char* Cursor = Line.c_str();
+		char* End = nullptr;
+		const uint64_t Row = std::strtoull(Cursor, &End, 10);
+		Cursor = End;
+		const uint64_t Col = std::strtoull(Cursor, &End, 10);
+		Cursor = End;
+		const float Value = bPattern ? 1.0f : std::strtof(Cursor, &End);
+		if (Row == 0 || Row > Rows || Col == 0 || Col > Cols)
+		{
+			throw std::runtime_error(FileName + ": entry " + std::to_string(Entry + 1) + " is outside the matrix");
+		}
+		EntryRows.push_back(static_cast<uint32_t>(Row - 1));
+		EntryCols.push_back(static_cast<uint32_t>(Col - 1));
+		EntryValues.push_back(Value);
+		if ((bSymmetric || bSkew) && Row != Col)
+		{
+			EntryRows.push_back(static_cast<uint32_t>(Col - 1));
+			EntryCols.push_back(static_cast<uint32_t>(Row - 1));
+			EntryValues.push_back(bSkew ? -Value : Value);
+		}
+	}
+	if (EntryRows.size() > UINT32_MAX)
+	{
+		throw std::runtime_error(FileName + ": more than 2^32 - 1 non-zeros");
+	}
+
+	CsrMatrix Matrix;
+	Matrix.Rows = static_cast<uint32_t>(Rows);
+	Matrix.Cols = static_cast<uint32_t>(Cols);
+	Matrix.RowOffsets.assign(Matrix.Rows + 1, 0);
+	for (uint32_t Row : EntryRows)
+	{
+		++Matrix.RowOffsets[Row + 1];
+	}
+	for (uint32_t Row = 0; Row < Matrix.Rows; ++Row)
+	{
+		Matrix.RowOffsets[Row + 1] += Matrix.RowOffsets[Row];
+	}
+	std::vector<uint32_t> Next(Matrix.RowOffsets.begin(), Matrix.RowOffsets.end() - 1);
+	Matrix.Columns.resize(EntryRows.size());
+	Matrix.Values.resize(EntryRows.size());
+	for (size_t Entry = 0; Entry < EntryRows.size(); ++Entry)
+	{
+		const uint32_t Target = Next[EntryRows[Entry]]++;
+		Matrix.Columns[Target] = EntryCols[Entry];
+		Matrix.Values[Target] = EntryValues[Entry];
+	}
+	return Matrix;
+}
+
+RowLengthStats computeRowLengthStats(const CsrMatrix& Matrix, uint32_t SliceHeight, uint32_t Sigma)
+{
+	RowLengthStats Stats;
+	if (Matrix.Rows == 0)
+	{
+		return Stats;
+	}
+	Stats.Min = std::numeric_limits<uint32_t>::max();
+	double Sum = 0.0, SumSquares = 0.0;
+	std::vector<uint32_t> Window;
+	for (uint32_t First = 0; First < Matrix.Rows; First += Sigma)
+	{
+		const uint32_t Count = std::min(Sigma, Matrix.Rows - First);
+		Window.resize(Count);
+		for (uint32_t I = 0; I < Count; ++I)
+		{
+			const uint32_t Length = Matrix.RowOffsets[First + I + 1] - Matrix.RowOffsets[First + I];
+			Window[I] = Length;
+			Stats.Min = std::min(Stats.Min, Length);
+			Stats.Max = std::max(Stats.Max, Length);
+			Sum += Length;
+			SumSquares += double(Length) * Length;
+		}
+		// Like the GPU conversion: longest rows first, every slice as wide as its first row
+		std::sort(Window.begin(), Window.end(), std::greater<uint32_t>());
+		for (uint32_t I = 0; I < Count; I += SliceHeight)
+		{
+			Stats.SellPaddedSize += uint64_t(Window[I]) * SliceHeight;
+		}
+	}
+	Stats.Mean = Sum / Matrix.Rows;
+	Stats.StdDev = std::sqrt(std::max(SumSquares / Matrix.Rows - Stats.Mean * Stats.Mean, 0.0));
+	return Stats;
+}
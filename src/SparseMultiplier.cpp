@@ -0,0 +1,213 @@
+#include "SparseMultiplier.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "Kernels.h"
+
+namespace
+{
+	// Uploads are split so that they go through the staging ring instead of one-off staging buffers
+	constexpr vk::DeviceSize UploadChunkSize = 16 * 1024 * 1024;
+	// Rows this long keep a subgroup busy, shorter ones leave most of its lanes idle
+	constexpr double VectorRowLength = 12.0;
+	// SELL wins while little of it is padding and rows are short enough for one invocation each
+	constexpr double MinSellEfficiency = 0.75;
+	constexpr double MaxSellRowLength = 64.0;
+	// Subgroups of a vector SpMV, they stride over the rows beyond this
+	constexpr uint32_t MaxVectorGroups = 65535;
+
+	template <size_t N>
+	void setPushConstants(ComputeJob& Job, const uint32_t (&Values)[N])
+	{
+		Job.PushConstants.resize(sizeof(Values));
+		std::memcpy(Job.PushConstants.data(), Values, sizeof(Values));
+	}
+}
+
+SparseMultiplier::SparseMultiplier(ComputeContext& InContext, uint32_t InSliceHeight, uint32_t InSigma)
+	: Context(InContext)
+	, Sorter(InContext)
+	, Scan(InContext)
+	, SliceHeight(InSliceHeight)
+	, Sigma(InSigma)
+{
+	if (SliceHeight == 0 || Sigma == 0 || Sigma % SliceHeight != 0)
+	{
+		throw std::invalid_argument("SELL sigma must be a non-zero multiple of the slice height");
+	}
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	GroupSize = std::min({ 256u, Limits.maxComputeWorkGroupInvocations, Limits.maxComputeWorkGroupSize[0] });
+}
+
+SparseMultiplier::~SparseMultiplier()
+{
+	Context.waitIdle();
+}
+
+bool SparseMultiplier::isSupported(const ComputeContext& Context)
+{
+	const vk::PhysicalDeviceSubgroupProperties& Subgroup = Context.getSubgroupProperties();
+	const vk::SubgroupFeatureFlags Needed = vk::SubgroupFeatureFlagBits::eBasic | vk::SubgroupFeatureFlagBits::eArithmetic;
+	return (Subgroup.supportedStages & vk::ShaderStageFlagBits::eCompute) && (Subgroup.supportedOperations & Needed) == Needed;
+}
+
+SpmvFormat SparseMultiplier::chooseFormat(const RowLengthStats& Stats, uint64_t NonZeros) const
+{
+	if (Stats.Mean <= MaxSellRowLength && Stats.getSellEfficiency(NonZeros) >= MinSellEfficiency && RadixSorter::isSupported(Context))
+	{
+		return SpmvFormat::Sell;
+	}
+	// Long rows, or a few very long ones that would stall a whole workgroup of scalar rows
+	if (Stats.Mean >= VectorRowLength || Stats.Max >= 64 * std::max(Stats.Mean, 1.0))
+	{
+		return SpmvFormat::CsrVector;
+	}
+	return SpmvFormat::CsrScalar;
+}
+
+void SparseMultiplier::uploadStaged(const ComputeBuffer& Buffer, const void* Data, vk::DeviceSize Size, std::vector<JobTicket>& Uploaded)
+{
+	// Every chunk is copied into the ring when its job is submitted, the jobs only wait for ring space
+	const uint8_t* Bytes = static_cast<const uint8_t*>(Data);
+	for (vk::DeviceSize Offset = 0; Offset < Size; Offset += UploadChunkSize)
+	{
+		ComputeJob Job;
+		Job.Uploads = { { &Buffer, Bytes + Offset, std::min(UploadChunkSize, Size - Offset), Offset } };
+		Uploaded.push_back(Context.submitAsync(Job));
+	}
+}
+
+DeviceSparseMatrix SparseMultiplier::upload(const CsrMatrix& Matrix, SpmvFormat Format)
+{
+	if (Matrix.Rows == 0 || Matrix.Cols == 0 || Matrix.RowOffsets.size() != size_t(Matrix.Rows) + 1 ||
+		Matrix.Values.size() != Matrix.Columns.size() || Matrix.RowOffsets.back() != Matrix.Columns.size())
+	{
+		throw std::invalid_argument("malformed CSR matrix");
+	}
+	if (!isSupported(Context))
+	{
+		throw std::runtime_error("SpMV needs subgroup arithmetic in compute shaders");
+	}
+	const RowLengthStats Stats = computeRowLengthStats(Matrix, SliceHeight, Sigma);
+	if (Format == SpmvFormat::Auto)
+	{
+		Format = chooseFormat(Stats, Matrix.getNonZeros());
+	}
+	if (Format == SpmvFormat::Sell && Stats.SellPaddedSize > UINT32_MAX)
+	{
+		throw std::invalid_argument("SELL form of the matrix has more than 2^32 - 1 entries");
+	}
+
+	DeviceSparseMatrix Device;
+	Device.Format = Format;
+	Device.Rows = Matrix.Rows;
+	Device.Cols = Matrix.Cols;
+	Device.NonZeros = Matrix.getNonZeros();
+	Device.StoredEntries = Device.NonZeros;
+	// Empty matrices still bind valid buffers
+	const vk::DeviceSize EntryBytes = std::max<vk::DeviceSize>(Device.NonZeros, 1) * sizeof(uint32_t);
+	Device.RowOffsets = Context.createBuffer(Matrix.RowOffsets.size() * sizeof(uint32_t));
+	Device.Columns = Context.createBuffer(EntryBytes);
+	Device.Values = Context.createBuffer(EntryBytes);
+	std::vector<JobTicket> Uploaded;
+	uploadStaged(Device.RowOffsets, Matrix.RowOffsets.data(), Matrix.RowOffsets.size() * sizeof(uint32_t), Uploaded);
+	uploadStaged(Device.Columns, Matrix.Columns.data(), Device.NonZeros * sizeof(uint32_t), Uploaded);
+	uploadStaged(Device.Values, Matrix.Values.data(), Device.NonZeros * sizeof(float), Uploaded);
+	if (Format == SpmvFormat::Sell)
+	{
+		convertToSell(Device, Stats.SellPaddedSize, Uploaded);
+	}
+	Context.waitIdle();
+	return Device;
+}
+
+void SparseMultiplier::convertToSell(DeviceSparseMatrix& Matrix, uint64_t PaddedSize, const std::vector<JobTicket>& Dependencies)
+{
+	const uint32_t NumSlices = (Matrix.Rows + SliceHeight - 1) / SliceHeight;
+	ComputeBuffer Keys = Context.createBuffer(uint64_t(Matrix.Rows) * 2 * sizeof(uint32_t));
+	ComputeBuffer Permutation = Context.createBuffer(uint64_t(Matrix.Rows) * sizeof(uint32_t));
+	ComputeBuffer SliceOffsets = Context.createBuffer((uint64_t(NumSlices) + 1) * sizeof(uint32_t));
+	ComputeBuffer Columns = Context.createBuffer(std::max<uint64_t>(PaddedSize, 1) * sizeof(uint32_t));
+	ComputeBuffer Values = Context.createBuffer(std::max<uint64_t>(PaddedSize, 1) * sizeof(float));
+
+	auto makeJob = [&](kernels::SellConvertMode Mode, uint64_t Invocations)
+	{
+		ComputeJob Job;
+		Job.Kernel = &Context.createKernel(kernels::sellConvert(Mode));
+		Job.Buffers = { &Matrix.RowOffsets, &Keys, &Permutation, &SliceOffsets, &Matrix.Columns, &Matrix.Values, &Columns, &Values };
+		Job.ElementCount = Invocations;
+		Job.GroupSize = GroupSize;
+		setPushConstants(Job, { Matrix.Rows, Sigma, SliceHeight, NumSlices });
+		return Job;
+	};
+	// 1) 排序键: 窗口号在高位, 行长度取反在低位, 稳定排序后每个窗口内按长度降序
+	const JobTicket Keyed = Context.submitAsync(makeJob(kernels::SellConvertMode::Keys, Matrix.Rows), Dependencies);
+	const JobTicket Sorted = Sorter.sortAsync(Keys, Matrix.Rows, RadixKeyType::Uint64, &Permutation, ScanAlgorithm::Auto, { Keyed });
+	// 2) Slice widths of the sorted rows, scanned into offsets with the total in the extra entry
+	const JobTicket Widths = Context.submitAsync(makeJob(kernels::SellConvertMode::Widths, uint64_t(NumSlices) + 1), { Sorted });
+	ScanOptions ScanOpts;
+	ScanOpts.bExclusive = true;
+	const JobTicket Scanned = Scan.scanAsync(SliceOffsets, SliceOffsets, uint64_t(NumSlices) + 1, ScanOpts, { Widths });
+	// 3) Copy every row into its lane of its slice
+	Context.submitAsync(makeJob(kernels::SellConvertMode::Fill, uint64_t(NumSlices) * SliceHeight), { Scanned }).wait();
+
+	Context.destroyBuffer(Keys);
+	Context.destroyBuffer(Matrix.RowOffsets);
+	Context.destroyBuffer(Matrix.Columns);
+	Context.destroyBuffer(Matrix.Values);
+	Matrix.RowOffsets = SliceOffsets;
+	Matrix.Columns = Columns;
+	Matrix.Values = Values;
+	Matrix.Permutation = Permutation;
+	Matrix.NumSlices = NumSlices;
+	Matrix.StoredEntries = PaddedSize;
+}
+
+void SparseMultiplier::destroy(DeviceSparseMatrix& Matrix)
+{
+	Context.waitIdle();
+	Context.destroyBuffer(Matrix.RowOffsets);
+	Context.destroyBuffer(Matrix.Columns);
+	Context.destroyBuffer(Matrix.Values);
+	Context.destroyBuffer(Matrix.Permutation);
+	Matrix = DeviceSparseMatrix();
+}
+
+void SparseMultiplier::multiply(const DeviceSparseMatrix& Matrix, const ComputeBuffer& X, const ComputeBuffer& Y)
+{
+	multiplyAsync(Matrix, X, Y).wait();
+}
+
+JobTicket SparseMultiplier::multiplyAsync(const DeviceSparseMatrix& Matrix, const ComputeBuffer& X, const ComputeBuffer& Y,
+										  const std::vector<JobTicket>& Dependencies)
+{
+	if (X.Size < uint64_t(Matrix.Cols) * sizeof(float) || Y.Size < uint64_t(Matrix.Rows) * sizeof(float))
+	{
+		throw std::invalid_argument("SpMV vectors are smaller than the matrix");
+	}
+	if (Matrix.Format == SpmvFormat::Auto)
+	{
+		throw std::invalid_argument("uploaded matrices have a concrete format");
+	}
+	const kernels::SpmvMode Mode = Matrix.Format == SpmvFormat::Sell ? kernels::SpmvMode::Sell
+								 : Matrix.Format == SpmvFormat::CsrVector ? kernels::SpmvMode::CsrVector : kernels::SpmvMode::CsrScalar;
+	ComputeJob Job;
+	Job.Kernel = &Context.createKernel(kernels::spmv(Mode));
+	const ComputeBuffer* Permutation = Matrix.Format == SpmvFormat::Sell ? &Matrix.Permutation : &Matrix.RowOffsets;
+	Job.Buffers = { &Matrix.RowOffsets, &Matrix.Columns, &Matrix.Values, Permutation, &X, &Y };
+	Job.GroupSize = GroupSize;
+	if (Mode == kernels::SpmvMode::CsrVector)
+	{
+		// Whole workgroups, each with at least one subgroup per row
+		const uint64_t RowsPerGroup = std::max(GroupSize / std::max(Context.getSubgroupProperties().subgroupSize, 1u), 1u);
+		Job.ElementCount = std::min<uint64_t>((Matrix.Rows + RowsPerGroup - 1) / RowsPerGroup, MaxVectorGroups) * GroupSize;
+	}
+	else
+	{
+		Job.ElementCount = Mode == kernels::SpmvMode::Sell ? uint64_t(Matrix.NumSlices) * SliceHeight : Matrix.Rows;
+	}
+	setPushConstants(Job, { Matrix.Rows, SliceHeight });
+	return Context.submitAsync(Job, Dependencies);
+}
@@ -0,0 +1,130 @@
+#include "StagingRing.h"
+
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+	// Keeps every copy offset at the largest optimalBufferCopyOffsetAlignment seen in practice
+	constexpr vk::DeviceSize RegionAlignment = 256;
+
+	vk::DeviceSize alignUp(vk::DeviceSize Value, vk::DeviceSize Alignment)
+	{
+		return (Value + Alignment - 1) / Alignment * Alignment;
+	}
+}
+
+StagingRing::StagingRing(VmaAllocator InAllocator, vk::DeviceSize InCapacity, VmaMemoryUsage Usage, uint32_t QueueFamilyIndex)
+	: Allocator(InAllocator)
+	, Capacity(InCapacity)
+{
+	vk::BufferCreateInfo BufferCreateInfo{
+		vk::BufferCreateFlags(),
+		Capacity,
+		vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst,
+		vk::SharingMode::eExclusive,
+		1,
+		&QueueFamilyIndex
+	};
+	auto vkBufferCreateInfo = static_cast<VkBufferCreateInfo>(BufferCreateInfo);
+
+	VmaAllocationCreateInfo AllocationCreateInfo = {};
+	AllocationCreateInfo.usage = Usage;
+	AllocationCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+	VkBuffer BufferRaw = VK_NULL_HANDLE;
+	VmaAllocationInfo AllocationInfo;
+	if (vmaCreateBuffer(Allocator, &vkBufferCreateInfo, &AllocationCreateInfo, &BufferRaw, &Allocation, &AllocationInfo) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create staging ring buffer!");
+	}
+	Buffer = BufferRaw;
+	Mapped = static_cast<uint8_t*>(AllocationInfo.pMappedData);
+}
+
+StagingRing::~StagingRing()
+{
+	vmaDestroyBuffer(Allocator, Buffer, Allocation);
+}
+
+bool StagingRing::reserve(vk::DeviceSize Size, StagingRegion& Region)
+{
+	if (Size == 0 || Size > Capacity)
+	{
+		return false;
+	}
+
+	const bool bEmpty = InFlightRegions.empty();
+	if (bEmpty)
+	{
+		Head = Tail = 0;
+	}
+
+	vk::DeviceSize Offset = alignUp(Head, RegionAlignment);
+	if (bEmpty || Tail < Head)
+	{
+		// Free space is [Head, Capacity) followed by [0, Tail)
+		if (Offset + Size > Capacity)
+		{
+			if (Size > Tail)
+			{
+				return false;
+			}
+			Offset = 0;
+		}
+	}
+	else if (Offset + Size > Tail)
+	{
+		// Wrapped around, free space is [Head, Tail)
+		return false;
+	}
+
+	Head = Offset + Size;
+	InFlightRegions.push_back({ Offset, Head, std::numeric_limits<uint64_t>::max() });
+
+	Region.Buffer = Buffer;
+	Region.Allocation = Allocation;
+	Region.Offset = Offset;
+	Region.Size = Size;
+	Region.Data = Mapped + Offset;
+	return true;
+}
+
+void StagingRing::commit(const StagingRegion& Region, uint64_t RetireValue)
+{
+	for (auto RegionIt = InFlightRegions.rbegin(); RegionIt != InFlightRegions.rend(); ++RegionIt)
+	{
+		if (RegionIt->Offset == Region.Offset && RegionIt->End == Region.Offset + Region.Size)
+		{
+			RegionIt->RetireValue = RetireValue;
+			return;
+		}
+	}
+	throw std::invalid_argument("committed a region that is not reserved in this staging ring");
+}
+
+void StagingRing::retire(uint64_t CompletedValue)
+{
+	while (!InFlightRegions.empty() && InFlightRegions.front().RetireValue <= CompletedValue)
+	{
+		InFlightRegions.pop_front();
+	}
+	if (InFlightRegions.empty())
+	{
+		Head = Tail = 0;
+	}
+	else
+	{
+		Tail = InFlightRegions.front().Offset;
+	}
+}
+
+vk::DeviceSize StagingRing::getBytesInFlight() const
+{
+	if (InFlightRegions.empty())
+	{
+		return 0;
+	}
+	const vk::DeviceSize Start = InFlightRegions.front().Offset;
+	return Head > Start ? Head - Start : Capacity - Start + Head;
+}
@@ -0,0 +1,189 @@
+#include "Stenciler.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+	struct StencilPushConstants
+	{
+		uint32_t SizeX;
+		uint32_t SizeY;
+		uint32_t SizeZ;
+		uint32_t Steps;
+		float BoundaryValue;
+	};
+}
+
+Stenciler::Stenciler(ComputeContext& InContext)
+	: Context(InContext)
+{
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	Threads = std::min({ 256u, Limits.maxComputeWorkGroupInvocations, Limits.maxComputeWorkGroupSize[0] });
+}
+
+Stenciler::~Stenciler()
+{
+	Context.waitIdle();
+	Context.destroyBuffer(CoefficientBuffer);
+}
+
+void Stenciler::ensureCoefficients(vk::DeviceSize Size)
+{
+	if (CoefficientBuffer.Size >= Size)
+	{
+		return;
+	}
+	if (LastApply.isValid())
+	{
+		LastApply.wait();
+	}
+	Context.destroyBuffer(CoefficientBuffer);
+	CoefficientBuffer = Context.createBuffer(Size);
+}
+
+kernels::StencilTile Stenciler::chooseTile(const StencilParams& Params) const
+{
+	const uint32_t SharedLimit = Context.getDeviceProperties().limits.maxComputeSharedMemorySize;
+	// About four cells per invocation
+	kernels::StencilTile Tile;
+	if (Params.Dims == 3)
+	{
+		Tile.X = 16;
+		Tile.Y = 8;
+		Tile.Z = 8;
+	}
+	Tile.TemporalSteps = 1;
+	// Large radii shrink the tile until a single timestep fits
+	while (Tile.getSharedSize(Params.Dims, Params.Radius) > SharedLimit)
+	{
+		uint32_t& Largest = Tile.X >= Tile.Y && Tile.X >= Tile.Z ? Tile.X : Tile.Y >= Tile.Z ? Tile.Y : Tile.Z;
+		if (Largest == 1)
+		{
+			throw std::invalid_argument("stencil radius does not fit shared memory");
+		}
+		Largest /= 2;
+	}
+	if (Params.TemporalSteps != 0)
+	{
+		Tile.TemporalSteps = Params.TemporalSteps;
+		if (Tile.getSharedSize(Params.Dims, Params.Radius) > SharedLimit)
+		{
+			throw std::invalid_argument("stencil timesteps per dispatch do not fit shared memory");
+		}
+		return Tile;
+	}
+	// More steps while the halo stays within half the smallest tile edge, beyond that the
+	// redundant halo updates outweigh the saved traffic
+	const uint32_t SmallestEdge = Params.Dims == 3 ? std::min({ Tile.X, Tile.Y, Tile.Z }) : std::min(Tile.X, Tile.Y);
+	while (Params.Radius != 0 && Tile.TemporalSteps < MaxTemporalSteps && 2 * Params.Radius * (Tile.TemporalSteps + 1) <= SmallestEdge)
+	{
+		kernels::StencilTile Deeper = Tile;
+		++Deeper.TemporalSteps;
+		if (Deeper.getSharedSize(Params.Dims, Params.Radius) > SharedLimit)
+		{
+			break;
+		}
+		Tile = Deeper;
+	}
+	return Tile;
+}
+
+void Stenciler::apply(const ComputeBuffer& Grid, const ComputeBuffer& Scratch, uint32_t Steps, const StencilParams& Params)
+{
+	applyAsync(Grid, Scratch, Steps, Params).wait();
+}
+
+JobTicket Stenciler::applyAsync(const ComputeBuffer& Grid, const ComputeBuffer& Scratch, uint32_t Steps, const StencilParams& Params,
+								const std::vector<JobTicket>& Dependencies)
+{
+	if (Steps == 0)
+	{
+		throw std::invalid_argument("stencils take at least one timestep");
+	}
+	if ((Params.Dims != 2 && Params.Dims != 3) || (Params.Dims == 2 && Params.SizeZ != 1) || Params.SizeX == 0 || Params.SizeY == 0 || Params.SizeZ == 0)
+	{
+		throw std::invalid_argument("stencil grids are 2D (SizeZ 1) or 3D with non-zero sizes");
+	}
+	const uint32_t NumCoefficients = kernels::getStencilCoefficientCount(Params.Dims, Params.Shape, Params.Radius);
+	if (Params.Coefficients.size() != NumCoefficients)
+	{
+		throw std::invalid_argument("stencil needs " + std::to_string(NumCoefficients) + " coefficients");
+	}
+	const uint64_t NumCells = uint64_t(Params.SizeX) * Params.SizeY * Params.SizeZ;
+	const vk::DeviceSize GridSize = NumCells * sizeof(float);
+	if (NumCells > UINT32_MAX || GridSize > Context.getDeviceProperties().limits.maxStorageBufferRange)
+	{
+		throw std::invalid_argument("stencil grid exceeds maxStorageBufferRange");
+	}
+	if (Grid.Size < GridSize || Scratch.Size < GridSize)
+	{
+		throw std::invalid_argument("stencil buffers are smaller than the grid");
+	}
+
+	const kernels::StencilTile Tile = chooseTile(Params);
+	const std::array<uint32_t, 3> GroupCount = { (Params.SizeX + Tile.X - 1) / Tile.X, (Params.SizeY + Tile.Y - 1) / Tile.Y,
+												 (Params.SizeZ + Tile.Z - 1) / Tile.Z };
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	for (uint32_t Axis = 0; Axis < 3; ++Axis)
+	{
+		if (GroupCount[Axis] > Limits.maxComputeWorkGroupCount[Axis])
+		{
+			throw std::invalid_argument("stencil grid needs more workgroups than maxComputeWorkGroupCount");
+		}
+	}
+	const ComputeKernel& Kernel = Context.createKernel(kernels::stencil(Params.Dims, Params.Shape, Params.Radius, Params.Boundary, Tile, Threads));
+
+	// Every dispatch swaps Grid and Scratch, so an even number of them leaves the result in Grid.
+	// An odd count is spread over one more dispatch, or ends with a copy when every step has its own
+	uint32_t NumDispatches = (Steps + Tile.TemporalSteps - 1) / Tile.TemporalSteps;
+	bool bCopyBack = false;
+	if (NumDispatches % 2 != 0)
+	{
+		if (Steps > NumDispatches)
+		{
+			++NumDispatches;
+		}
+		else
+		{
+			bCopyBack = true;
+		}
+	}
+
+	const vk::DeviceSize CoefficientSize = NumCoefficients * sizeof(float);
+	ensureCoefficients(CoefficientSize);
+	std::vector<JobTicket> Waits = Dependencies;
+	// The previous stencil may still read the coefficients this one overwrites
+	if (LastApply.isValid())
+	{
+		Waits.push_back(LastApply);
+	}
+	const ComputeBuffer* Buffers[2] = { &Grid, &Scratch };
+	const uint32_t TotalDispatches = NumDispatches + (bCopyBack ? 1 : 0);
+	uint32_t StepsLeft = Steps;
+	for (uint32_t Dispatch = 0; Dispatch < TotalDispatches; ++Dispatch)
+	{
+		// Steps spread evenly, the copy takes none
+		const uint32_t DispatchSteps = Dispatch < NumDispatches ? (StepsLeft + (NumDispatches - Dispatch) - 1) / (NumDispatches - Dispatch) : 0;
+		StepsLeft -= DispatchSteps;
+
+		ComputeJob Job;
+		Job.Kernel = &Kernel;
+		Job.Buffers = { Buffers[Dispatch % 2], Buffers[(Dispatch + 1) % 2], &CoefficientBuffer };
+		Job.GroupCount = GroupCount;
+		if (Dispatch == 0)
+		{
+			Job.Uploads = { { &CoefficientBuffer, Params.Coefficients.data(), CoefficientSize, 0 } };
+		}
+		const StencilPushConstants PushConstants = { Params.SizeX, Params.SizeY, Params.SizeZ, DispatchSteps, Params.BoundaryValue };
+		Job.PushConstants.resize(sizeof(PushConstants));
+		std::memcpy(Job.PushConstants.data(), &PushConstants, sizeof(PushConstants));
+		// Each dispatch reads what the one before it wrote
+		LastApply = Context.submitAsync(Job, Waits);
+		Waits = { LastApply };
+	}
+	return LastApply;
+}
@@ -0,0 +1,135 @@
+#include "StreamingExecutor.h"
+
+#include <chrono>
+#include <stdexcept>
+
+#include "Kernels.h"
+
+uint32_t getStreamOpInputCount(StreamOp Op)
+{
+	return Op == StreamOp::Add ? 2 : 1;
+}
+
+StreamingExecutor::StreamingExecutor(ComputeContext& InContext, StreamOp InOp, const StreamingOptions& InOptions)
+	: Context(InContext)
+	, Op(InOp)
+	, Options(InOptions)
+{
+	if (Options.ChunkElements == 0 || Options.NumBufferSets == 0)
+	{
+		throw std::invalid_argument("streaming needs a non-empty chunk and at least one buffer set");
+	}
+	Kernel = &Context.createKernel(Op == StreamOp::Add ? kernels::add() : kernels::square());
+
+	const uint32_t NumInputs = getStreamOpInputCount(Op);
+	const vk::DeviceSize ChunkSize = Options.ChunkElements * sizeof(uint32_t);
+	BufferSets.resize(Options.NumBufferSets);
+	try
+	{
+		for (BufferSet& Set : BufferSets)
+		{
+			for (uint32_t Input = 0; Input < NumInputs; ++Input)
+			{
+				Set.Inputs.push_back(Context.createBuffer(ChunkSize));
+				Set.HostInputs.emplace_back(Options.ChunkElements);
+			}
+			Set.Output = Context.createBuffer(ChunkSize);
+			Set.HostOutput.resize(Options.ChunkElements);
+		}
+	}
+	catch (...)
+	{
+		for (BufferSet& Set : BufferSets)
+		{
+			for (ComputeBuffer& Input : Set.Inputs)
+			{
+				Context.destroyBuffer(Input);
+			}
+			Context.destroyBuffer(Set.Output);
+		}
+		throw;
+	}
+}
+
+StreamingExecutor::~StreamingExecutor()
+{
+	// Results nobody asked for anymore, but the buffers must not be in use when destroyed
+	Context.waitIdle();
+	for (BufferSet& Set : BufferSets)
+	{
+		for (ComputeBuffer& Input : Set.Inputs)
+		{
+			Context.destroyBuffer(Input);
+		}
+		Context.destroyBuffer(Set.Output);
+	}
+}
+
+void StreamingExecutor::drain(BufferSet& Set, const ChunkSink& Sink)
+{
+	if (!Set.Ticket.isValid())
+	{
+		return;
+	}
+	Set.Ticket.wait();
+	Set.Ticket = JobTicket();
+	Sink(Set.HostOutput.data(), Set.NumElements);
+}
+
+StreamingStats StreamingExecutor::run(const ChunkSource& Source, const ChunkSink& Sink)
+{
+	StreamingStats Stats;
+	const uint32_t NumInputs = getStreamOpInputCount(Op);
+	const auto Start = std::chrono::steady_clock::now();
+
+	for (uint64_t ChunkIndex = 0; ; ++ChunkIndex)
+	{
+		BufferSet& Set = BufferSets[ChunkIndex % BufferSets.size()];
+		// The set's previous chunk is the oldest in flight, the other sets keep the queues busy meanwhile
+		drain(Set, Sink);
+
+		std::vector<uint32_t*> Inputs;
+		for (std::vector<uint32_t>& HostInput : Set.HostInputs)
+		{
+			Inputs.push_back(HostInput.data());
+		}
+		const uint64_t NumElements = Source(Inputs.data(), Options.ChunkElements);
+		if (NumElements == 0)
+		{
+			break;
+		}
+		if (NumElements > Options.ChunkElements)
+		{
+			throw std::out_of_range("chunk source wrote more elements than a chunk holds");
+		}
+
+		const vk::DeviceSize Size = NumElements * sizeof(uint32_t);
+		ComputeJob Job;
+		Job.Kernel = Kernel;
+		Job.ElementCount = NumElements;
+		for (uint32_t Input = 0; Input < NumInputs; ++Input)
+		{
+			Job.Buffers.push_back(&Set.Inputs[Input]);
+			// Copied into staging memory by submitAsync, HostInputs can be refilled right away
+			Job.Uploads.push_back({ &Set.Inputs[Input], Set.HostInputs[Input].data(), Size });
+		}
+		Job.Buffers.push_back(&Set.Output);
+		Job.Downloads.push_back({ &Set.Output, Set.HostOutput.data(), Size });
+
+		Set.NumElements = NumElements;
+		// No GPU dependency needed, the set's previous job finished in drain()
+		Set.Ticket = Context.submitAsync(Job);
+
+		Stats.NumElements += NumElements;
+		++Stats.NumChunks;
+		Stats.BytesTransferred += Size * (NumInputs + 1);
+	}
+
+	// Flush the chunks still in flight in stream order
+	for (uint64_t Offset = 0; Offset < BufferSets.size(); ++Offset)
+	{
+		drain(BufferSets[(Stats.NumChunks + Offset) % BufferSets.size()], Sink);
+	}
+	Stats.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	return Stats;
+}
@@ -0,0 +1,197 @@
+#include "TopKSelector.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	// Workgroups stride over each window. Every histogram workgroup adds each of its non-zero shared
+	// digit counts (up to 2048) to the state, so more workgroups mean more global atomics per pass
+	constexpr uint32_t MaxGroups = 1024;
+	constexpr uint32_t NumPasses = 3;
+	// Mirrors STATE_BINS and RADIX in shaders/top_k.comp
+	constexpr uint32_t StateWords = 8 + 2048;
+
+	template <typename T>
+	struct TopKTypeOf;
+	template <>
+	struct TopKTypeOf<uint32_t> { static constexpr kernels::ElementType Value = kernels::ElementType::Uint; };
+	template <>
+	struct TopKTypeOf<int32_t> { static constexpr kernels::ElementType Value = kernels::ElementType::Int; };
+	template <>
+	struct TopKTypeOf<float> { static constexpr kernels::ElementType Value = kernels::ElementType::Float; };
+
+	void setTopKPushConstants(ComputeJob& Job, uint32_t NumElements, uint32_t FirstIndex, uint32_t Pass, uint32_t K)
+	{
+		const uint32_t Values[] = { NumElements, FirstIndex, Pass, K };
+		Job.PushConstants.resize(sizeof(Values));
+		std::memcpy(Job.PushConstants.data(), Values, sizeof(Values));
+	}
+}
+
+TopKSelector::TopKSelector(ComputeContext& InContext)
+	: Context(InContext)
+	, SmallSorter(InContext)
+{
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	GroupSize = std::min({ 256u, Limits.maxComputeWorkGroupInvocations, Limits.maxComputeWorkGroupSize[0] });
+	State = Context.createBuffer(StateWords * sizeof(uint32_t));
+	SegmentOffsets = Context.createBuffer(2 * sizeof(uint32_t));
+}
+
+TopKSelector::~TopKSelector()
+{
+	Context.waitIdle();
+	Context.destroyBuffer(State);
+	Context.destroyBuffer(SegmentOffsets);
+	Context.destroyBuffer(ResultValues);
+	Context.destroyBuffer(ResultIndices);
+}
+
+void TopKSelector::ensureBuffer(ComputeBuffer& Buffer, vk::DeviceSize Size)
+{
+	if (Buffer.Size >= Size)
+	{
+		return;
+	}
+	if (LastJob.isValid())
+	{
+		LastJob.wait();
+	}
+	Context.destroyBuffer(Buffer);
+	Buffer = Context.createBuffer(Size);
+}
+
+JobTicket TopKSelector::selectAsync(const ComputeBuffer& Input, uint64_t NumElements, kernels::ElementType Type, uint32_t K,
+									const ComputeBuffer& Values, const ComputeBuffer& Indices, const TopKOptions& Options,
+									const std::vector<JobTicket>& Dependencies)
+{
+	if (NumElements == 0 || NumElements > UINT32_MAX)
+	{
+		throw std::invalid_argument("top-k selections take 1 to 2^32 - 1 elements");
+	}
+	if (K == 0 || K > NumElements)
+	{
+		throw std::invalid_argument("top-k selections take 1 to NumElements elements");
+	}
+	if (Input.Size < NumElements * sizeof(uint32_t) || Values.Size < vk::DeviceSize(K) * sizeof(uint32_t) ||
+		Indices.Size < vk::DeviceSize(K) * sizeof(uint32_t))
+	{
+		throw std::invalid_argument("top-k buffers are smaller than their elements");
+	}
+
+	// Power of two windows keep every window offset a multiple of minStorageBufferOffsetAlignment
+	vk::DeviceSize WindowSize = vk::DeviceSize(1) << 31;
+	while (WindowSize > Context.getDeviceProperties().limits.maxStorageBufferRange)
+	{
+		WindowSize >>= 1;
+	}
+	const uint64_t WindowElements = WindowSize / sizeof(uint32_t);
+
+	auto makeJob = [&](kernels::TopKMode Mode, uint64_t FirstElement, uint32_t Pass)
+	{
+		const uint64_t Count = std::min(WindowElements, NumElements - FirstElement);
+		const uint32_t NumGroups = static_cast<uint32_t>(std::min<uint64_t>(MaxGroups, (Count + GroupSize - 1) / GroupSize));
+		ComputeJob Job;
+		Job.Kernel = &Context.createKernel(kernels::topK(Mode, Type, Options.bLargest, Options.bSorted));
+		Job.Buffers = { &Input, &State, &Values, &Indices };
+		Job.BufferRanges = { { FirstElement * sizeof(uint32_t), Count * sizeof(uint32_t) }, { 0, 0 }, { 0, 0 }, { 0, 0 } };
+		Job.ElementCount = Mode == kernels::TopKMode::Select ? GroupSize : uint64_t(NumGroups) * GroupSize;
+		Job.GroupSize = GroupSize;
+		setTopKPushConstants(Job, static_cast<uint32_t>(Count), static_cast<uint32_t>(FirstElement), Pass, K);
+		return Job;
+	};
+
+	std::vector<JobTicket> Waits = Dependencies;
+	if (LastJob.isValid())
+	{
+		Waits.push_back(LastJob);
+	}
+	// Each pass: every window counts the digits of the elements matching the prefix, then one
+	// workgroup picks the digit the K-th element is in
+	for (uint32_t Pass = 0; Pass < NumPasses; ++Pass)
+	{
+		std::vector<JobTicket> Counted;
+		for (uint64_t FirstElement = 0; FirstElement < NumElements; FirstElement += WindowElements)
+		{
+			ComputeJob Job = makeJob(kernels::TopKMode::Histogram, FirstElement, Pass);
+			if (Pass == 0 && FirstElement == 0)
+			{
+				// The other windows count into the state once it is cleared
+				Job.Fills = { { &State, 0, VK_WHOLE_SIZE, 0 } };
+				Counted.push_back(Context.submitAsync(Job, Waits));
+				Waits = { Counted.back() };
+				continue;
+			}
+			Counted.push_back(Context.submitAsync(Job, Waits));
+		}
+		Waits = { Context.submitAsync(makeJob(kernels::TopKMode::Select, 0, Pass), Counted) };
+	}
+
+	// Windows compact one after the other so that the last one completes the selection
+	const uint32_t Offsets[] = { 0, K };
+	bool bSmallSort = false;
+	if (Options.bSorted)
+	{
+		bSmallSort = K <= SmallSorter.getMaxSharedSegment() || !RadixSorter::isSupported(Context);
+	}
+	for (uint64_t FirstElement = 0; FirstElement < NumElements; FirstElement += WindowElements)
+	{
+		ComputeJob Job = makeJob(kernels::TopKMode::Compact, FirstElement, 0);
+		if (bSmallSort && FirstElement == 0)
+		{
+			Job.Uploads = { { &SegmentOffsets, Offsets, sizeof(Offsets), 0 } };
+		}
+		Waits = { Context.submitAsync(Job, Waits) };
+	}
+	if (!Options.bSorted)
+	{
+		LastJob = Waits.front();
+		return LastJob;
+	}
+
+	// The select keys are uints that sort best first
+	JobTicket Sorted = Waits.front();
+	if (bSmallSort)
+	{
+		SegmentedSortOptions SortOptions;
+		SortOptions.MaxSegmentLength = K;
+		Sorted = SmallSorter.sortAsync(Values, K, SegmentOffsets, 1, &Indices, SortOptions, Waits);
+	}
+	else
+	{
+		if (!LargeSorter)
+		{
+			LargeSorter.reset(new RadixSorter(Context));
+		}
+		Sorted = LargeSorter->sortAsync(Values, K, RadixKeyType::Uint32, &Indices, ScanAlgorithm::Auto, Waits);
+	}
+	ComputeJob Restore = makeJob(kernels::TopKMode::Restore, 0, 0);
+	Restore.ElementCount = K;
+	Restore.GroupSize = 0;
+	LastJob = Context.submitAsync(Restore, { Sorted });
+	return LastJob;
+}
+
+template <typename T>
+TopKResult<T> TopKSelector::select(const ComputeBuffer& Input, uint64_t NumElements, uint32_t K, const TopKOptions& Options)
+{
+	if (K == 0 || K > NumElements)
+	{
+		throw std::invalid_argument("top-k selections take 1 to NumElements elements");
+	}
+	ensureBuffer(ResultValues, vk::DeviceSize(K) * sizeof(T));
+	ensureBuffer(ResultIndices, vk::DeviceSize(K) * sizeof(uint32_t));
+	selectAsync(Input, NumElements, TopKTypeOf<T>::Value, K, ResultValues, ResultIndices, Options).wait();
+	TopKResult<T> Result;
+	Result.Values.resize(K);
+	Result.Indices.resize(K);
+	Context.readBuffer(ResultValues, Result.Values.data(), vk::DeviceSize(K) * sizeof(T));
+	Context.readBuffer(ResultIndices, Result.Indices.data(), vk::DeviceSize(K) * sizeof(uint32_t));
+	return Result;
+}
+
+template TopKResult<uint32_t> TopKSelector::select<uint32_t>(const ComputeBuffer&, uint64_t, uint32_t, const TopKOptions&);
+template TopKResult<int32_t> TopKSelector::select<int32_t>(const ComputeBuffer&, uint64_t, uint32_t, const TopKOptions&);
+template TopKResult<float> TopKSelector::select<float>(const ComputeBuffer&, uint64_t, uint32_t, const TopKOptions&);
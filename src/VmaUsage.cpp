@@ -0,0 +1,5 @@
+// The only translation unit that compiles the Vulkan Memory Allocator implementation
+#include <vulkan/vulkan.hpp>
+
+#define VMA_IMPLEMENTATION
+#include "vk_mem_alloc.h"
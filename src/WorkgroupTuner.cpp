@@ -0,0 +1,122 @@
+#include "WorkgroupTuner.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "ComputeContext.h"
+
+WorkgroupSizeCache::WorkgroupSizeCache(std::string InFilePath)
+	: FilePath(std::move(InFilePath))
+{
+	std::ifstream CacheFile{ FilePath };
+	std::string Line;
+	while (std::getline(CacheFile, Line))
+	{
+		std::istringstream Fields{ Line };
+		std::string Device, Kernel;
+		uint32_t Bucket = 0, GroupSize = 0;
+		if (Fields >> Device >> Kernel >> Bucket >> GroupSize && GroupSize > 0)
+		{
+			Entries[Device + " " + Kernel + " " + std::to_string(Bucket)] = GroupSize;
+		}
+	}
+}
+
+void WorkgroupSizeCache::setDevice(const vk::PhysicalDeviceProperties& DeviceProps)
+{
+	std::ostringstream Key;
+	Key << std::hex << DeviceProps.vendorID << ":" << DeviceProps.deviceID << ":" << DeviceProps.driverVersion;
+	DeviceKey = Key.str();
+}
+
+uint32_t WorkgroupSizeCache::bucketOf(uint64_t ElementCount)
+{
+	uint32_t Bucket = 0;
+	while (ElementCount > 1)
+	{
+		ElementCount >>= 1;
+		++Bucket;
+	}
+	return Bucket;
+}
+
+std::string WorkgroupSizeCache::makeKey(const std::string& KernelName, uint64_t ElementCount) const
+{
+	return DeviceKey + " " + KernelName + " " + std::to_string(bucketOf(ElementCount));
+}
+
+uint32_t WorkgroupSizeCache::find(const std::string& KernelName, uint64_t ElementCount) const
+{
+	auto EntryIt = Entries.find(makeKey(KernelName, ElementCount));
+	return EntryIt != Entries.end() ? EntryIt->second : 0;
+}
+
+void WorkgroupSizeCache::store(const std::string& KernelName, uint64_t ElementCount, uint32_t GroupSize)
+{
+	Entries[makeKey(KernelName, ElementCount)] = GroupSize;
+}
+
+void WorkgroupSizeCache::save() const
+{
+	const std::filesystem::path CachePath{ FilePath };
+	if (CachePath.has_parent_path())
+	{
+		std::filesystem::create_directories(CachePath.parent_path());
+	}
+	std::ofstream CacheFile{ FilePath, std::ios::trunc };
+	for (const auto& Entry : Entries)
+	{
+		CacheFile << Entry.first << " " << Entry.second << "\n";
+	}
+}
+
+WorkgroupTuner::WorkgroupTuner(ComputeContext& InContext)
+	: Context(InContext)
+{
+}
+
+std::vector<uint32_t> WorkgroupTuner::candidateSizes() const
+{
+	const vk::PhysicalDeviceLimits& Limits = Context.getDeviceProperties().limits;
+	const uint32_t MaxSize = std::min(Limits.maxComputeWorkGroupInvocations, Limits.maxComputeWorkGroupSize[0]);
+	std::vector<uint32_t> Sizes;
+	for (uint32_t Size = 8; Size <= MaxSize; Size *= 2)
+	{
+		Sizes.push_back(Size);
+	}
+	return Sizes;
+}
+
+uint32_t WorkgroupTuner::tune(const ComputeJob& Job, uint32_t Iterations)
+{
+	if (!Job.Kernel || !Job.Kernel->isGroupSizeTunable() || Job.ElementCount == 0)
+	{
+		throw std::invalid_argument("tuning needs a tunable kernel and an element count");
+	}
+
+	LastSweep.clear();
+	ComputeJob Candidate = Job;
+	uint32_t BestSize = 0;
+	double BestTime = 0.0;
+	for (uint32_t Size : candidateSizes())
+	{
+		Candidate.GroupSize = Size;
+		// Warm up, this also creates the pipeline variant outside of the measurement
+		Context.timeJob(Candidate, 1);
+		const double Time = Context.timeJob(Candidate, Iterations);
+		LastSweep.emplace_back(Size, Time);
+		if (BestSize == 0 || Time < BestTime)
+		{
+			BestSize = Size;
+			BestTime = Time;
+		}
+	}
+
+	WorkgroupSizeCache& Cache = Context.getGroupSizeCache();
+	Cache.store(Job.Kernel->Desc.Name, Job.ElementCount, BestSize);
+	Cache.save();
+	return BestSize;
+}
@@ -29,17 +29,47 @@ add_links("glfw3", "vulkan-1")
 add_syslinks("user32", "gdi32", "shell32")
 
 
+-- 编译计算着色器: .comp 使用 glslc, .hlsl 使用 dxc, 在源文件旁边输出 <name>.spv
+rule("spirv")
+    set_extensions(".comp", ".hlsl")
+    on_build_file(function (target, sourcefile, opt)
+        import("core.project.depend")
+        local spvfile = path.join(path.directory(sourcefile), path.basename(sourcefile) .. ".spv")
+        depend.on_changed(function ()
+            if path.extension(sourcefile) == ".hlsl" then
+                os.vrunv(path.join(vulkan_sdk_path, "Bin", "dxc.exe"),
+                    {"-spirv", "-T", "cs_6_0", "-E", "main", "-fspv-target-env=vulkan1.1", "-Fo", spvfile, sourcefile})
+            else
+                os.vrunv(path.join(vulkan_sdk_path, "Bin", "glslc.exe"),
+                    {"--target-env=vulkan1.1", "-o", spvfile, sourcefile})
+            end
+        end, {files = table.join(sourcefile, os.files("shaders/*.glsl")), dependfile = target:dependfile(spvfile)})
+    end)
+
 -- 添加目标
 target("shaders")
-    set_kind("phony")
-    -- -- 对 .vert 和 .frag 文件应用 glsl_shader 规则
-    -- add_files("shaders/*.vert", "shaders/*.frag", {rules = "glsl_shader"})    
+    set_kind("object")
+    add_rules("spirv")
+    add_files("shaders/compute.comp", "shaders/Square.hlsl", "shaders/elementwise_vec4.comp",
+        "shaders/reduce_u32.comp", "shaders/reduce_i32.comp", "shaders/reduce_f32.comp", "shaders/reduce_f64.comp",
+        "shaders/scan.comp", "shaders/radix_sort.comp", "shaders/histogram.comp", "shaders/compact.comp", "shaders/gemm.comp",
+        "shaders/spmv.comp", "shaders/sell_convert.comp", "shaders/stencil.comp",
+        "shaders/fft_shared.comp", "shaders/fft_pass.comp", "shaders/segmented_sort.comp", "shaders/merge.comp",
+        "shaders/transpose.comp", "shaders/layout_convert.comp",
+        "shaders/top_k.comp", "shaders/hash_table_u32.comp", "shaders/hash_table_u64.comp", "shaders/group_by.comp")
+
+-- 计算框架库: ComputeContext 以及 VMA 的实现
+target("compute")
+    set_kind("static")
+    add_files("src/*.cpp|main.cpp|mainhpp.cpp")
+    add_includedirs("include", {public = true})
+    set_languages("c++17")
 
 target("hello")
     set_kind("binary")
     -- 添加依赖，确保在编译主程序之前先编译 shaders 目标
-    -- add_deps("shaders")
-    add_files("src/*.cpp") -- 添加源文件
+    add_deps("shaders", "compute")
+    add_files("src/main.cpp", "src/mainhpp.cpp") -- 添加源文件
     --add_files("include/*.hpp") -- 显式添加头文件
     add_includedirs("include")
     set_languages("c++17") -- 设置C++17标准    
@@ -55,6 +85,18 @@ target("hello")
         set_strip("all")
     end
 
+-- 基准测试程序, 每个 bench/<Name>.cpp 一个可执行文件
+for _, name in ipairs({"ContextBench", "TuneBench", "BufferPlacementBench", "StreamBench", "PipelineCacheBench", "ElementwiseBench", "ReduceBench", "ScanBench", "RadixSortBench", "HistogramBench", "CompactBench", "GemmBench", "SpmvBench", "StencilBench", "FftBench", "SegmentedSortBench", "LayoutBench", "TopKBench", "HashTableBench", "GroupByBench"}) do
+    target(name)
+        set_kind("binary")
+        add_deps("shaders", "compute")
+        add_files("bench/" .. name .. ".cpp")
+        set_languages("c++17")
+        set_rundir("./")
+        set_optimize("fastest")
+    target_end()
+end
+
 -- target("hello")
 
 --     -- 设置语言为 C++